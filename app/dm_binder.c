@@ -3,41 +3,226 @@
  * @brief Application Binder implementation.
  *
  * Overrides the weak command handler stubs from dm_protocol.c.
- * Calls into ui_pages for actual LVGL operations.
+ * Calls into ui_pages for actual LVGL operations.  Payload lengths are
+ * checked by the dispatch table before a handler runs.
+ *
+ * With DM_UI_SPLIT the handlers run on the protocol core: each command is
+ * checked against the layout shape kept below, acknowledged at once and
+ * queued for the LVGL core (dm_ui_queue.h).  A page that then fails to
+ * build (LVGL heap exhausted) leaves the previous one on screen.
  *
  * Payload conventions (host → device):
  *
  *   CMD_SHOW_PAGE    [1 byte]  page_id
- *   CMD_SET_TEXT     [1 byte widget_idx] [N bytes null-terminated string]
+ *   CMD_SET_TEXT     [1 byte widget_idx] [N bytes UTF-8 text, no terminator]
  *   CMD_SET_VALUE    [1 byte widget_idx] [2 bytes int16 big-endian]
  *   CMD_SET_VISIBLE  [1 byte widget_idx] [1 byte 0=hide 1=show]
  *   CMD_SET_ENABLED  [1 byte widget_idx] [1 byte 0=disable 1=enable]
+ *   CMD_SET_VALUES   [1 byte first widget_idx] [1 byte DM_VALUES_* mode]
+ *                    [N × int16 big-endian values | N × int8 deltas]
+ *   CMD_DEFINE_STRING [1 byte string_id] [N bytes UTF-8 text; none = delete]
+ *   CMD_SET_TEXT_ID  [1 byte widget_idx] [1 byte string_id]
+ *   CMD_GET_STATE_HASH (empty) → EVT_ACK [4 bytes hash big-endian] [1 byte DM_STATE_* flags]
+ *   CMD_LAYOUT_WRITE [2 bytes offset big-endian] [N bytes layout data]
+ *   CMD_LAYOUT_APPLY [2 bytes total length big-endian]
  */
 #include "dm_binder.h"
 #include "dm_protocol.h"
 #include "dm_packet.h"
 #include "ui/ui_pages.h"
+#include "ui/ui_layout.h"
+#include "dm_resources.h"
+#include "dm_strings.h"
+#include "dm_snapshot.h"
+#include "dm_ui_queue.h"
+#include "dm_bulk.h"
 #include "dm_config.h"
 
+#include <stdbool.h>
 #include <string.h>
 
-static dm_platform_t *s_plat = NULL;
+#if DM_LAYOUT_MAX_SIZE > 0
+/*
+ * Uploads are written to the staging buffer; ui_pages builds from the
+ * live one in place.  A successful CMD_LAYOUT_APPLY swaps them, so the
+ * layout on screen is never touched by an upload that may still fail.
+ */
+static uint8_t s_layout_buf[2][DM_LAYOUT_MAX_SIZE];
+static uint8_t s_layout_stage = 0;   /* Index of the staging buffer */
+#endif
+
+/* ── UI access ──────────────────────────────────────────────────────────── */
+
+#if DM_UI_SPLIT
+/*
+ * Shape of the layout the LVGL core shows (or is about to show), so the
+ * protocol core can answer every command without waiting for it.
+ */
+static uint8_t s_page_count = 0;
+static uint8_t s_widget_count = 0;
+static uint8_t s_widget_type[DM_MAX_WIDGETS];
+
+static void shape_load(const uint8_t *blob)
+{
+    s_page_count   = blob[UI_LAYOUT_OFF_PAGES];
+    s_widget_count = blob[UI_LAYOUT_OFF_WIDGETS];
+    const uint8_t *rec = blob + UI_LAYOUT_HEADER_SIZE + s_page_count;
+    for (uint8_t i = 0; i < s_widget_count; i++, rec += UI_LAYOUT_RECORD_SIZE) {
+        s_widget_type[i] = rec[UI_LAYOUT_REC_TYPE];
+    }
+}
+
+static bool widget_is(uint8_t idx, uint8_t type_a, uint8_t type_b)
+{
+    return idx < s_widget_count &&
+           (s_widget_type[idx] == type_a || s_widget_type[idx] == type_b);
+}
+
+static void post(uint8_t op, uint8_t idx, int16_t value)
+{
+    dm_uiq_cmd_t cmd = { .op = op, .idx = idx, .value = value };
+    dm_uiq_post(&cmd);
+}
+#endif
+
+/* The ui_pages calls below, answered the same way in both modes. */
+
+static bool ui_show(uint8_t page_id)
+{
+#if DM_UI_SPLIT
+    if (page_id >= s_page_count) return false;
+    post(DM_UIQ_SHOW_PAGE, page_id, 0);
+    return true;
+#else
+    return ui_pages_show(page_id);
+#endif
+}
+
+static bool ui_set_text(uint8_t idx, const uint8_t *text, uint16_t len)
+{
+#if DM_UI_SPLIT
+    if (!widget_is(idx, UI_LAYOUT_TYPE_LABEL, UI_LAYOUT_TYPE_BUTTON)) return false;
+    dm_uiq_cmd_t cmd = { .op = DM_UIQ_SET_TEXT, .idx = idx };
+    cmd.len = len < DM_MAX_TEXT_LEN - 1 ? len : DM_MAX_TEXT_LEN - 1;
+    memcpy(cmd.text, text, cmd.len);
+    dm_uiq_post(&cmd);
+    return true;
+#else
+    /* Straight from the RX buffer: ui_pages truncates and terminates. */
+    return ui_pages_set_text_n(idx, (const char *)text, len);
+#endif
+}
+
+static bool ui_set_value(uint8_t idx, int16_t value)
+{
+#if DM_UI_SPLIT
+    if (!widget_is(idx, UI_LAYOUT_TYPE_SLIDER, UI_LAYOUT_TYPE_IMAGE)) return false;
+    post(DM_UIQ_SET_VALUE, idx, value);
+    return true;
+#else
+    return ui_pages_set_value(idx, value);
+#endif
+}
+
+/* Entry @p i of a CMD_SET_VALUES run. */
+static int16_t run_value(const uint8_t *data, uint16_t i, bool delta)
+{
+    if (delta) return (int8_t)data[i];
+    return (int16_t)(((uint16_t)data[2 * i] << 8) | data[2 * i + 1]);
+}
+
+static bool ui_set_values(uint8_t first, const uint8_t *data, uint16_t count, bool delta)
+{
+#if DM_UI_SPLIT
+    if ((uint32_t)first + count > s_widget_count) return false;
+    /* Decoded here, queued in as few records as fit. */
+    for (uint16_t done = 0; done < count; ) {
+        dm_uiq_cmd_t cmd = { .op  = delta ? DM_UIQ_ADD_VALUES : DM_UIQ_SET_VALUES,
+                             .idx = (uint8_t)(first + done) };
+        uint16_t n = count - done;
+        if (n > DM_UIQ_MAX_VALUES) n = DM_UIQ_MAX_VALUES;
+        for (uint16_t i = 0; i < n; i++) cmd.values[i] = run_value(data, done + i, delta);
+        cmd.len = n;
+        dm_uiq_post(&cmd);
+        done += n;
+    }
+    return true;
+#else
+    if ((uint32_t)first + count > ui_pages_widget_count()) return false;
+    /* Widgets without a value (labels, panels…) are skipped. */
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t idx = (uint8_t)(first + i);
+        if (delta) ui_pages_add_value(idx, run_value(data, i, true));
+        else       ui_pages_set_value(idx, run_value(data, i, false));
+    }
+    return true;
+#endif
+}
+
+static void ui_set_visible(uint8_t idx, bool visible)
+{
+#if DM_UI_SPLIT
+    if (idx < s_widget_count) post(DM_UIQ_SET_VISIBLE, idx, visible);
+#else
+    ui_pages_set_visible(idx, visible);
+#endif
+}
+
+static void ui_set_enabled(uint8_t idx, bool enabled)
+{
+#if DM_UI_SPLIT
+    if (idx < s_widget_count) post(DM_UIQ_SET_ENABLED, idx, enabled);
+#else
+    ui_pages_set_enabled(idx, enabled);
+#endif
+}
+
+static uint32_t ui_state_hash(uint8_t *flags)
+{
+#if DM_UI_SPLIT
+    return dm_uiq_state_hash(flags);
+#else
+    return dm_snapshot_state_hash(flags);
+#endif
+}
+
+#if DM_LAYOUT_MAX_SIZE > 0
+static bool ui_load(const uint8_t *blob, uint16_t size)
+{
+#if DM_UI_SPLIT
+    if (!ui_pages_layout_valid(blob, size)) return false;
+    shape_load(blob);
+    dm_uiq_cmd_t cmd = { .op = DM_UIQ_LOAD_LAYOUT, .len = size, .blob = blob };
+    dm_uiq_post(&cmd);
+    return true;
+#else
+    return ui_pages_load_layout(blob, size);
+#endif
+}
+#endif
 
 /* ── Init ───────────────────────────────────────────────────────────────── */
 
-void dm_binder_init(dm_platform_t *plat)
+void dm_binder_init(void)
 {
-    s_plat = plat;
+    dm_resources_init();
+    dm_strings_init();
+    dm_bulk_set_store(dm_resources_store());
+#if DM_UI_SPLIT
+    dm_uiq_init();
+    shape_load(ui_layout_default);
+#endif
     ui_pages_init();
+    dm_snapshot_init();   /* Restores the last state before the first frame */
 }
 
 /* ── Handler overrides ──────────────────────────────────────────────────── */
 
-void dm_handle_show_page(uint8_t seq, const uint8_t *p, uint8_t len, const dm_platform_t *plat)
+void dm_handle_show_page(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
 {
-    if (len < 1) { dm_packet_send_nack(seq, plat); return; }
+    (void)len;
     uint8_t page_id = p[0];
-    if (ui_pages_show(page_id)) {
+    if (ui_show(page_id)) {
         dm_packet_send_ack(seq, plat, NULL, 0);
         dm_packet_send_page_changed(page_id, plat);
     } else {
@@ -45,48 +230,125 @@ void dm_handle_show_page(uint8_t seq, const uint8_t *p, uint8_t len, const dm_pl
     }
 }
 
-void dm_handle_set_text(uint8_t seq, const uint8_t *p, uint8_t len, const dm_platform_t *plat)
+void dm_handle_set_text(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
 {
-    if (len < 2) { dm_packet_send_nack(seq, plat); return; }
     uint8_t widget_idx = p[0];
 
-    /* Copy text with guaranteed null-termination */
-    char text[DM_MAX_TEXT_LEN];
-    uint8_t text_len = len - 1;
-    if (text_len >= DM_MAX_TEXT_LEN) text_len = DM_MAX_TEXT_LEN - 1;
-    memcpy(text, p + 1, text_len);
-    text[text_len] = '\0';
-
-    if (ui_pages_set_text(widget_idx, text)) {
+    if (ui_set_text(widget_idx, p + 1, len - 1)) {
         dm_packet_send_ack(seq, plat, NULL, 0);
     } else {
         dm_packet_send_nack(seq, plat);
     }
 }
 
-void dm_handle_set_value(uint8_t seq, const uint8_t *p, uint8_t len, const dm_platform_t *plat)
+void dm_handle_set_value(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
 {
-    if (len < 3) { dm_packet_send_nack(seq, plat); return; }
+    (void)len;
     uint8_t  widget_idx = p[0];
     int16_t  value      = (int16_t)(((uint16_t)p[1] << 8) | p[2]);
 
-    if (ui_pages_set_value(widget_idx, value)) {
+    if (ui_set_value(widget_idx, value)) {
+        dm_packet_send_ack(seq, plat, NULL, 0);
+    } else {
+        dm_packet_send_nack(seq, plat);
+    }
+}
+
+void dm_handle_set_values(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    uint8_t  first = p[0];
+    uint8_t  mode  = p[1];
+    uint16_t n     = len - 2;
+    bool     ok    = false;
+
+    if (mode == DM_VALUES_DELTA) {
+        ok = ui_set_values(first, p + 2, n, true);
+    } else if (mode == DM_VALUES_ABSOLUTE && n % 2 == 0) {
+        ok = ui_set_values(first, p + 2, n / 2, false);
+    }
+    if (ok) {
+        dm_packet_send_ack(seq, plat, NULL, 0);
+    } else {
+        dm_packet_send_nack(seq, plat);
+    }
+}
+
+void dm_handle_define_string(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    bool ok = len == 1 ? dm_string_delete(p[0])
+                       : dm_string_define(p[0], (const char *)p + 1, len - 1);
+    if (ok) {
+        dm_packet_send_ack(seq, plat, NULL, 0);
+    } else {
+        dm_packet_send_nack(seq, plat);
+    }
+}
+
+void dm_handle_set_text_id(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    (void)len;
+    uint16_t    n;
+    const char *text = dm_string_get(p[1], &n);
+
+    /* The same path as CMD_SET_TEXT: ui_pages interns the text. */
+    if (text && ui_set_text(p[0], (const uint8_t *)text, n)) {
         dm_packet_send_ack(seq, plat, NULL, 0);
     } else {
         dm_packet_send_nack(seq, plat);
     }
 }
 
-void dm_handle_set_visible(uint8_t seq, const uint8_t *p, uint8_t len, const dm_platform_t *plat)
+void dm_handle_get_state_hash(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
 {
-    if (len < 2) { dm_packet_send_nack(seq, plat); return; }
-    ui_pages_set_visible(p[0], p[1] != 0);
+    (void)p;
+    (void)len;
+    uint8_t  flags;
+    uint32_t hash = ui_state_hash(&flags);
+    uint8_t  out[5] = { (uint8_t)(hash >> 24), (uint8_t)(hash >> 16),
+                        (uint8_t)(hash >> 8), (uint8_t)hash, flags };
+    dm_packet_send_ack(seq, plat, out, sizeof(out));
+}
+
+void dm_handle_set_visible(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    (void)len;
+    ui_set_visible(p[0], p[1] != 0);
     dm_packet_send_ack(seq, plat, NULL, 0);
 }
 
-void dm_handle_set_enabled(uint8_t seq, const uint8_t *p, uint8_t len, const dm_platform_t *plat)
+void dm_handle_set_enabled(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
 {
-    if (len < 2) { dm_packet_send_nack(seq, plat); return; }
-    ui_pages_set_enabled(p[0], p[1] != 0);
+    (void)len;
+    ui_set_enabled(p[0], p[1] != 0);
+    dm_packet_send_ack(seq, plat, NULL, 0);
+}
+
+#if DM_LAYOUT_MAX_SIZE > 0
+void dm_handle_layout_write(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    uint16_t offset = (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+    uint16_t n      = len - 2;
+    if ((uint32_t)offset + n > DM_LAYOUT_MAX_SIZE) { dm_packet_send_nack(seq, plat); return; }
+
+    memcpy(&s_layout_buf[s_layout_stage][offset], p + 2, n);
+    dm_packet_send_ack(seq, plat, NULL, 0);
+}
+
+void dm_handle_layout_apply(uint8_t seq, const uint8_t *p, uint16_t len, const dm_platform_t *plat)
+{
+    (void)len;
+    uint16_t size = (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+
+    if (size > DM_LAYOUT_MAX_SIZE || !ui_load(s_layout_buf[s_layout_stage], size)) {
+        dm_packet_send_nack(seq, plat);
+        return;
+    }
+#if DM_UI_SPLIT
+    /* The LVGL core builds from the old live buffer until it switches. */
+    dm_uiq_sync();
+#endif
+    s_layout_stage ^= 1U;   /* The previous live buffer takes the next upload */
     dm_packet_send_ack(seq, plat, NULL, 0);
+    dm_packet_send_page_changed(0, plat);
 }
+#endif
@@ -19,11 +19,11 @@ extern "C" {
  * @brief Initialise the application binder.
  *
  * Must be called after dm_init() and after LVGL has been initialised
- * by the board layer.
- *
- * @param plat  Platform interface (same pointer passed to dm_init()).
+ * by the board layer.  Widget events go to the link selected with
+ * dm_ctx_select() (the dm_init() one by default).  With DM_UI_SPLIT,
+ * call it on the LVGL core before the protocol core is started.
  */
-void dm_binder_init(dm_platform_t *plat);
+void dm_binder_init(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,111 @@
+/**
+ * @file dm_resources.c
+ * @brief RAM arena resource store (see dm_resources.h).
+ */
+#include "dm_resources.h"
+#include "ui/ui_pages.h"
+#include "dm_ui_queue.h"
+#include "dm_config.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct {
+    bool     ready;    /* Committed and CRC-checked */
+    uint8_t  type;
+    uint32_t offset;   /* Into s_pool */
+    uint32_t size;
+    uint32_t cap;      /* Bytes reserved at offset (0 = never allocated) */
+} res_slot_t;
+
+/* Aligned for pixel data handed straight to LVGL. */
+static uint8_t    s_pool[DM_RES_POOL_SIZE] __attribute__((aligned(4)));
+static uint32_t   s_pool_used = 0;
+static res_slot_t s_res[DM_RES_MAX_COUNT];
+
+/* ── Store callbacks ─────────────────────────────────────────────────────── */
+
+/*
+ * Tell the UI that resource @p id changed.  In split mode the callbacks
+ * run on the protocol core; @p wait holds them until the LVGL core has
+ * stopped drawing the old data.
+ */
+static void resource_changed(uint8_t id, bool wait)
+{
+#if DM_UI_SPLIT
+    dm_uiq_cmd_t cmd = { .op = DM_UIQ_RESOURCE, .idx = id };
+    dm_uiq_post(&cmd);
+    if (wait) dm_uiq_sync();
+#else
+    (void)wait;
+    ui_pages_resource_changed(id);
+#endif
+}
+
+static bool res_open(uint8_t id, uint8_t type, uint32_t size)
+{
+    if (id >= DM_RES_MAX_COUNT) return false;
+    res_slot_t *r = &s_res[id];
+
+    if (size > r->cap) {
+        uint32_t off = (s_pool_used + 3U) & ~3U;
+        if (off > DM_RES_POOL_SIZE || size > DM_RES_POOL_SIZE - off) return false;
+        r->offset   = off;
+        r->cap      = size;
+        s_pool_used = off + size;
+    }
+
+    /* Unpublish first: widgets showing it must not draw half-written data. */
+    if (r->ready) {
+        r->ready = false;
+        resource_changed(id, true);
+    }
+    r->type = type;
+    r->size = size;
+    return true;
+}
+
+static bool res_write(uint8_t id, uint32_t offset, const uint8_t *data, uint16_t len)
+{
+    memcpy(&s_pool[s_res[id].offset + offset], data, len);
+    return true;
+}
+
+static const uint8_t *res_map(uint8_t id)
+{
+    return &s_pool[s_res[id].offset];
+}
+
+static void res_finish(uint8_t id, bool ok)
+{
+    s_res[id].ready = ok;
+    if (ok) resource_changed(id, false);
+}
+
+static const dm_bulk_store_t s_store = {
+    .open   = res_open,
+    .write  = res_write,
+    .map    = res_map,
+    .finish = res_finish,
+};
+
+/* ── Public API ───────────────────────────────────────────────────────────── */
+
+void dm_resources_init(void)
+{
+    memset(s_res, 0, sizeof(s_res));
+    s_pool_used = 0;
+}
+
+const dm_bulk_store_t *dm_resources_store(void)
+{
+    return &s_store;
+}
+
+const uint8_t *dm_resource_get(uint8_t id, uint8_t *type, uint32_t *size)
+{
+    if (id >= DM_RES_MAX_COUNT || !s_res[id].ready) return NULL;
+    if (type) *type = s_res[id].type;
+    if (size) *size = s_res[id].size;
+    return &s_pool[s_res[id].offset];
+}
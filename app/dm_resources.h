@@ -0,0 +1,47 @@
+/**
+ * @file dm_resources.h
+ * @brief RAM resource store filled by the bulk transfer channel.
+ *
+ * Resources (images, fonts, raw blobs) are addressed by a small numeric
+ * id (< DM_RES_MAX_COUNT) and live in one static arena of
+ * DM_RES_POOL_SIZE bytes.  The arena is a bump allocator: re-sending a
+ * resource reuses its space if the new one fits, otherwise it takes fresh
+ * space and the old bytes stay allocated until reset.
+ *
+ * Boards that want resources in flash register their own dm_bulk_store_t
+ * instead (dm_bulk_set_store) and provide the same lookup.
+ */
+#ifndef DM_RESOURCES_H
+#define DM_RESOURCES_H
+
+#include <stdint.h>
+#include "../core/dm_bulk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Drop all resources and reset the arena.
+ */
+void dm_resources_init(void);
+
+/**
+ * @brief Store callbacks to pass to dm_bulk_set_store().
+ */
+const dm_bulk_store_t *dm_resources_store(void);
+
+/**
+ * @brief Look up a committed resource.
+ * @param id    Resource id.
+ * @param type  Receives the DM_RES_TYPE_* (may be NULL).
+ * @param size  Receives the size in bytes (may be NULL).
+ * @return Pointer to the bytes, or NULL if @p id is not committed.
+ */
+const uint8_t *dm_resource_get(uint8_t id, uint8_t *type, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_RESOURCES_H */
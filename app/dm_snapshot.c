@@ -0,0 +1,294 @@
+/**
+ * @file dm_snapshot.c
+ * @brief Wear-levelled screen-state records in flash (see dm_snapshot.h).
+ *
+ * Record: [magic:u16 "SN"][len:u16][seq:u32][check:u32][len bytes of
+ * ui_pages_snapshot()], all big-endian, padded to the store's prog_size.
+ * check is FNV-1a over len, seq and the payload – not CRC16, whose
+ * engine (DMA sniffer, CRC unit) belongs to the parser's core.
+ */
+#include "dm_snapshot.h"
+#include "dm_protocol.h"
+#include "dm_config.h"
+#include "ui/ui_pages.h"
+
+/* LVGL is provided by the board's CMake target */
+#include "lvgl.h"
+
+#include <string.h>
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME  16777619u
+
+static void hash_emit(void *ctx, const uint8_t *data, size_t len)
+{
+    uint32_t *h = ctx;
+    for (size_t i = 0; i < len; i++) {
+        *h = (*h ^ data[i]) * FNV_PRIME;
+    }
+}
+
+static uint32_t state_hash(void)
+{
+    uint32_t h = FNV_OFFSET;
+    ui_pages_snapshot(hash_emit, &h);
+    return h;
+}
+
+#if DM_SNAPSHOT_MAX_SIZE > 0
+
+#if DM_SNAPSHOT_MAX_SIZE > 0xFFFF
+#error "DM_SNAPSHOT_MAX_SIZE must fit the record's u16 length"
+#endif
+
+#define REC_MAGIC 0x534EU   /* "SN" */
+#define REC_HDR   12
+
+static const dm_snapshot_store_t *s_store = NULL;
+static lv_timer_t *s_timer = NULL;     /* Settle timer; paused while nothing is pending */
+
+static uint8_t  s_buf[REC_HDR + DM_SNAPSHOT_MAX_SIZE];
+static uint32_t s_seq;                 /* Of the newest record */
+static uint8_t  s_sector;              /* Sector the newest record is in */
+static uint32_t s_next;                /* Free offset in it (sector_size = full) */
+static uint32_t s_saved_hash;          /* State the newest record holds */
+static bool     s_have_saved;
+static bool     s_restored;
+static bool     s_pending;
+static uint32_t s_first_change;        /* lv_tick_get() of the oldest unsaved change */
+
+static inline uint16_t rd_u16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static inline uint32_t rd_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void wr_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static inline void wr_u32(uint8_t *p, uint32_t v)
+{
+    wr_u16(p, (uint16_t)(v >> 16));
+    wr_u16(p + 2, (uint16_t)v);
+}
+
+/* A record at s_buf with @p len payload bytes: check over len, seq, payload. */
+static uint32_t rec_check(uint16_t len)
+{
+    uint32_t h = FNV_OFFSET;
+    hash_emit(&h, s_buf + 2, 6);
+    hash_emit(&h, s_buf + REC_HDR, len);
+    return h;
+}
+
+static uint32_t rec_size(uint16_t len)
+{
+    uint32_t g = s_store->prog_size ? s_store->prog_size : 1;
+    return (REC_HDR + len + g - 1) / g * g;
+}
+
+static bool erased(const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+/*
+ * Walk every sector and find the newest valid record.  A header that is
+ * neither erased nor sane ends its sector: nothing more is appended there.
+ * Returns the newest payload length (payload left in s_buf), or -1.
+ */
+static int32_t scan(void)
+{
+    const uint32_t sec_size = s_store->sector_size;
+    int32_t  best     = -1;
+    uint32_t best_at  = 0;
+
+    /* No record yet: the first write erases and fills sector 0. */
+    s_sector = (uint8_t)(s_store->sector_count - 1);
+    s_next   = sec_size;
+
+    for (uint8_t sec = 0; sec < s_store->sector_count; sec++) {
+        uint32_t base     = (uint32_t)sec * sec_size;
+        uint32_t off      = 0;
+        bool     has_best = false;
+
+        while (off + REC_HDR <= sec_size) {
+            if (!s_store->read(base + off, s_buf, REC_HDR)) { off = sec_size; break; }
+            if (erased(s_buf, REC_HDR)) break;
+
+            uint16_t len = rd_u16(s_buf + 2);
+            if (rd_u16(s_buf) != REC_MAGIC || len > DM_SNAPSHOT_MAX_SIZE ||
+                off + REC_HDR + len > sec_size) {
+                off = sec_size;
+                break;
+            }
+            uint32_t seq = rd_u32(s_buf + 4);
+            if (s_store->read(base + off + REC_HDR, s_buf + REC_HDR, len) &&
+                rd_u32(s_buf + 8) == rec_check(len) &&
+                (best < 0 || (int32_t)(seq - s_seq) > 0)) {
+                best     = len;
+                best_at  = base + off;
+                s_seq    = seq;
+                s_sector = sec;
+                has_best = true;
+            }
+            off += rec_size(len);
+        }
+        if (has_best) s_next = off < sec_size ? off : sec_size;
+    }
+
+    if (best >= 0 && !s_store->read(best_at + REC_HDR, s_buf + REC_HDR, (size_t)best)) {
+        best = -1;
+    }
+    return best;
+}
+
+typedef struct {
+    size_t   len;
+    bool     overflow;
+    uint32_t hash;
+} rec_writer_t;
+
+static void rec_emit(void *ctx, const uint8_t *data, size_t len)
+{
+    rec_writer_t *w = ctx;
+    hash_emit(&w->hash, data, len);
+    if (w->overflow || len > DM_SNAPSHOT_MAX_SIZE - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(s_buf + REC_HDR + w->len, data, len);
+    w->len += len;
+}
+
+/* Append the current state, unless flash already has it. */
+static void save(void)
+{
+    rec_writer_t w = { .hash = FNV_OFFSET };
+    ui_pages_snapshot(rec_emit, &w);
+    /* Too big to keep: flash holds the last state that fit (hash tells). */
+    if (w.overflow || (s_have_saved && w.hash == s_saved_hash)) return;
+
+    const uint32_t sec_size = s_store->sector_size;
+    uint16_t       len      = (uint16_t)w.len;
+    uint32_t       size     = rec_size(len);
+    if (size > sec_size) return;
+
+    if (s_next + size > sec_size) {
+        /* Move on; the sector holding the newest record is not touched. */
+        s_sector = (uint8_t)((s_sector + 1) % s_store->sector_count);
+        s_next   = 0;
+        if (!s_store->erase((uint32_t)s_sector * sec_size)) {
+            s_next = sec_size;
+            return;
+        }
+    }
+
+    wr_u16(s_buf, REC_MAGIC);
+    wr_u16(s_buf + 2, len);
+    wr_u32(s_buf + 4, s_seq + 1);
+    wr_u32(s_buf + 8, rec_check(len));
+    if (!s_store->program((uint32_t)s_sector * sec_size + s_next, s_buf, REC_HDR + len)) {
+        s_next = sec_size;   /* Half-programmed: start the next record afresh */
+        return;
+    }
+    s_next      += size;
+    s_seq       += 1;
+    s_saved_hash = w.hash;
+    s_have_saved = true;
+}
+
+static void settle_timer_cb(lv_timer_t *t)
+{
+    lv_timer_pause(t);
+    s_pending = false;
+    save();
+}
+
+void dm_snapshot_set_store(const dm_snapshot_store_t *store)
+{
+    s_store = store;
+}
+
+void dm_snapshot_init(void)
+{
+    s_have_saved = false;
+    s_restored   = false;
+    s_pending    = false;
+    if (!s_store || s_store->sector_count == 0) return;
+
+    /* Created before the restore, which reports its setter calls here. */
+    if (!s_timer) s_timer = lv_timer_create(settle_timer_cb, DM_SNAPSHOT_SETTLE_MS, NULL);
+    lv_timer_pause(s_timer);
+
+    int32_t len = scan();
+    if (len < 0) return;
+
+    /* What flash holds, so restoring it does not write it back. */
+    s_saved_hash = FNV_OFFSET;
+    hash_emit(&s_saved_hash, s_buf + REC_HDR, (size_t)len);
+    s_have_saved = true;
+    s_restored   = ui_pages_restore(s_buf + REC_HDR, (size_t)len);
+}
+
+void dm_snapshot_changed(void)
+{
+    if (!s_timer) return;
+    if (!s_pending) {
+        s_pending      = true;
+        s_first_change = lv_tick_get();
+    } else if (lv_tick_elaps(s_first_change) >= DM_SNAPSHOT_MAX_DELAY_MS) {
+        return;   /* Overdue: let the running period end */
+    }
+    /* Every further change restarts the settle period. */
+    lv_timer_reset(s_timer);
+    lv_timer_resume(s_timer);
+}
+
+void dm_snapshot_flush(void)
+{
+    if (!s_timer || !s_pending) return;
+    lv_timer_pause(s_timer);
+    s_pending = false;
+    save();
+}
+
+uint32_t dm_snapshot_state_hash(uint8_t *flags)
+{
+    uint32_t h = state_hash();
+    *flags = 0;
+    if (s_restored) *flags |= DM_STATE_RESTORED;
+    if (s_have_saved && h == s_saved_hash) *flags |= DM_STATE_SAVED;
+    return h;
+}
+
+#else /* DM_SNAPSHOT_MAX_SIZE == 0: hash only, nothing persisted */
+
+void dm_snapshot_set_store(const dm_snapshot_store_t *store)
+{
+    (void)store;
+}
+
+void dm_snapshot_init(void) {}
+
+void dm_snapshot_changed(void) {}
+
+void dm_snapshot_flush(void) {}
+
+uint32_t dm_snapshot_state_hash(uint8_t *flags)
+{
+    *flags = 0;
+    return state_hash();
+}
+
+#endif /* DM_SNAPSHOT_MAX_SIZE */
@@ -0,0 +1,101 @@
+/**
+ * @file dm_snapshot.h
+ * @brief Screen state kept in flash across resets (warm restore).
+ *
+ * What the host has set through ui_pages – widget text, values,
+ * visibility, the current page – is serialised by ui_pages_snapshot()
+ * and written to a flash region supplied by the board once the screen
+ * has been quiet for DM_SNAPSHOT_SETTLE_MS (DM_SNAPSHOT_MAX_DELAY_MS at
+ * the latest), unless flash already holds the same state.
+ * dm_binder_init() restores it before the first frame, so after a reset
+ * or brownout the panel shows what it showed before.
+ *
+ * Records are appended to the region's sectors in turn, each with a
+ * sequence number and a check hash.  A sector is only erased when the
+ * writer moves on to it, so erases are spread over every sector and,
+ * with two or more sectors, the newest complete record survives a power
+ * cut at any point.
+ *
+ * CMD_GET_STATE_HASH reports a 32-bit FNV-1a hash of the same serialised
+ * state: a host that remembers the hash after its last update can skip
+ * resending the screen when the device reports it again.  The string
+ * table, uploaded layouts and resources are not part of the snapshot; a
+ * snapshot taken with an uploaded layout is never restored into another.
+ *
+ * Runs wherever ui_pages runs (the LVGL core with DM_UI_SPLIT): writes
+ * are made from an LVGL timer, inside lv_timer_handler().
+ */
+#ifndef DM_SNAPSHOT_H
+#define DM_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Flash region for the snapshot, supplied by the board.
+ *
+ * Addresses are offsets into the region, which is sector_count sectors
+ * of sector_size bytes.  Erased flash must read as 0xFF.  The callbacks
+ * may block (an erase takes tens of ms); each returns false on failure.
+ */
+typedef struct {
+    uint32_t sector_size;   /**< Erase unit; must hold a whole record */
+    uint8_t  sector_count;  /**< Sectors written in turn (2+ keeps a copy during erase) */
+    uint16_t prog_size;     /**< Records start on multiples of this (program page) */
+
+    /** Read @p len bytes at @p addr. */
+    bool (*read)(uint32_t addr, void *buf, size_t len);
+
+    /** Erase the sector starting at @p addr. */
+    bool (*erase)(uint32_t addr);
+
+    /** Program @p len bytes at @p addr (prog_size aligned; pad the tail with 0xFF). */
+    bool (*program)(uint32_t addr, const void *data, size_t len);
+} dm_snapshot_store_t;
+
+/**
+ * @brief Register the flash region (NULL = nothing is persisted).
+ *
+ * Call before dm_binder_init(), which restores from it.
+ *
+ * @param store  Region and callbacks; must stay valid.
+ */
+void dm_snapshot_set_store(const dm_snapshot_store_t *store);
+
+/**
+ * @brief Find the newest record and restore it into ui_pages.
+ *
+ * Called by dm_binder_init() after ui_pages_init().
+ */
+void dm_snapshot_init(void);
+
+/**
+ * @brief Note that the host-set screen state changed (called by ui_pages).
+ */
+void dm_snapshot_changed(void);
+
+/**
+ * @brief Write a pending change now instead of when the screen settles.
+ *
+ * For the board to call before a deliberate reset or power-off.
+ */
+void dm_snapshot_flush(void);
+
+/**
+ * @brief Hash of the current host-set screen state (CMD_GET_STATE_HASH).
+ *
+ * @param flags  Receives DM_STATE_* bits.
+ * @return FNV-1a hash of the ui_pages_snapshot() bytes.
+ */
+uint32_t dm_snapshot_state_hash(uint8_t *flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_SNAPSHOT_H */
@@ -0,0 +1,99 @@
+/**
+ * @file dm_strings.c
+ * @brief Compacted string table arena (see dm_strings.h).
+ */
+#include "dm_strings.h"
+#include "dm_config.h"
+
+#include <string.h>
+
+#if DM_MAX_STRINGS > 0
+
+#if DM_STRING_TABLE_SIZE > 0xFFFF
+#error "DM_STRING_TABLE_SIZE must fit a u16 offset"
+#endif
+
+typedef struct {
+    bool     defined;
+    uint16_t offset;   /* Into s_arena */
+    uint16_t len;
+} str_slot_t;
+
+/* Strings are packed in definition order with no gaps. */
+static char       s_arena[DM_STRING_TABLE_SIZE];
+static uint16_t   s_used = 0;
+static str_slot_t s_str[DM_MAX_STRINGS];
+
+void dm_strings_init(void)
+{
+    s_used = 0;
+    memset(s_str, 0, sizeof(s_str));
+}
+
+bool dm_string_delete(uint8_t id)
+{
+    if (id >= DM_MAX_STRINGS) return false;
+    if (!s_str[id].defined) return true;
+    str_slot_t *s   = &s_str[id];
+    uint16_t    end = (uint16_t)(s->offset + s->len);
+
+    /* Close the gap: later strings move down by len. */
+    memmove(&s_arena[s->offset], &s_arena[end], s_used - end);
+    for (uint8_t i = 0; i < DM_MAX_STRINGS; i++) {
+        if (s_str[i].defined && s_str[i].offset >= end) s_str[i].offset -= s->len;
+    }
+    s_used -= s->len;
+    s->defined = false;
+    return true;
+}
+
+bool dm_string_define(uint8_t id, const char *text, size_t len)
+{
+    if (id >= DM_MAX_STRINGS) return false;
+
+    if (len > DM_MAX_TEXT_LEN - 1) len = DM_MAX_TEXT_LEN - 1;
+    const char *nul = memchr(text, '\0', len);
+    if (nul) len = (size_t)(nul - text);
+
+    uint16_t old = s_str[id].defined ? s_str[id].len : 0;
+    if (s_used - old + len > DM_STRING_TABLE_SIZE) return false;
+
+    dm_string_delete(id);
+    memcpy(&s_arena[s_used], text, len);
+    s_str[id].defined = true;
+    s_str[id].offset  = s_used;
+    s_str[id].len     = (uint16_t)len;
+    s_used += (uint16_t)len;
+    return true;
+}
+
+const char *dm_string_get(uint8_t id, uint16_t *len)
+{
+    if (id >= DM_MAX_STRINGS || !s_str[id].defined) return NULL;
+    *len = s_str[id].len;
+    return &s_arena[s_str[id].offset];
+}
+
+#else /* DM_MAX_STRINGS == 0 */
+
+void dm_strings_init(void) {}
+
+bool dm_string_define(uint8_t id, const char *text, size_t len)
+{
+    (void)id; (void)text; (void)len;
+    return false;
+}
+
+bool dm_string_delete(uint8_t id)
+{
+    (void)id;
+    return false;
+}
+
+const char *dm_string_get(uint8_t id, uint16_t *len)
+{
+    (void)id; (void)len;
+    return NULL;
+}
+
+#endif /* DM_MAX_STRINGS */
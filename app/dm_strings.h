@@ -0,0 +1,64 @@
+/**
+ * @file dm_strings.h
+ * @brief Host-defined string table for CMD_SET_TEXT_ID.
+ *
+ * The host preloads the strings it shows often (status messages, units)
+ * once with CMD_DEFINE_STRING and then sets a label with a 1-byte id
+ * instead of resending the text.  Strings live in one DM_STRING_TABLE_SIZE
+ * byte arena, kept compact on redefinition, and are not NUL-terminated.
+ *
+ * The table only feeds ui_pages' setters: a label keeps the text its id
+ * had when it was set, so redefining a string does not touch the screen.
+ * With DM_UI_SPLIT it is used on the protocol core only.
+ */
+#ifndef DM_STRINGS_H
+#define DM_STRINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Forget every string.
+ */
+void dm_strings_init(void);
+
+/**
+ * @brief Define (or redefine) string @p id.
+ *
+ * Text is cut at DM_MAX_TEXT_LEN - 1 bytes or at an embedded NUL, like
+ * ui_pages_set_text_n().
+ *
+ * @param id    String id (< DM_MAX_STRINGS).
+ * @param text  UTF-8 bytes (not necessarily null-terminated).
+ * @param len   Number of bytes at @p text.
+ * @return false if @p id is out of range or the arena is full (the old
+ *         definition is kept).
+ */
+bool dm_string_define(uint8_t id, const char *text, size_t len);
+
+/**
+ * @brief Remove string @p id (no-op if it is not defined).
+ * @param id  String id.
+ * @return false if @p id is out of range.
+ */
+bool dm_string_delete(uint8_t id);
+
+/**
+ * @brief Look up a defined string.
+ * @param id   String id.
+ * @param len  Receives the length in bytes.
+ * @return Pointer to the bytes (valid until the table next changes), or
+ *         NULL if @p id is not defined.
+ */
+const char *dm_string_get(uint8_t id, uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_STRINGS_H */
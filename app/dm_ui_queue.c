@@ -0,0 +1,194 @@
+/**
+ * @file dm_ui_queue.c
+ * @brief Dual-core command / event queues (see dm_ui_queue.h).
+ *
+ * Each ring has one producer core and one consumer core.  The producer
+ * fills a record and then publishes head with release semantics; the
+ * consumer reads head with acquire semantics, uses the record, and
+ * publishes tail the same way.
+ */
+#include "dm_ui_queue.h"
+
+#if DM_UI_SPLIT
+
+#include "ui/ui_pages.h"
+#include "dm_snapshot.h"
+#include "dm_core.h"
+#include "dm_packet.h"
+
+#include <stddef.h>
+
+#define LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* Protocol core → LVGL core */
+static dm_uiq_cmd_t      s_cmds[DM_UI_QUEUE_DEPTH];
+static volatile uint32_t s_cmd_head;   /* Protocol core */
+static volatile uint32_t s_cmd_tail;   /* LVGL core */
+
+/* LVGL core → protocol core */
+static dm_uiq_evt_t      s_evts[DM_UI_EVENT_DEPTH];
+static volatile uint32_t s_evt_head;   /* LVGL core */
+static volatile uint32_t s_evt_tail;   /* Protocol core */
+
+/* DM_UIQ_STATE_HASH answer, published with its slot's tail */
+static uint32_t s_state_hash;
+static uint8_t  s_state_flags;
+
+static void (*s_wake)(void) = NULL;
+static void (*s_event_wake)(void) = NULL;
+
+void dm_uiq_init(void)
+{
+    s_cmd_head = s_cmd_tail = 0;
+    s_evt_head = s_evt_tail = 0;
+}
+
+void dm_uiq_set_wake(void (*wake)(void))
+{
+    s_wake = wake;
+}
+
+void dm_uiq_set_event_wake(void (*wake)(void))
+{
+    s_event_wake = wake;
+}
+
+/* ── Protocol core ──────────────────────────────────────────────────────── */
+
+void dm_uiq_post(const dm_uiq_cmd_t *cmd)
+{
+    uint32_t head = s_cmd_head;
+
+    /* Full: the LVGL core frees a slot at its next dm_uiq_apply(). */
+    if (head - LOAD_ACQUIRE(&s_cmd_tail) >= DM_UI_QUEUE_DEPTH) {
+        if (s_wake) s_wake();
+        while (head - LOAD_ACQUIRE(&s_cmd_tail) >= DM_UI_QUEUE_DEPTH) {}
+    }
+    s_cmds[head & (DM_UI_QUEUE_DEPTH - 1)] = *cmd;
+    STORE_RELEASE(&s_cmd_head, head + 1);
+    if (s_wake) s_wake();
+}
+
+void dm_uiq_sync(void)
+{
+    uint32_t head = s_cmd_head;
+    while (LOAD_ACQUIRE(&s_cmd_tail) != head) {}
+}
+
+uint32_t dm_uiq_state_hash(uint8_t *flags)
+{
+    dm_uiq_cmd_t cmd = { .op = DM_UIQ_STATE_HASH };
+    dm_uiq_post(&cmd);
+    dm_uiq_sync();
+    *flags = s_state_flags;
+    return s_state_hash;
+}
+
+void dm_uiq_poll_events(void)
+{
+    uint32_t tail = s_evt_tail;
+    uint32_t head = LOAD_ACQUIRE(&s_evt_head);
+    const dm_platform_t *plat = dm_current_platform();
+
+    for (; tail != head; tail++) {
+        const dm_uiq_evt_t *e = &s_evts[tail & (DM_UI_EVENT_DEPTH - 1)];
+        switch (e->op) {
+        case DM_UIQ_EVT_BUTTON:
+            if (plat) dm_packet_send_button_pressed(e->idx, plat);
+            break;
+        case DM_UIQ_EVT_SLIDER_CHANGED:
+            if (plat) dm_packet_send_slider_changed(e->idx, e->value, plat);
+            break;
+        case DM_UIQ_EVT_SLIDER_SETTLED:
+            if (plat) dm_packet_send_slider_settled(e->idx, e->value, plat);
+            break;
+        case DM_UIQ_EVT_RENDER:
+            dm_render_span(e->t0, e->t1);
+            break;
+        default:
+            break;
+        }
+    }
+    STORE_RELEASE(&s_evt_tail, tail);
+}
+
+/* ── LVGL core ─────────────────────────────────────────────────────────── */
+
+void dm_uiq_apply(void)
+{
+    uint32_t tail = s_cmd_tail;
+    uint32_t head = LOAD_ACQUIRE(&s_cmd_head);
+
+    for (; tail != head; tail++) {
+        const dm_uiq_cmd_t *c = &s_cmds[tail & (DM_UI_QUEUE_DEPTH - 1)];
+        switch (c->op) {
+        case DM_UIQ_SHOW_PAGE:
+            ui_pages_show(c->idx);
+            break;
+        case DM_UIQ_SET_TEXT:
+            ui_pages_set_text_n(c->idx, c->text, c->len);
+            break;
+        case DM_UIQ_SET_VALUE:
+            ui_pages_set_value(c->idx, c->value);
+            break;
+        case DM_UIQ_SET_VISIBLE:
+            ui_pages_set_visible(c->idx, c->value != 0);
+            break;
+        case DM_UIQ_SET_ENABLED:
+            ui_pages_set_enabled(c->idx, c->value != 0);
+            break;
+        case DM_UIQ_LOAD_LAYOUT:
+            ui_pages_use_layout(c->blob);
+            break;
+        case DM_UIQ_RESOURCE:
+            ui_pages_resource_changed(c->idx);
+            break;
+        case DM_UIQ_SET_VALUES:
+        case DM_UIQ_ADD_VALUES:
+            /* Widgets without a value (labels, panels…) are skipped. */
+            for (uint16_t i = 0; i < c->len; i++) {
+                uint8_t idx = (uint8_t)(c->idx + i);
+                if (c->op == DM_UIQ_SET_VALUES) ui_pages_set_value(idx, c->values[i]);
+                else                            ui_pages_add_value(idx, c->values[i]);
+            }
+            break;
+        case DM_UIQ_STATE_HASH:
+            s_state_hash = dm_snapshot_state_hash(&s_state_flags);
+            break;
+        default:
+            break;
+        }
+        /* Release each slot as soon as it is done: dm_uiq_sync() waits on it. */
+        STORE_RELEASE(&s_cmd_tail, tail + 1);
+    }
+}
+
+static bool push_event(const dm_uiq_evt_t *evt)
+{
+    uint32_t head = s_evt_head;
+    if (head - LOAD_ACQUIRE(&s_evt_tail) >= DM_UI_EVENT_DEPTH) return false;
+    s_evts[head & (DM_UI_EVENT_DEPTH - 1)] = *evt;
+    STORE_RELEASE(&s_evt_head, head + 1);
+    return true;
+}
+
+bool dm_uiq_post_event(const dm_uiq_evt_t *evt)
+{
+    if (!push_event(evt)) return false;
+    if (s_event_wake) s_event_wake();
+    return true;
+}
+
+void dm_uiq_render_time(uint32_t start_us)
+{
+    dm_uiq_evt_t e = { .op = DM_UIQ_EVT_RENDER, .t0 = start_us, .t1 = dm_micros() };
+    push_event(&e);
+
+    /* Statistics only: wake the protocol core before they crowd out events. */
+    if (s_event_wake && s_evt_head - LOAD_ACQUIRE(&s_evt_tail) >= DM_UI_EVENT_DEPTH / 2) {
+        s_event_wake();
+    }
+}
+
+#endif /* DM_UI_SPLIT */
@@ -0,0 +1,192 @@
+/**
+ * @file dm_ui_queue.h
+ * @brief Protocol core ↔ LVGL core hand-off for the dual-core split.
+ *
+ * With DM_UI_SPLIT the protocol (RX, parsing, ACKs) runs on one core and
+ * LVGL on the other, so ACK latency no longer depends on render time.
+ * The binder validates and acknowledges each widget command at once on
+ * the protocol core and queues it here; the LVGL core applies the queue
+ * with dm_uiq_apply() before each lv_timer_handler().  Button and slider
+ * events (and render times) travel the other way and go out from
+ * dm_uiq_poll_events() on the protocol core.  ui_pages and LVGL are only
+ * ever touched by the LVGL core.
+ *
+ * Both directions are single-producer / single-consumer rings of fixed
+ * records in shared RAM, published with acquire/release ordering like
+ * dm_ring.h – no locks, and no RP2040 SIO FIFO or FreeRTOS queue in the
+ * path (those are too small / take a lock).  Boards whose cores sleep
+ * between deadlines register doorbells with dm_uiq_set_wake() and
+ * dm_uiq_set_event_wake().
+ *
+ * Typical split loop:
+ *
+ *   protocol core:  dm_uiq_poll_events(); wait = dm_process(); sleep
+ *   LVGL core:      dm_uiq_apply(); t = dm_micros(); next = lv_timer_handler();
+ *                   dm_uiq_render_time(t); sleep
+ *
+ * Everything is initialised by dm_binder_init(), which (like dm_init())
+ * runs on the LVGL core before the protocol core is started.
+ */
+#ifndef DM_UI_QUEUE_H
+#define DM_UI_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DM_UI_SPLIT
+
+#if (DM_UI_QUEUE_DEPTH & (DM_UI_QUEUE_DEPTH - 1)) != 0 || \
+    (DM_UI_EVENT_DEPTH & (DM_UI_EVENT_DEPTH - 1)) != 0
+#error "DM_UI_QUEUE_DEPTH and DM_UI_EVENT_DEPTH must be powers of two"
+#endif
+
+/** Widget command kinds (protocol core → LVGL core). */
+typedef enum {
+    DM_UIQ_SHOW_PAGE,     /**< idx = page id */
+    DM_UIQ_SET_TEXT,      /**< idx, text[0..len) */
+    DM_UIQ_SET_VALUE,     /**< idx, value */
+    DM_UIQ_SET_VISIBLE,   /**< idx, value = 0/1 */
+    DM_UIQ_SET_ENABLED,   /**< idx, value = 0/1 */
+    DM_UIQ_LOAD_LAYOUT,   /**< blob, size (already checked) */
+    DM_UIQ_RESOURCE,      /**< idx = resource id published or withdrawn */
+    DM_UIQ_SET_VALUES,    /**< idx = first widget, values[0..len) */
+    DM_UIQ_ADD_VALUES,    /**< idx = first widget, deltas in values[0..len) */
+    DM_UIQ_STATE_HASH,    /**< Publish dm_snapshot_state_hash() (dm_uiq_state_hash()) */
+} dm_uiq_op_t;
+
+/** Most values one queued SET_VALUES / ADD_VALUES run carries. */
+#define DM_UIQ_MAX_VALUES (DM_MAX_TEXT_LEN / 2)
+
+/** One queued widget command. */
+typedef struct {
+    uint8_t        op;      /**< dm_uiq_op_t */
+    uint8_t        idx;     /**< Widget / page / resource id */
+    uint16_t       len;     /**< Text bytes, blob size or value count */
+    int16_t        value;
+    const uint8_t *blob;    /**< LOAD_LAYOUT source */
+    union {
+        char    text[DM_MAX_TEXT_LEN];
+        int16_t values[DM_UIQ_MAX_VALUES];
+    };
+} dm_uiq_cmd_t;
+
+/** Event kinds (LVGL core → protocol core). */
+typedef enum {
+    DM_UIQ_EVT_BUTTON,          /**< idx pressed */
+    DM_UIQ_EVT_SLIDER_CHANGED,  /**< idx dragged to value */
+    DM_UIQ_EVT_SLIDER_SETTLED,  /**< idx released at value */
+    DM_UIQ_EVT_RENDER,          /**< one lv_timer_handler() pass, t0..t1 */
+} dm_uiq_evt_op_t;
+
+/** One queued event. */
+typedef struct {
+    uint8_t  op;      /**< dm_uiq_evt_op_t */
+    uint8_t  idx;
+    int16_t  value;
+    uint32_t t0;
+    uint32_t t1;
+} dm_uiq_evt_t;
+
+/**
+ * @brief Empty both queues (called by dm_binder_init()).
+ */
+void dm_uiq_init(void);
+
+/**
+ * @brief Doorbell rung after commands are queued (NULL = none).
+ *
+ * Called on the protocol core; e.g. xTaskNotifyGive() to an LVGL task,
+ * or __sev() for a core waiting in __wfe().
+ *
+ * @param wake  Callback, or NULL.
+ */
+void dm_uiq_set_wake(void (*wake)(void));
+
+/**
+ * @brief Doorbell rung after an event is queued (NULL = none).
+ *
+ * Called on the LVGL core, so a protocol core sleeping until its next
+ * dm_process() deadline sends the event at once.
+ *
+ * @param wake  Callback, or NULL.
+ */
+void dm_uiq_set_event_wake(void (*wake)(void));
+
+/* ── Protocol core ──────────────────────────────────────────────────────── */
+
+/**
+ * @brief Queue a widget command for the LVGL core.
+ *
+ * The command is already acknowledged, so it is never dropped: when the
+ * queue is full this waits until the LVGL core has made room.
+ *
+ * @param cmd  Command (copied).
+ */
+void dm_uiq_post(const dm_uiq_cmd_t *cmd);
+
+/**
+ * @brief Wait until the LVGL core has applied every queued command.
+ *
+ * For the rare writes into memory LVGL may still be reading (a live
+ * layout buffer, a published resource): at most one render pass.
+ */
+void dm_uiq_sync(void);
+
+/**
+ * @brief dm_snapshot_state_hash() of the LVGL core, after every queued command.
+ *
+ * Queues the request and waits for it like dm_uiq_sync().
+ *
+ * @param flags  Receives DM_STATE_* bits.
+ * @return State hash.
+ */
+uint32_t dm_uiq_state_hash(uint8_t *flags);
+
+/**
+ * @brief Send the queued widget events on the current link.
+ *
+ * Call before dm_process() so slider updates still go through its rate
+ * limiting and ACK batching.
+ */
+void dm_uiq_poll_events(void);
+
+/* ── LVGL core ─────────────────────────────────────────────────────────── */
+
+/**
+ * @brief Apply every queued command to ui_pages.
+ *
+ * Call before lv_timer_handler(); the changes are drawn by that pass.
+ */
+void dm_uiq_apply(void);
+
+/**
+ * @brief Queue an event for the protocol core.
+ *
+ * Never waits (the protocol core may itself be waiting in dm_uiq_sync()).
+ *
+ * @param evt  Event (copied).
+ * @return false if the queue was full and the event was dropped.
+ */
+bool dm_uiq_post_event(const dm_uiq_evt_t *evt);
+
+/**
+ * @brief Report one render pass for the statistics.
+ *
+ * The split-mode dm_render_time(): wrap lv_timer_handler() the same way.
+ *
+ * @param start_us  dm_micros() taken before the pass.
+ */
+void dm_uiq_render_time(uint32_t start_us);
+
+#endif /* DM_UI_SPLIT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_UI_QUEUE_H */
@@ -5,19 +5,38 @@
 #include <stdint.h>
 #endif
 
-/* Use a simple configuration for the simulator */
+/*
+ * Shared LVGL configuration.  The top-level CMakeLists.txt points
+ * HMIC_LV_CONF_BOARD at the board's overlay (boards/<board>/lv_conf_board.h),
+ * which is read first: anything it defines wins over the defaults below.
+ */
+#ifdef HMIC_LV_CONF_BOARD
+#include HMIC_LV_CONF_BOARD
+#endif
+
+#ifndef LV_USE_LOG
 #define LV_USE_LOG      1
+#endif
+#ifndef LV_LOG_LEVEL
 #define LV_LOG_LEVEL    LV_LOG_LEVEL_INFO
+#endif
+#ifndef LV_LOG_PRINTF
 #define LV_LOG_PRINTF   1
+#endif
 
-#define LV_COLOR_DEPTH  32
+/* RGB565 on the embedded boards (half the flush bytes of 32-bit) */
+#ifndef LV_COLOR_DEPTH
+#define LV_COLOR_DEPTH  16
+#endif
 
-/* Disable Arm specific optimizations for simulator */
-#define LV_USE_DRAW_SW_ASM    0
-#define LV_USE_DRAW_SW_HELIUM 0
-#define LV_USE_DRAW_SW_NEON   0
+/* Assembly draw routines (LV_DRAW_SW_ASM_NEON / _HELIUM) where the core has them */
+#ifndef LV_USE_DRAW_SW_ASM
+#define LV_USE_DRAW_SW_ASM LV_DRAW_SW_ASM_NONE
+#endif
 
-#define LV_MEM_SIZE     (128 * 1024U)
+#ifndef LV_MEM_SIZE
+#define LV_MEM_SIZE     (64 * 1024U)
+#endif
 
 #define LV_USE_DISPLAY  1
 #define LV_USE_INDEV    1
@@ -28,8 +47,12 @@
 #define LV_USE_SLIDER   1
 #define LV_USE_OBJ_ID   0
 
-/* Default display resolution for simulator */
+/* Largest display resolution */
+#ifndef LV_HOR_RES_MAX
 #define LV_HOR_RES_MAX  800
+#endif
+#ifndef LV_VER_RES_MAX
 #define LV_VER_RES_MAX  480
+#endif
 
 #endif /* LV_CONF_H */
@@ -0,0 +1,76 @@
+/**
+ * @file ui_layout.h
+ * @brief Binary page layout format (see docs/protocol_spec.md §8).
+ *
+ * A layout describes every page and widget in one flat, big-endian blob
+ * that ui_pages builds from in place – from flash or from an upload
+ * buffer – without a parser or heap copies:
+ *
+ *   [header:8] [page table: page_count × u8] [widget records: 20 bytes each]
+ *   [string pool: NUL-terminated UTF-8]
+ *
+ * Widget records are stored in widget_idx order, page by page, so record
+ * N is widget_idx N.  Blobs are produced (and checked) on the host by
+ * tools/layout_tool.py; the device only repeats the bounds checks it
+ * needs to stay memory-safe.
+ */
+#ifndef UI_LAYOUT_H
+#define UI_LAYOUT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ── Header ─────────────────────────────────────────────────────────────── */
+
+#define UI_LAYOUT_MAGIC0      0x48 /**< 'H' */
+#define UI_LAYOUT_MAGIC1      0x4C /**< 'L' */
+#define UI_LAYOUT_VERSION     1
+
+#define UI_LAYOUT_OFF_MAGIC   0    /**< u8[2] "HL" */
+#define UI_LAYOUT_OFF_VERSION 2    /**< u8 */
+#define UI_LAYOUT_OFF_PAGES   3    /**< u8 page_count (1..DM_MAX_PAGES) */
+#define UI_LAYOUT_OFF_WIDGETS 4    /**< u8 widget_count (≤ DM_MAX_WIDGETS) */
+#define UI_LAYOUT_OFF_CRC     6    /**< u16 CRC16-CCITT of everything after the header */
+#define UI_LAYOUT_HEADER_SIZE 8
+
+/* ── Widget record ──────────────────────────────────────────────────────── */
+
+#define UI_LAYOUT_REC_TYPE    0    /**< u8 UI_LAYOUT_TYPE_* */
+#define UI_LAYOUT_REC_PARENT  1    /**< u8 earlier widget on the page, or NO_PARENT */
+#define UI_LAYOUT_REC_ALIGN   2    /**< u8 lv_align_t */
+#define UI_LAYOUT_REC_FLAGS   3    /**< u8 UI_LAYOUT_FLAG_* */
+#define UI_LAYOUT_REC_X       4    /**< i16 align offset */
+#define UI_LAYOUT_REC_Y       6    /**< i16 align offset */
+#define UI_LAYOUT_REC_W       8    /**< i16 width, 0 = LVGL default */
+#define UI_LAYOUT_REC_H       10   /**< i16 height, 0 = LVGL default */
+#define UI_LAYOUT_REC_VALUE   12   /**< i16 initial slider value / image resource id */
+#define UI_LAYOUT_REC_MIN     14   /**< i16 slider range */
+#define UI_LAYOUT_REC_MAX     16
+#define UI_LAYOUT_REC_TEXT    18   /**< u16 string pool offset, or NO_TEXT */
+#define UI_LAYOUT_RECORD_SIZE 20
+
+#define UI_LAYOUT_TYPE_LABEL  0
+#define UI_LAYOUT_TYPE_SLIDER 1
+#define UI_LAYOUT_TYPE_BUTTON 2
+#define UI_LAYOUT_TYPE_PANEL  3    /**< Plain container for grouping */
+#define UI_LAYOUT_TYPE_IMAGE  4    /**< Shows a bulk-transferred image resource */
+
+#define UI_LAYOUT_FLAG_HIDDEN   0x01
+#define UI_LAYOUT_FLAG_DISABLED 0x02
+#define UI_LAYOUT_FLAG_EVENTS   0x04 /**< Report clicks / slider moves to the host */
+
+#define UI_LAYOUT_NO_PARENT   0xFF   /**< Child of the page screen */
+#define UI_LAYOUT_NO_TEXT     0xFFFF
+
+/** Layout built into the firmware (app/ui/layouts/default.json). */
+extern const uint8_t  ui_layout_default[];
+extern const uint16_t ui_layout_default_size;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UI_LAYOUT_H */
@@ -0,0 +1,27 @@
+/**
+ * @file ui_layout_default.c
+ * @brief Built-in page layout (generated from app/ui/layouts/default.json).
+ *
+ * Do not edit: regenerate with
+ *   python3 tools/layout_tool.py app/ui/layouts/default.json --c-array ui_layout_default
+ */
+#include "ui_layout.h"
+
+const uint8_t ui_layout_default[] = {
+    0x48, 0x4C, 0x01, 0x02, 0x05, 0x00, 0x0E, 0xDE, 0x03, 0x02, 0x00, 0xFF,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00, 0xFF, 0x09, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64,
+    0x00, 0x15, 0x02, 0xFF, 0x05, 0x04, 0x00, 0x00, 0xFF, 0xF0, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0x29, 0x00, 0xFF,
+    0x09, 0x00, 0x00, 0x00, 0xFF, 0xD8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x64, 0x00, 0x2C, 0x01, 0xFF, 0x09, 0x04, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64,
+    0xFF, 0xFF, 0x68, 0x6D, 0x69, 0x63, 0x20, 0x44, 0x69, 0x73, 0x70, 0x6C,
+    0x61, 0x79, 0x20, 0x4D, 0x61, 0x6E, 0x61, 0x67, 0x65, 0x72, 0x00, 0x57,
+    0x61, 0x69, 0x74, 0x69, 0x6E, 0x67, 0x20, 0x66, 0x6F, 0x72, 0x20, 0x68,
+    0x6F, 0x73, 0x74, 0x2E, 0x2E, 0x2E, 0x00, 0x4F, 0x4B, 0x00, 0x41, 0x64,
+    0x6A, 0x75, 0x73, 0x74, 0x20, 0x76, 0x61, 0x6C, 0x75, 0x65, 0x3A, 0x00,
+};
+
+const uint16_t ui_layout_default_size = sizeof(ui_layout_default);
@@ -2,207 +2,929 @@
  * @file ui_pages.c
  * @brief LVGL UI page implementation.
  *
- * This file creates two demo pages:
+ * Pages and widgets come from a binary layout (ui_layout.h), built in
+ * place by one table-driven builder.  The built-in layout
+ * (app/ui/layouts/default.json) has two demo pages:
  *   Page 0: Home    – title label (idx 0), status label (idx 1), OK button (idx 2)
  *   Page 1: Slider demo – label (idx 3), slider (idx 4)
  *
- * Extend this file to add more pages.  Widget callbacks emit protocol
- * events back to the host via dm_packet helpers.
+ * Edit the JSON and regenerate ui_layout_default.c to change them, or
+ * load another layout at runtime with ui_pages_load_layout().  Widget
+ * callbacks emit protocol events back to the host via dm_packet helpers.
+ *
+ * Pages are built lazily on their first ui_pages_show().  Each page owns a
+ * fixed range of widget indices (from the layout's page table), so indices
+ * are stable whether or not the page exists.  Non-visible pages are freed again in
+ * LRU order when too many are resident or the LVGL heap runs low; the
+ * shadow state below survives and is re-applied when the page is rebuilt.
+ *
+ * Setters do not touch LVGL directly: they update a per-widget shadow
+ * state and mark it dirty.  ui_pages_flush() – run by an LVGL timer on
+ * the next lv_timer_handler() call – applies each dirty widget once, and
+ * skips values LVGL already shows, so a host streaming the same widget
+ * many times per frame costs one invalidation at most.
+ *
+ * Host-set label text is shown with lv_label_set_text_static() from a
+ * fixed pool of interned strings, shared by every label showing the same
+ * text, so rotating status messages never touch the LVGL heap.  Layout
+ * text is copied by LVGL once when a page is built.
+ *
+ * What the host has set (and the page it shows) can be serialised with
+ * ui_pages_snapshot() and put back with ui_pages_restore(); dm_snapshot
+ * keeps that in flash across resets and is told of every change.
+ *
+ * With DM_UI_SPLIT this file runs on the LVGL core only: the setters are
+ * called from dm_uiq_apply() and widget events are queued for the
+ * protocol core instead of being sent from the callbacks.
  *
  * NOTE: This file depends on LVGL (lvgl/lvgl.h).  It must only be
  * compiled as part of a board target that provides an LVGL port.
  */
 #include "ui_pages.h"
+#include "ui_layout.h"
+#include "../../core/dm_core.h"
 #include "../../core/dm_packet.h"
 #include "../../core/dm_config.h"
+#include "../../core/crc16.h"
+#include "../dm_resources.h"
+#include "../dm_snapshot.h"
+#include "../dm_ui_queue.h"
 
 /* LVGL is provided by the board's CMake target */
 #include "lvgl.h"
 
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* ── Widget registry ─────────────────────────────────────────────────────── */
 
-#define WIDGET_TABLE_SIZE 16
+#if DM_MAX_WIDGETS > 255
+#error "DM_MAX_WIDGETS must fit the protocol's u8 widget_idx (0xFF = invalid)"
+#endif
 
 typedef enum {
-    WIDGET_LABEL = 0,
-    WIDGET_SLIDER,
-    WIDGET_BUTTON,
+    WIDGET_LABEL  = UI_LAYOUT_TYPE_LABEL,
+    WIDGET_SLIDER = UI_LAYOUT_TYPE_SLIDER,
+    WIDGET_BUTTON = UI_LAYOUT_TYPE_BUTTON,
+    WIDGET_PANEL  = UI_LAYOUT_TYPE_PANEL,
+    WIDGET_IMAGE  = UI_LAYOUT_TYPE_IMAGE,   /* value = resource id */
 } widget_type_t;
 
 typedef struct {
-    lv_obj_t    *obj;
+    lv_obj_t    *obj;       /**< NULL while the owning page is not built */
     widget_type_t type;
+    uint8_t      text_slot; /**< Text pool slot the label shows, or NO_TEXT_SLOT */
 } widget_entry_t;
 
-static widget_entry_t s_widgets[WIDGET_TABLE_SIZE];
+static widget_entry_t s_widgets[DM_MAX_WIDGETS];
 static uint8_t        s_widget_count = 0;
 
+/* ── Shadow state ────────────────────────────────────────────────────────── */
+
+#define DIRTY_TEXT    (1U << 0)
+#define DIRTY_VALUE   (1U << 1)
+#define DIRTY_VISIBLE (1U << 2)
+#define DIRTY_ENABLED (1U << 3)
+#define DIRTY_ALL     (DIRTY_TEXT | DIRTY_VALUE | DIRTY_VISIBLE | DIRTY_ENABLED)
+
+/* Latest state requested by the host for each widget. */
+typedef struct {
+    char    text[DM_MAX_TEXT_LEN];
+    int16_t value;
+    bool    visible;
+    bool    enabled;
+    uint8_t known;        /**< DIRTY_* fields holding real state (host or build) */
+    uint8_t host;         /**< DIRTY_* fields the host has set (the snapshot) */
+    uint8_t dirty;        /**< DIRTY_* bits not yet applied to LVGL */
+    bool    listed;       /**< In s_dirty_list until the next flush */
+} widget_shadow_t;
+
+static widget_shadow_t s_shadow[DM_MAX_WIDGETS];
+static uint8_t         s_dirty_list[DM_MAX_WIDGETS]; /* indices, no dupes */
+static uint8_t         s_dirty_count = 0;
+
+/* ── Text pool ───────────────────────────────────────────────────────────── */
+
+/*
+ * A slot's text never changes while any label points at it: labels are
+ * only ever moved to another slot, and a slot is reused once its last
+ * label has been moved or deleted.
+ */
+#define NO_TEXT_SLOT 0xFF
+
+#if DM_TEXT_POOL_SLOTS >= NO_TEXT_SLOT
+#error "DM_TEXT_POOL_SLOTS must be below 255"
+#endif
+
+typedef struct {
+    char     text[DM_MAX_TEXT_LEN];
+    uint16_t refs;          /**< Labels showing this slot; 0 = free */
+} text_slot_t;
+
+#if DM_TEXT_POOL_SLOTS > 0
+static text_slot_t s_text_pool[DM_TEXT_POOL_SLOTS];
+#endif
+
+/* Slots still shown by the previous layout's screen (see s_retired). */
+static uint8_t s_retired_text[DM_MAX_WIDGETS];
+static uint8_t s_retired_text_count = 0;
+
+/* Take a reference on the slot holding @p text; NO_TEXT_SLOT if full. */
+static uint8_t text_intern(const char *text)
+{
+#if DM_TEXT_POOL_SLOTS > 0
+    uint8_t free_slot = NO_TEXT_SLOT;
+    for (uint8_t i = 0; i < DM_TEXT_POOL_SLOTS; i++) {
+        text_slot_t *t = &s_text_pool[i];
+        if (t->refs == 0) {
+            if (free_slot == NO_TEXT_SLOT) free_slot = i;
+        } else if (strcmp(t->text, text) == 0) {
+            t->refs++;
+            return i;
+        }
+    }
+    if (free_slot != NO_TEXT_SLOT) {
+        strcpy(s_text_pool[free_slot].text, text);   /* shadow text: always fits */
+        s_text_pool[free_slot].refs = 1;
+    }
+    return free_slot;
+#else
+    (void)text;
+    return NO_TEXT_SLOT;
+#endif
+}
+
+static const char *text_str(uint8_t slot)
+{
+#if DM_TEXT_POOL_SLOTS > 0
+    return s_text_pool[slot].text;
+#else
+    (void)slot;
+    return "";
+#endif
+}
+
+static void text_release(uint8_t slot)
+{
+#if DM_TEXT_POOL_SLOTS > 0
+    if (slot != NO_TEXT_SLOT) s_text_pool[slot].refs--;
+#else
+    (void)slot;
+#endif
+}
+
 /* Pages */
-static lv_obj_t *s_pages[DM_MAX_PAGES];
-static uint8_t   s_page_count = 0;
-static uint8_t   s_current_page = 0xFF;
+typedef struct {
+    lv_obj_t *screen;       /**< NULL until built, and again after reclaim */
+    uint8_t   first_widget; /**< First widget index owned by this page */
+    uint8_t   widget_count; /**< Widgets owned by this page */
+    uint32_t  last_used;    /**< LRU stamp (s_use_clock at last show) */
+} page_slot_t;
 
-/* Platform reference for event callbacks */
-static const dm_platform_t *s_plat = NULL; /* Set via ui_pages_set_platform() – optional */
+static page_slot_t s_pages[DM_MAX_PAGES];
+static uint8_t     s_page_count = 0;
+static uint8_t     s_current_page = 0xFF;
+static uint32_t    s_use_clock = 0;
+
+/* Active layout (flash or a caller-owned buffer; never copied) */
+static const uint8_t *s_layout = NULL;
+static lv_obj_t      *s_retired = NULL;  /* Previous layout's visible screen */
+static lv_timer_t    *s_flush_timer = NULL;  /* Paused while nothing is dirty */
 
 /* ── Internal helpers ─────────────────────────────────────────────────────── */
 
-static uint8_t register_widget(lv_obj_t *obj, widget_type_t type)
+/* Label that carries a widget's text (buttons: first child label). */
+static lv_obj_t *text_obj(const widget_entry_t *w)
 {
-    if (s_widget_count >= WIDGET_TABLE_SIZE) return 0xFF;
-    uint8_t idx = s_widget_count++;
-    s_widgets[idx].obj  = obj;
-    s_widgets[idx].type = type;
-    return idx;
+    if (w->type == WIDGET_LABEL)  return w->obj;
+    if (w->type == WIDGET_BUTTON) return lv_obj_get_child(w->obj, 0);
+    return NULL;
 }
 
-/* Button event callback */
-static void btn_event_cb(lv_event_t *e)
+static inline uint16_t rd_u16(const uint8_t *p)
 {
-    if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
-    lv_obj_t *btn = lv_event_get_target(e);
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
 
-    /* Find widget index */
-    for (uint8_t i = 0; i < s_widget_count; i++) {
-        if (s_widgets[i].obj == btn && s_plat) {
-            dm_packet_send_button_pressed(i, s_plat);
-            break;
+static inline int16_t rd_i16(const uint8_t *p)
+{
+    return (int16_t)rd_u16(p);
+}
+
+/* Widget record N of the active layout is widget_idx N. */
+static const uint8_t *layout_record(uint8_t idx)
+{
+    return s_layout + UI_LAYOUT_HEADER_SIZE + s_layout[UI_LAYOUT_OFF_PAGES] +
+           (size_t)idx * UI_LAYOUT_RECORD_SIZE;
+}
+
+static const char *layout_text(const uint8_t *rec)
+{
+    uint16_t off = rd_u16(rec + UI_LAYOUT_REC_TEXT);
+    if (off == UI_LAYOUT_NO_TEXT) return NULL;
+    return (const char *)layout_record(s_layout[UI_LAYOUT_OFF_WIDGETS]) + off;
+}
+
+/* Attach a freshly built object to its slot and sync the shadow. */
+static void register_widget(uint8_t idx, lv_obj_t *obj)
+{
+    widget_type_t type = s_widgets[idx].type;
+    s_widgets[idx].obj = obj;
+
+    /* Fields nobody has set yet take what the page builder created... */
+    widget_shadow_t *sh   = &s_shadow[idx];
+    uint8_t          seed = (uint8_t)(DIRTY_ALL & ~sh->known);
+    lv_obj_t        *lbl  = text_obj(&s_widgets[idx]);
+    if ((seed & DIRTY_TEXT) && lbl) {
+        strncpy(sh->text, lv_label_get_text(lbl), DM_MAX_TEXT_LEN - 1);
+        sh->text[DM_MAX_TEXT_LEN - 1] = '\0';
+    }
+    if ((seed & DIRTY_VALUE) && type == WIDGET_SLIDER) {
+        sh->value = (int16_t)lv_slider_get_value(obj);
+    } else if ((seed & DIRTY_VALUE) && type == WIDGET_IMAGE) {
+        sh->value = rd_i16(layout_record(idx) + UI_LAYOUT_REC_VALUE);
+    }
+    if (seed & DIRTY_VISIBLE) sh->visible = !lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    if (seed & DIRTY_ENABLED) sh->enabled = !lv_obj_has_state(obj, LV_STATE_DISABLED);
+
+    /* ...everything already known (host writes, earlier builds) is restored. */
+    sh->dirty |= sh->known;
+    sh->known  = DIRTY_ALL;
+}
+
+/*
+ * Every setter call counts, even one that changes nothing: the snapshot
+ * must hold the same fields whether or not the page was built first.
+ */
+static void host_write(widget_shadow_t *sh, uint8_t bit)
+{
+    if (sh->host & bit) return;
+    sh->host |= bit;
+    dm_snapshot_changed();
+}
+
+static void mark_dirty(uint8_t idx, uint8_t bits)
+{
+    dm_snapshot_changed();
+    /* First pending change: have the next lv_timer_handler() flush. */
+    if (s_dirty_count == 0 && s_flush_timer) lv_timer_resume(s_flush_timer);
+    widget_shadow_t *sh = &s_shadow[idx];
+    if (!sh->listed && s_dirty_count < DM_MAX_WIDGETS) {
+        sh->listed = true;
+        s_dirty_list[s_dirty_count++] = idx;
+    }
+    sh->dirty |= bits;
+}
+
+/*
+ * Image descriptor for a committed DM_RES_TYPE_IMAGE resource, which is
+ * an LVGL binary image: lv_image_header_t followed by the pixel data.
+ * Pixels are drawn straight from the resource store.
+ */
+static lv_image_dsc_t s_images[DM_RES_MAX_COUNT];
+
+static const void *image_src(int16_t res_id)
+{
+    uint8_t  type;
+    uint32_t size;
+    if (res_id < 0 || res_id >= DM_RES_MAX_COUNT) return NULL;
+    const uint8_t *d = dm_resource_get((uint8_t)res_id, &type, &size);
+    if (!d || type != DM_RES_TYPE_IMAGE || size < sizeof(lv_image_header_t)) return NULL;
+
+    lv_image_dsc_t *dsc = &s_images[res_id];
+    memcpy(&dsc->header, d, sizeof(lv_image_header_t));
+    if (dsc->header.magic != LV_IMAGE_HEADER_MAGIC) return NULL;
+    dsc->data      = d + sizeof(lv_image_header_t);
+    dsc->data_size = size - sizeof(lv_image_header_t);
+    return dsc;
+}
+
+/* Push one widget's pending shadow state into LVGL. */
+static void apply_widget(uint8_t idx)
+{
+    widget_entry_t  *w  = &s_widgets[idx];
+    widget_shadow_t *sh = &s_shadow[idx];
+
+    /* Page not built: the shadow keeps the state for the next build. */
+    if (!w->obj) {
+        sh->dirty = 0;
+        return;
+    }
+
+    if (sh->dirty & DIRTY_TEXT) {
+        lv_obj_t *lbl = text_obj(w);
+        /* Even an identical lv_label_set_text() invalidates – skip it. */
+        if (lbl && strcmp(lv_label_get_text(lbl), sh->text) != 0) {
+            /* Intern first, so text stored again keeps its slot. */
+            uint8_t slot = text_intern(sh->text);
+            if (slot != NO_TEXT_SLOT) {
+                lv_label_set_text_static(lbl, text_str(slot));
+            } else {
+                lv_label_set_text(lbl, sh->text);   /* pool full: LVGL copy */
+            }
+            text_release(w->text_slot);
+            w->text_slot = slot;
         }
     }
+    if ((sh->dirty & DIRTY_VALUE) && w->type == WIDGET_SLIDER &&
+        lv_slider_get_value(w->obj) != sh->value) {
+        lv_slider_set_value(w->obj, sh->value, LV_ANIM_ON);
+    }
+    if ((sh->dirty & DIRTY_VALUE) && w->type == WIDGET_IMAGE) {
+        lv_image_set_src(w->obj, image_src(sh->value));
+    }
+    if (sh->dirty & DIRTY_VISIBLE) {
+        if (sh->visible) {
+            lv_obj_clear_flag(w->obj, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(w->obj, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    if (sh->dirty & DIRTY_ENABLED) {
+        if (sh->enabled) {
+            lv_obj_clear_state(w->obj, LV_STATE_DISABLED);
+        } else {
+            lv_obj_add_state(w->obj, LV_STATE_DISABLED);
+        }
+    }
+    sh->dirty = 0;
+}
+
+/*
+ * Event callbacks get their widget index from the event user_data, set
+ * when the callback is attached (see add_widget_event_cb), so the lookup
+ * is constant time however many widgets a page has.
+ */
+static inline uint8_t event_widget_idx(lv_event_t *e)
+{
+    return (uint8_t)(uintptr_t)lv_event_get_user_data(e);
+}
+
+static void flush_timer_cb(lv_timer_t *t)
+{
+    ui_pages_flush();
+    /* Paused while nothing is dirty, so lv_timer_handler() can report a real wait. */
+    lv_timer_pause(t);
 }
 
-/* Slider event callback */
+/* Button event callback */
+static void btn_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
+#if DM_UI_SPLIT
+    dm_uiq_evt_t evt = { .op = DM_UIQ_EVT_BUTTON, .idx = event_widget_idx(e) };
+    dm_uiq_post_event(&evt);
+#else
+    /* Events go to the selected link (dm_ctx_select()). */
+    const dm_platform_t *plat = dm_current_platform();
+    if (plat) dm_packet_send_button_pressed(event_widget_idx(e), plat);
+#endif
+}
+
+/* Slider event callback (VALUE_CHANGED while dragging, RELEASED at the end) */
 static void slider_event_cb(lv_event_t *e)
 {
-    if (lv_event_get_code(e) != LV_EVENT_VALUE_CHANGED) return;
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_VALUE_CHANGED && code != LV_EVENT_RELEASED) return;
+
     lv_obj_t *slider = lv_event_get_target(e);
     int16_t   val    = (int16_t)lv_slider_get_value(slider);
+    uint8_t   idx    = event_widget_idx(e);
 
-    for (uint8_t i = 0; i < s_widget_count; i++) {
-        if (s_widgets[i].obj == slider && s_plat) {
-            dm_packet_send_slider_changed(i, val, s_plat);
-            break;
+    /* The user moved it: keep the shadow in step with LVGL. */
+    s_shadow[idx].value = val;
+#if DM_UI_SPLIT
+    dm_uiq_evt_t evt = {
+        .op    = code == LV_EVENT_RELEASED ? DM_UIQ_EVT_SLIDER_SETTLED
+                                           : DM_UIQ_EVT_SLIDER_CHANGED,
+        .idx   = idx,
+        .value = val,
+    };
+    dm_uiq_post_event(&evt);
+#else
+    const dm_platform_t *plat = dm_current_platform();
+    if (!plat) return;
+
+    /* Drag updates are rate-limited in dm_packet; the release always goes out. */
+    if (code == LV_EVENT_RELEASED) {
+        dm_packet_send_slider_settled(idx, val, plat);
+    } else {
+        dm_packet_send_slider_changed(idx, val, plat);
+    }
+#endif
+}
+
+/* Attach @p cb with the widget index as user_data (after registering). */
+static void add_widget_event_cb(uint8_t idx, lv_event_cb_t cb,
+                                lv_event_code_t code)
+{
+    lv_obj_add_event_cb(s_widgets[idx].obj, cb, code, (void *)(uintptr_t)idx);
+}
+
+/* ── Layout builder ──────────────────────────────────────────────────────── */
+
+/*
+ * Structural checks only – enough that building can never read outside
+ * the blob or index outside s_widgets.  Everything else (sensible sizes,
+ * ids, text lengths) is the host tool's job.
+ */
+bool ui_pages_layout_valid(const uint8_t *blob, size_t len)
+{
+    if (len < UI_LAYOUT_HEADER_SIZE) return false;
+    if (blob[UI_LAYOUT_OFF_MAGIC]     != UI_LAYOUT_MAGIC0 ||
+        blob[UI_LAYOUT_OFF_MAGIC + 1] != UI_LAYOUT_MAGIC1 ||
+        blob[UI_LAYOUT_OFF_VERSION]   != UI_LAYOUT_VERSION) return false;
+
+    uint8_t pages   = blob[UI_LAYOUT_OFF_PAGES];
+    uint8_t widgets = blob[UI_LAYOUT_OFF_WIDGETS];
+    if (pages == 0 || pages > DM_MAX_PAGES || widgets > DM_MAX_WIDGETS) return false;
+
+    size_t pool = UI_LAYOUT_HEADER_SIZE + pages + (size_t)widgets * UI_LAYOUT_RECORD_SIZE;
+    if (pool > len) return false;
+    if (crc16_ccitt(blob + UI_LAYOUT_HEADER_SIZE, len - UI_LAYOUT_HEADER_SIZE) !=
+        rd_u16(blob + UI_LAYOUT_OFF_CRC)) return false;
+
+    const uint8_t *rec = blob + UI_LAYOUT_HEADER_SIZE + pages;
+    size_t         n   = 0;
+    for (uint8_t p = 0; p < pages; p++) {
+        uint8_t count = blob[UI_LAYOUT_HEADER_SIZE + p];
+        if (n + count > widgets) return false;
+        for (uint8_t i = 0; i < count; i++, n++, rec += UI_LAYOUT_RECORD_SIZE) {
+            uint8_t  parent = rec[UI_LAYOUT_REC_PARENT];
+            uint16_t text   = rd_u16(rec + UI_LAYOUT_REC_TEXT);
+            if (rec[UI_LAYOUT_REC_TYPE] > UI_LAYOUT_TYPE_IMAGE) return false;
+            if (rec[UI_LAYOUT_REC_ALIGN] > LV_ALIGN_OUT_RIGHT_BOTTOM) return false;
+            if (parent != UI_LAYOUT_NO_PARENT && parent >= i) return false;
+            if (text != UI_LAYOUT_NO_TEXT &&
+                (text >= len - pool || !memchr(blob + pool + text, '\0', len - pool - text))) {
+                return false;
+            }
+        }
+    }
+    return n == widgets;
+}
+
+/* Create one widget from its record (parents come first in a page). */
+static void build_widget(uint8_t idx, lv_obj_t *screen, uint8_t first)
+{
+    const uint8_t *rec    = layout_record(idx);
+    uint8_t        parent = rec[UI_LAYOUT_REC_PARENT];
+    lv_obj_t      *owner  = screen;
+    if (parent != UI_LAYOUT_NO_PARENT && s_widgets[first + parent].obj) {
+        owner = s_widgets[first + parent].obj;
+    }
+
+    const char *text = layout_text(rec);
+    lv_obj_t   *obj;
+    switch (s_widgets[idx].type) {
+    case WIDGET_LABEL:
+        obj = lv_label_create(owner);
+        lv_label_set_text(obj, text ? text : "");
+        break;
+    case WIDGET_BUTTON: {
+        obj = lv_btn_create(owner);
+        lv_obj_t *lbl = lv_label_create(obj);   /* child 0 carries the text */
+        lv_label_set_text(lbl, text ? text : "");
+        lv_obj_center(lbl);
+        break;
+    }
+    case WIDGET_SLIDER:
+        obj = lv_slider_create(owner);
+        lv_slider_set_range(obj, rd_i16(rec + UI_LAYOUT_REC_MIN),
+                            rd_i16(rec + UI_LAYOUT_REC_MAX));
+        lv_slider_set_value(obj, rd_i16(rec + UI_LAYOUT_REC_VALUE), LV_ANIM_OFF);
+        break;
+    case WIDGET_IMAGE:
+        obj = lv_image_create(owner);   /* source set by apply_widget() */
+        break;
+    default:
+        obj = lv_obj_create(owner);
+        break;
+    }
+
+    int16_t w = rd_i16(rec + UI_LAYOUT_REC_W);
+    int16_t h = rd_i16(rec + UI_LAYOUT_REC_H);
+    if (w != 0) lv_obj_set_width(obj, w);
+    if (h != 0) lv_obj_set_height(obj, h);
+    lv_obj_align(obj, (lv_align_t)rec[UI_LAYOUT_REC_ALIGN],
+                 rd_i16(rec + UI_LAYOUT_REC_X), rd_i16(rec + UI_LAYOUT_REC_Y));
+
+    uint8_t flags = rec[UI_LAYOUT_REC_FLAGS];
+    if (flags & UI_LAYOUT_FLAG_HIDDEN)   lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    if (flags & UI_LAYOUT_FLAG_DISABLED) lv_obj_add_state(obj, LV_STATE_DISABLED);
+
+    register_widget(idx, obj);
+
+    if (flags & UI_LAYOUT_FLAG_EVENTS) {
+        if (s_widgets[idx].type == WIDGET_BUTTON) {
+            add_widget_event_cb(idx, btn_event_cb, LV_EVENT_CLICKED);
+        } else if (s_widgets[idx].type == WIDGET_SLIDER) {
+            add_widget_event_cb(idx, slider_event_cb, LV_EVENT_VALUE_CHANGED);
+            add_widget_event_cb(idx, slider_event_cb, LV_EVENT_RELEASED);
         }
     }
 }
 
-/* ── Page builders ────────────────────────────────────────────────────────── */
+/* ── Page residency ──────────────────────────────────────────────────────── */
 
-static void build_home_page(lv_obj_t *page)
+static uint8_t resident_pages(void)
 {
-    /* Title label (widget idx 0) */
-    lv_obj_t *lbl_title = lv_label_create(page);
-    lv_label_set_text(lbl_title, "hmic Display Manager");
-    lv_obj_align(lbl_title, LV_ALIGN_TOP_MID, 0, 16);
-    register_widget(lbl_title, WIDGET_LABEL);
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < s_page_count; i++) {
+        if (s_pages[i].screen) n++;
+    }
+    return n;
+}
 
-    /* Status label (widget idx 1) */
-    lv_obj_t *lbl_status = lv_label_create(page);
-    lv_label_set_text(lbl_status, "Waiting for host...");
-    lv_obj_align(lbl_status, LV_ALIGN_CENTER, 0, 0);
-    register_widget(lbl_status, WIDGET_LABEL);
+static bool heap_low(void)
+{
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.used_pct >= DM_UI_RECLAIM_USED_PCT;
+#else
+    return false;   /* No visibility into a foreign allocator */
+#endif
+}
 
-    /* OK button (widget idx 2) */
-    lv_obj_t *btn = lv_btn_create(page);
-    lv_obj_align(btn, LV_ALIGN_BOTTOM_MID, 0, -16);
-    lv_obj_add_event_cb(btn, btn_event_cb, LV_EVENT_CLICKED, NULL);
-    lv_obj_t *btn_label = lv_label_create(btn);
-    lv_label_set_text(btn_label, "OK");
-    register_widget(btn, WIDGET_BUTTON);
+/* Whether the LVGL heap has room for a page of @p widgets (best guess). */
+static bool heap_fits(uint8_t widgets)
+{
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.free_size >= (size_t)(widgets + 1U) * DM_UI_WIDGET_HEAP_BYTES;
+#else
+    (void)widgets;
+    return true;
+#endif
 }
 
-static void build_slider_page(lv_obj_t *page)
+/* Free the screen of one page; its widgets fall back to shadow-only. */
+static void free_page(uint8_t page_id)
+{
+    page_slot_t *pg = &s_pages[page_id];
+    if (!pg->screen) return;
+    lv_obj_delete(pg->screen);
+    pg->screen = NULL;
+    for (uint8_t i = 0; i < pg->widget_count; i++) {
+        widget_entry_t *w = &s_widgets[pg->first_widget + i];
+        w->obj = NULL;
+        text_release(w->text_slot);
+        w->text_slot = NO_TEXT_SLOT;
+    }
+}
+
+/*
+ * Keep the visible page of a layout being replaced on screen until the
+ * next one is shown, text pool slots included.
+ */
+static void retire_page(uint8_t page_id)
 {
-    /* Label (widget idx 3) */
-    lv_obj_t *lbl = lv_label_create(page);
-    lv_label_set_text(lbl, "Adjust value:");
-    lv_obj_align(lbl, LV_ALIGN_CENTER, 0, -40);
-    register_widget(lbl, WIDGET_LABEL);
+    page_slot_t *pg = &s_pages[page_id];
+    s_retired = pg->screen;
+    pg->screen = NULL;
+    for (uint8_t i = 0; i < pg->widget_count; i++) {
+        widget_entry_t *w = &s_widgets[pg->first_widget + i];
+        if (w->text_slot != NO_TEXT_SLOT) {
+            s_retired_text[s_retired_text_count++] = w->text_slot;
+        }
+        w->obj = NULL;
+        w->text_slot = NO_TEXT_SLOT;
+    }
+}
+
+/* Evict least-recently-shown non-visible pages while over budget. */
+static void reclaim_pages(bool force_all)
+{
+    while (force_all || resident_pages() > DM_UI_MAX_RESIDENT_PAGES || heap_low()) {
+        uint8_t victim = 0xFF;
+        for (uint8_t i = 0; i < s_page_count; i++) {
+            if (i == s_current_page || !s_pages[i].screen) continue;
+            if (victim == 0xFF || s_pages[i].last_used < s_pages[victim].last_used) {
+                victim = i;
+            }
+        }
+        if (victim == 0xFF) return;   /* only the visible page is left */
+        free_page(victim);
+    }
+}
+
+static bool build_page(uint8_t page_id)
+{
+    page_slot_t *pg = &s_pages[page_id];
+
+    /*
+     * With LV_USE_ASSERT_MALLOC a failed allocation halts in
+     * LV_ASSERT_HANDLER instead of returning NULL, so room is made before
+     * building: first the non-visible pages go, and a page that still
+     * does not fit is not shown.
+     */
+    if (!heap_fits(pg->widget_count)) {
+        reclaim_pages(true);
+        if (!heap_fits(pg->widget_count)) return false;
+    }
+
+    lv_obj_t *screen = lv_obj_create(NULL);
+    pg->screen = screen;
+    for (uint8_t i = 0; i < pg->widget_count; i++) {
+        build_widget(pg->first_widget + i, screen, pg->first_widget);
+    }
 
-    /* Slider (widget idx 4) */
-    lv_obj_t *slider = lv_slider_create(page);
-    lv_obj_align(slider, LV_ALIGN_CENTER, 0, 0);
-    lv_slider_set_range(slider, 0, 100);
-    lv_obj_add_event_cb(slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
-    register_widget(slider, WIDGET_SLIDER);
+    /* Restore shadow state before the first frame of this page. */
+    for (uint8_t i = 0; i < pg->widget_count; i++) {
+        apply_widget(pg->first_widget + i);
+    }
+    return true;
 }
 
 /* ── Public API ───────────────────────────────────────────────────────────── */
 
 void ui_pages_init(void)
 {
-    s_widget_count = 0;
     s_page_count   = 0;
+    s_widget_count = 0;
     s_current_page = 0xFF;
+    s_retired_text_count = 0;
+#if DM_TEXT_POOL_SLOTS > 0
+    memset(s_text_pool, 0, sizeof(s_text_pool));
+#endif
 
-    /* Page 0: Home */
-    lv_obj_t *home = lv_obj_create(NULL);
-    s_pages[s_page_count++] = home;
-    build_home_page(home);
+    /* Period 0: apply pending widget updates on the next lv_timer_handler(). */
+    s_flush_timer = lv_timer_create(flush_timer_cb, 0, NULL);
+    if (s_dirty_count == 0) lv_timer_pause(s_flush_timer);
 
-    /* Page 1: Slider Demo */
-    lv_obj_t *slider_page = lv_obj_create(NULL);
-    s_pages[s_page_count++] = slider_page;
-    build_slider_page(slider_page);
+    /* The built-in layout is checked by layout_tool.py when generated. */
+    ui_pages_load_layout(ui_layout_default, ui_layout_default_size);
+}
 
-    /* Show home page by default */
+bool ui_pages_load_layout(const uint8_t *blob, size_t len)
+{
+    if (!blob || !ui_pages_layout_valid(blob, len)) return false;
+    ui_pages_use_layout(blob);
+    return true;
+}
+
+void ui_pages_use_layout(const uint8_t *blob)
+{
+
+    /* Free the old pages now; the one on display goes after the switch. */
+    for (uint8_t i = 0; i < s_page_count; i++) {
+        if (i == s_current_page) {
+            retire_page(i);
+        } else {
+            free_page(i);
+        }
+    }
+
+    /* Lay out widget index ranges; nothing is built yet. */
+    s_layout       = blob;
+    s_page_count   = blob[UI_LAYOUT_OFF_PAGES];
+    s_widget_count = 0;
+    s_current_page = 0xFF;
+    s_dirty_count  = 0;
+    s_use_clock    = 0;
+    memset(s_shadow, 0, sizeof(s_shadow));
+
+    for (uint8_t p = 0; p < s_page_count; p++) {
+        s_pages[p].screen       = NULL;
+        s_pages[p].first_widget = s_widget_count;
+        s_pages[p].widget_count = blob[UI_LAYOUT_HEADER_SIZE + p];
+        s_pages[p].last_used    = 0;
+        for (uint8_t i = 0; i < s_pages[p].widget_count; i++, s_widget_count++) {
+            s_widgets[s_widget_count].obj       = NULL;
+            s_widgets[s_widget_count].text_slot = NO_TEXT_SLOT;
+            s_widgets[s_widget_count].type =
+                (widget_type_t)layout_record(s_widget_count)[UI_LAYOUT_REC_TYPE];
+        }
+    }
+
+    /* Show home page by default (builds it) */
     ui_pages_show(0);
 }
 
+void ui_pages_reclaim(void)
+{
+    reclaim_pages(true);
+}
+
+void ui_pages_flush(void)
+{
+    for (uint8_t i = 0; i < s_dirty_count; i++) {
+        apply_widget(s_dirty_list[i]);
+        s_shadow[s_dirty_list[i]].listed = false;
+    }
+    s_dirty_count = 0;
+}
+
 bool ui_pages_show(uint8_t page_id)
 {
     if (page_id >= s_page_count) return false;
-    lv_scr_load(s_pages[page_id]);
+    page_slot_t *pg = &s_pages[page_id];
+    if (!pg->screen && !build_page(page_id)) return false;
+
+    lv_scr_load(pg->screen);
+    if (s_current_page != page_id) dm_snapshot_changed();
     s_current_page = page_id;
+    if (s_retired) {
+        lv_obj_delete(s_retired);   /* last screen of the previous layout */
+        s_retired = NULL;
+        while (s_retired_text_count > 0) {
+            text_release(s_retired_text[--s_retired_text_count]);
+        }
+    }
+    pg->last_used  = ++s_use_clock;
+
+    reclaim_pages(false);
     return true;
 }
 
 bool ui_pages_set_text(uint8_t widget_idx, const char *text)
+{
+    return ui_pages_set_text_n(widget_idx, text, strlen(text));
+}
+
+bool ui_pages_set_text_n(uint8_t widget_idx, const char *text, size_t len)
 {
     if (widget_idx >= s_widget_count) return false;
-    widget_entry_t *w = &s_widgets[widget_idx];
-    if (w->type == WIDGET_LABEL) {
-        lv_label_set_text(w->obj, text);
-        return true;
-    }
-    if (w->type == WIDGET_BUTTON) {
-        /* Set text on the first child label of the button */
-        lv_obj_t *lbl = lv_obj_get_child(w->obj, 0);
-        if (lbl) { lv_label_set_text(lbl, text); return true; }
-    }
-    return false;
+    widget_type_t type = s_widgets[widget_idx].type;
+    if (type != WIDGET_LABEL && type != WIDGET_BUTTON) return false;
+
+    if (len > DM_MAX_TEXT_LEN - 1) len = DM_MAX_TEXT_LEN - 1;
+    const char *nul = memchr(text, '\0', len);
+    if (nul) len = (size_t)(nul - text);
+
+    /* The shadow is the only copy before LVGL's own. */
+    widget_shadow_t *sh = &s_shadow[widget_idx];
+    host_write(sh, DIRTY_TEXT);
+    if ((sh->known & DIRTY_TEXT) && sh->text[len] == '\0' &&
+        memcmp(sh->text, text, len) == 0) return true;
+    memcpy(sh->text, text, len);
+    sh->text[len] = '\0';
+    sh->known |= DIRTY_TEXT;
+    mark_dirty(widget_idx, DIRTY_TEXT);
+    return true;
 }
 
 bool ui_pages_set_value(uint8_t widget_idx, int16_t value)
 {
     if (widget_idx >= s_widget_count) return false;
-    widget_entry_t *w = &s_widgets[widget_idx];
-    if (w->type == WIDGET_SLIDER) {
-        lv_slider_set_value(w->obj, value, LV_ANIM_ON);
-        return true;
-    }
-    return false;
+    widget_type_t type = s_widgets[widget_idx].type;
+    if (type != WIDGET_SLIDER && type != WIDGET_IMAGE) return false;
+
+    widget_shadow_t *sh = &s_shadow[widget_idx];
+    host_write(sh, DIRTY_VALUE);
+    if ((sh->known & DIRTY_VALUE) && sh->value == value) return true;
+    sh->value  = value;
+    sh->known |= DIRTY_VALUE;
+    mark_dirty(widget_idx, DIRTY_VALUE);
+    return true;
+}
+
+bool ui_pages_add_value(uint8_t widget_idx, int16_t delta)
+{
+    if (widget_idx >= s_widget_count) return false;
+    widget_type_t type = s_widgets[widget_idx].type;
+    if (type != WIDGET_SLIDER && type != WIDGET_IMAGE) return false;
+
+    /* Before the first build the shadow has no value yet: use the layout's. */
+    const uint8_t *rec  = layout_record(widget_idx);
+    int32_t        base = (s_shadow[widget_idx].known & DIRTY_VALUE)
+                          ? s_shadow[widget_idx].value
+                          : rd_i16(rec + UI_LAYOUT_REC_VALUE);
+    int32_t v  = base + delta;
+    int32_t lo = type == WIDGET_SLIDER ? rd_i16(rec + UI_LAYOUT_REC_MIN) : INT16_MIN;
+    int32_t hi = type == WIDGET_SLIDER ? rd_i16(rec + UI_LAYOUT_REC_MAX) : INT16_MAX;
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return ui_pages_set_value(widget_idx, (int16_t)v);
+}
+
+uint8_t ui_pages_widget_count(void)
+{
+    return s_widget_count;
+}
+
+uint8_t ui_pages_dirty_count(void)
+{
+    return s_dirty_count;
 }
 
 void ui_pages_set_visible(uint8_t widget_idx, bool visible)
 {
     if (widget_idx >= s_widget_count) return;
-    if (visible) {
-        lv_obj_clear_flag(s_widgets[widget_idx].obj, LV_OBJ_FLAG_HIDDEN);
-    } else {
-        lv_obj_add_flag(s_widgets[widget_idx].obj, LV_OBJ_FLAG_HIDDEN);
-    }
+    widget_shadow_t *sh = &s_shadow[widget_idx];
+    host_write(sh, DIRTY_VISIBLE);
+    if ((sh->known & DIRTY_VISIBLE) && sh->visible == visible) return;
+    sh->visible = visible;
+    sh->known  |= DIRTY_VISIBLE;
+    mark_dirty(widget_idx, DIRTY_VISIBLE);
 }
 
 void ui_pages_set_enabled(uint8_t widget_idx, bool enabled)
 {
     if (widget_idx >= s_widget_count) return;
-    if (enabled) {
-        lv_obj_clear_state(s_widgets[widget_idx].obj, LV_STATE_DISABLED);
-    } else {
-        lv_obj_add_state(s_widgets[widget_idx].obj, LV_STATE_DISABLED);
+    widget_shadow_t *sh = &s_shadow[widget_idx];
+    host_write(sh, DIRTY_ENABLED);
+    if ((sh->known & DIRTY_ENABLED) && sh->enabled == enabled) return;
+    sh->enabled = enabled;
+    sh->known  |= DIRTY_ENABLED;
+    mark_dirty(widget_idx, DIRTY_ENABLED);
+}
+
+void ui_pages_resource_changed(uint8_t res_id)
+{
+    /* Applied right away: a resource being rewritten must stop drawing. */
+    lv_image_cache_drop(&s_images[res_id]);
+    for (uint8_t i = 0; i < s_widget_count; i++) {
+        if (s_widgets[i].type != WIDGET_IMAGE || s_shadow[i].value != res_id) continue;
+        if (s_widgets[i].obj) lv_image_set_src(s_widgets[i].obj, image_src(res_id));
+    }
+}
+
+/* ── Snapshot ────────────────────────────────────────────────────────────── */
+
+#if DM_MAX_TEXT_LEN > 256
+#error "DM_MAX_TEXT_LEN must fit the snapshot's u8 text length"
+#endif
+
+#define SNAP_HEADER_SIZE 4        /* [layout_crc:u16][page:u8][widget_count:u8] */
+#define SNAP_VISIBLE     0x01
+#define SNAP_ENABLED     0x02
+
+void ui_pages_snapshot(ui_pages_emit_t emit, void *ctx)
+{
+    const uint8_t hdr[SNAP_HEADER_SIZE] = {
+        s_layout[UI_LAYOUT_OFF_CRC], s_layout[UI_LAYOUT_OFF_CRC + 1],
+        s_current_page, s_widget_count,
+    };
+    emit(ctx, hdr, sizeof(hdr));
+
+    /* [idx:u8][fields:u8] [value:i16] [states:u8] [len:u8][text], as present */
+    for (uint8_t i = 0; i < s_widget_count; i++) {
+        const widget_shadow_t *sh = &s_shadow[i];
+        if (!sh->host) continue;
+
+        uint8_t rec[6];
+        size_t  n = 0;
+        rec[n++] = i;
+        rec[n++] = sh->host;
+        if (sh->host & DIRTY_VALUE) {
+            rec[n++] = (uint8_t)((uint16_t)sh->value >> 8);
+            rec[n++] = (uint8_t)sh->value;
+        }
+        if (sh->host & (DIRTY_VISIBLE | DIRTY_ENABLED)) {
+            /* Only the bits the host set; the other may be a build default. */
+            rec[n++] = (uint8_t)(((sh->host & DIRTY_VISIBLE) && sh->visible ? SNAP_VISIBLE : 0) |
+                                 ((sh->host & DIRTY_ENABLED) && sh->enabled ? SNAP_ENABLED : 0));
+        }
+        if (sh->host & DIRTY_TEXT) rec[n++] = (uint8_t)strlen(sh->text);
+        emit(ctx, rec, n);
+        if (sh->host & DIRTY_TEXT) emit(ctx, (const uint8_t *)sh->text, rec[n - 1]);
     }
 }
+
+/* Walk the widget entries; @p apply = false only checks them. */
+static bool restore_walk(const uint8_t *snap, size_t len, bool apply)
+{
+    size_t off = SNAP_HEADER_SIZE;
+    while (off < len) {
+        if (len - off < 2) return false;
+        uint8_t idx    = snap[off];
+        uint8_t fields = snap[off + 1];
+        off += 2;
+        if (idx >= s_widget_count || fields == 0 || (fields & ~DIRTY_ALL)) return false;
+
+        if (fields & DIRTY_VALUE) {
+            if (len - off < 2) return false;
+            if (apply) ui_pages_set_value(idx, rd_i16(snap + off));
+            off += 2;
+        }
+        if (fields & (DIRTY_VISIBLE | DIRTY_ENABLED)) {
+            if (len - off < 1) return false;
+            if (apply && (fields & DIRTY_VISIBLE)) ui_pages_set_visible(idx, snap[off] & SNAP_VISIBLE);
+            if (apply && (fields & DIRTY_ENABLED)) ui_pages_set_enabled(idx, snap[off] & SNAP_ENABLED);
+            off += 1;
+        }
+        if (fields & DIRTY_TEXT) {
+            if (len - off < 1 || len - off - 1 < snap[off]) return false;
+            if (apply) ui_pages_set_text_n(idx, (const char *)snap + off + 1, snap[off]);
+            off += 1 + (size_t)snap[off];
+        }
+    }
+    return true;
+}
+
+bool ui_pages_restore(const uint8_t *snap, size_t len)
+{
+    if (len < SNAP_HEADER_SIZE) return false;
+    if (rd_u16(snap) != rd_u16(s_layout + UI_LAYOUT_OFF_CRC) ||
+        snap[2] >= s_page_count || snap[3] != s_widget_count) return false;
+    if (!restore_walk(snap, len, false)) return false;
+
+    restore_walk(snap, len, true);
+    ui_pages_show(snap[2]);
+    ui_pages_flush();
+    return true;
+}
@@ -7,13 +7,21 @@
  * needing to know LVGL internals.
  *
  * All functions must be called from the LVGL task context (i.e. from
- * dm_process() or lv_timer_handler(), never from an ISR).
+ * dm_process() or lv_timer_handler(), never from an ISR).  With
+ * DM_UI_SPLIT that is the LVGL core only (dm_uiq_apply()); the protocol
+ * core may call ui_pages_layout_valid() and nothing else.
+ *
+ * The setters only record the requested state; LVGL is updated by
+ * ui_pages_flush() on the next lv_timer_handler() tick.  Requests that do
+ * not change the widget are dropped without touching LVGL.
  */
 #ifndef UI_PAGES_H
 #define UI_PAGES_H
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "../../core/dm_platform.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,18 +29,76 @@ extern "C" {
 
 /**
  * @brief Initialise the UI page system.
- * Creates LVGL pages and registers widgets in the widget table.
+ * Loads the built-in layout (see ui_layout.h) and shows page 0.
  * Must be called after lv_init() and the display driver are ready.
  */
 void ui_pages_init(void);
 
 /**
- * @brief Switch to a page by ID.
+ * @brief Replace all pages and widgets with those of a binary layout.
+ *
+ * The blob is used in place, not copied: it must stay valid and unchanged
+ * until another layout is loaded (flash, or a static upload buffer).
+ * All widget state is reset and page 0 is shown.
+ *
+ * @param blob  Layout in the ui_layout.h format.
+ * @param len   Blob size in bytes.
+ * @return false if the blob is malformed (the current layout is kept).
+ */
+bool ui_pages_load_layout(const uint8_t *blob, size_t len);
+
+/**
+ * @brief Check a layout blob without loading it.
+ *
+ * Structural checks only, enough to keep building memory-safe.  Touches
+ * no LVGL or ui_pages state, so any core may call it.
+ *
+ * @param blob  Layout in the ui_layout.h format.
+ * @param len   Blob size in bytes.
+ * @return true if ui_pages_load_layout() would accept it.
+ */
+bool ui_pages_layout_valid(const uint8_t *blob, size_t len);
+
+/**
+ * @brief Load a layout already accepted by ui_pages_layout_valid().
+ *
+ * Like ui_pages_load_layout() without the checks, for a blob validated
+ * on the protocol core (DM_UI_SPLIT), so the CRC engine is only ever
+ * used by one core.
+ *
+ * @param blob  Checked layout; same lifetime rules as ui_pages_load_layout().
+ */
+void ui_pages_use_layout(const uint8_t *blob);
+
+/**
+ * @brief Apply all pending widget updates to LVGL now.
+ *
+ * Runs automatically from an LVGL timer on the next lv_timer_handler()
+ * call after a change (the timer is paused while nothing is pending);
+ * call it directly only if you need the objects updated immediately.
+ */
+void ui_pages_flush(void);
+
+/**
+ * @brief Switch to a page by ID, building it first if it is not resident.
+ *
+ * May free other non-visible pages (least recently shown first) when more
+ * than DM_UI_MAX_RESIDENT_PAGES are built or the LVGL heap is above
+ * DM_UI_RECLAIM_USED_PCT.
+ *
  * @param page_id  zero-based page index.
- * @return true on success, false if page_id is out of range.
+ * @return true on success, false if page_id is out of range or the LVGL
+ *         heap has no room for the page (DM_UI_WIDGET_HEAP_BYTES per
+ *         widget) even after freeing the others.
  */
 bool ui_pages_show(uint8_t page_id);
 
+/**
+ * @brief Free every non-visible page now (e.g. before a large allocation).
+ * Widget state is kept and restored when a page is shown again.
+ */
+void ui_pages_reclaim(void);
+
 /**
  * @brief Set the text of a label widget.
  * @param widget_idx  Widget table index.
@@ -42,13 +108,46 @@ bool ui_pages_show(uint8_t page_id);
 bool ui_pages_set_text(uint8_t widget_idx, const char *text);
 
 /**
- * @brief Set the value of a slider widget.
+ * @brief Set the text of a label widget from a length-delimited string.
+ *
+ * Like ui_pages_set_text() but @p text needs no terminator, so a frame
+ * payload can be passed as-is.  Text is cut at DM_MAX_TEXT_LEN - 1 bytes
+ * or at an embedded NUL.
+ *
  * @param widget_idx  Widget table index.
- * @param value       New value.
+ * @param text        UTF-8 bytes (not necessarily null-terminated).
+ * @param len         Number of bytes at @p text.
+ * @return true on success.
+ */
+bool ui_pages_set_text_n(uint8_t widget_idx, const char *text, size_t len);
+
+/**
+ * @brief Set the value of a slider widget, or the resource id of an image.
+ * @param widget_idx  Widget table index.
+ * @param value       New value / resource id.
  * @return true on success.
  */
 bool ui_pages_set_value(uint8_t widget_idx, int16_t value);
 
+/**
+ * @brief Change the value of a slider or image widget by @p delta.
+ *
+ * Relative to the shadow value (the last one set, dragged to, or taken
+ * from the layout).  Slider results are clamped to the slider's range,
+ * image results to int16, so the shadow always matches what is drawn.
+ *
+ * @param widget_idx  Widget table index.
+ * @param delta       Signed step.
+ * @return true on success.
+ */
+bool ui_pages_add_value(uint8_t widget_idx, int16_t delta);
+
+/** @brief Number of widgets in the active layout. */
+uint8_t ui_pages_widget_count(void);
+
+/** @brief Widgets waiting for ui_pages_flush() (at most ui_pages_widget_count()). */
+uint8_t ui_pages_dirty_count(void);
+
 /**
  * @brief Show / hide a widget.
  * @param widget_idx  Widget table index.
@@ -63,6 +162,43 @@ void ui_pages_set_visible(uint8_t widget_idx, bool visible);
  */
 void ui_pages_set_enabled(uint8_t widget_idx, bool enabled);
 
+/**
+ * @brief Re-resolve image widgets showing resource @p res_id.
+ * Called by the resource store when the resource is published or
+ * withdrawn; takes effect immediately, not at the next flush.
+ * @param res_id  Resource id (< DM_RES_MAX_COUNT).
+ */
+void ui_pages_resource_changed(uint8_t res_id);
+
+/** Receives a snapshot from ui_pages_snapshot(), a few bytes at a time. */
+typedef void (*ui_pages_emit_t)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Serialise the screen state the host has set.
+ *
+ * Layout CRC, current page, then every field a setter has written since
+ * the layout was loaded (format in docs/protocol_spec.md §9).  Fields the
+ * host never set are left out, so the bytes do not depend on which pages
+ * happen to be built.
+ *
+ * @param emit  Called with consecutive pieces of the snapshot.
+ * @param ctx   Passed to @p emit.
+ */
+void ui_pages_snapshot(ui_pages_emit_t emit, void *ctx);
+
+/**
+ * @brief Put back a snapshot taken with ui_pages_snapshot().
+ *
+ * Replays the fields through the setters, shows the saved page and
+ * flushes, so the next frame already has the restored state.
+ *
+ * @param snap  Snapshot bytes.
+ * @param len   Snapshot size.
+ * @return false if it is malformed or was taken with another layout
+ *         (nothing is changed).
+ */
+bool ui_pages_restore(const uint8_t *snap, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,285 @@
+/**
+ * @file dm_bench.c
+ * @brief Benchmark streams and runner (see dm_bench.h).
+ */
+#include "dm_bench.h"
+#include "dm_core.h"
+#include "dm_packet.h"
+#include "dm_protocol.h"
+#include "crc16.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Text length of the aa_payload frames; must fit a v1 SET_TEXT payload. */
+#define AA_TEXT_LEN 32
+#if AA_TEXT_LEN + 1 > DM_MAX_PAYLOAD
+#error "DM_MAX_PAYLOAD too small for the benchmark SET_TEXT frames"
+#endif
+
+/* Largest frame any built-in stream contains. */
+#define BENCH_FRAME_MAX (DM_HEADER_SIZE + 1 + AA_TEXT_LEN + DM_CRC_SIZE)
+#define BENCH_STREAM_MAX (DM_BENCH_FRAMES * BENCH_FRAME_MAX)
+
+/* Payload of the large encode case. */
+#define ENCODE_BIG (DM_MAX_PAYLOAD < 128 ? DM_MAX_PAYLOAD : 128)
+
+static uint8_t s_stream[BENCH_STREAM_MAX];
+
+/* ── Null platform ──────────────────────────────────────────────────────── */
+
+static void null_write(const uint8_t *data, uint16_t len)
+{
+    (void)data;
+    (void)len;
+}
+
+/* Frozen clock: partial frames never expire, timings cost nothing. */
+static uint32_t null_millis(void)
+{
+    return 0;
+}
+
+static void null_log(const char *msg)
+{
+    (void)msg;
+}
+
+static dm_platform_t s_null = {
+    .write_bytes = null_write,
+    .millis      = null_millis,
+    .log         = null_log,
+};
+
+/* ── Streams ────────────────────────────────────────────────────────────── */
+
+/* Append one v1 host frame at @p out; returns its length. */
+static size_t put_frame(uint8_t *out, uint8_t cmd, uint8_t seq,
+                        const uint8_t *payload, uint8_t len)
+{
+    out[0] = DM_START_BYTE;
+    out[1] = DM_PROTOCOL_V1;
+    out[2] = cmd;
+    out[3] = seq;
+    out[4] = len;
+    if (len > 0) memcpy(&out[DM_HEADER_SIZE], payload, len);
+    size_t n = DM_HEADER_SIZE + len;
+    uint16_t crc = crc16_ccitt(&out[1], n - 1);
+    out[n++] = (uint8_t)(crc >> 8);
+    out[n++] = (uint8_t)(crc & 0xFF);
+    return n;
+}
+
+/* Mixed traffic as the host library sends it. */
+static size_t build_clean(uint8_t *out)
+{
+    static const char text[] = "Temp 21.5 C";
+    uint8_t p[1 + sizeof(text)];
+    size_t  n = 0;
+
+    for (unsigned i = 0; i < DM_BENCH_FRAMES; i++) {
+        uint8_t seq = (uint8_t)i;
+        uint8_t idx = (uint8_t)(i % 8);
+        switch (i % 4) {
+        case 0:
+            n += put_frame(out + n, CMD_PING, seq, NULL, 0);
+            break;
+        case 2:
+            p[0] = idx;
+            memcpy(&p[1], text, sizeof(text) - 1);
+            n += put_frame(out + n, CMD_SET_TEXT, seq, p, sizeof(p) - 1);
+            break;
+        default: {
+            uint16_t v = (uint16_t)(i * 37u);
+            p[0] = idx;
+            p[1] = (uint8_t)(v >> 8);
+            p[2] = (uint8_t)(v & 0xFF);
+            n += put_frame(out + n, CMD_SET_VALUE, seq, p, 3);
+            break;
+        }
+        }
+    }
+    return n;
+}
+
+/* SET_TEXT frames full of start bytes. */
+static size_t build_aa(uint8_t *out)
+{
+    uint8_t p[1 + AA_TEXT_LEN];
+    size_t  n = 0;
+
+    memset(p, DM_START_BYTE, sizeof(p));
+    for (unsigned i = 0; i < DM_BENCH_FRAMES; i++) {
+        p[0] = (uint8_t)(i % 8);
+        n += put_frame(out + n, CMD_SET_TEXT, (uint8_t)i, p, sizeof(p));
+    }
+    return n;
+}
+
+/* Flip the low CRC byte of every frame built by build_clean/build_aa. */
+static void corrupt_crcs(uint8_t *s, size_t n)
+{
+    size_t i = 0;
+    while (i + DM_HEADER_SIZE <= n) {
+        size_t len = DM_HEADER_SIZE + s[i + 4] + DM_CRC_SIZE;
+        s[i + len - 1] ^= 0x5A;
+        i += len;
+    }
+}
+
+/* Same size as the clean stream, xorshift bytes. */
+static size_t build_noise(uint8_t *out, size_t n)
+{
+    uint32_t x = 0x2545F491u;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        out[i] = (uint8_t)x;
+    }
+    return n;
+}
+
+/* ── Runner ─────────────────────────────────────────────────────────────── */
+
+typedef enum {
+    FEED_BYTE,   /* dm_receive_byte() per byte */
+    FEED_SPAN,   /* dm_receive_bytes() in DM_BENCH_CHUNK spans */
+} feed_mode_t;
+
+typedef struct {
+    uint64_t ticks;
+    uint64_t bytes;
+    uint64_t frames;
+} bench_total_t;
+
+static uint64_t min_ticks(const dm_bench_t *b)
+{
+    uint32_t ms = b->min_ms ? b->min_ms : DM_BENCH_MIN_MS;
+    return (uint64_t)b->hz * ms / 1000u;
+}
+
+/* Integer x10 fixed point, so no float printf is needed on the boards. */
+static void report(const dm_bench_t *b, const char *name, const char *mode,
+                   const bench_total_t *t, const char *per)
+{
+    char     line[112];
+    uint64_t ticks = t->ticks ? t->ticks : 1;
+    uint32_t per_b = t->bytes ? (uint32_t)(ticks * 10u / t->bytes) : 0;
+    uint32_t kbps  = (uint32_t)(t->bytes * b->hz / ticks / 1000u);
+
+    if (t->frames > 0) {
+        uint32_t fps   = (uint32_t)(t->frames * b->hz / ticks);
+        uint32_t per_f = (uint32_t)(ticks / t->frames);
+        snprintf(line, sizeof(line),
+                 "%-12s %-5s %6lu.%lu %s/B %9lu kB/s %9lu %s/s %7lu %s/%s",
+                 name, mode,
+                 (unsigned long)(per_b / 10), (unsigned long)(per_b % 10),
+                 b->unit, (unsigned long)kbps, (unsigned long)fps, per,
+                 (unsigned long)per_f, b->unit, per);
+    } else {
+        snprintf(line, sizeof(line), "%-12s %-5s %6lu.%lu %s/B %9lu kB/s",
+                 name, mode,
+                 (unsigned long)(per_b / 10), (unsigned long)(per_b % 10),
+                 b->unit, (unsigned long)kbps);
+    }
+    b->print(line);
+}
+
+/* One untimed reset, one timed pass; stats give the frames dispatched. */
+static void replay(const dm_bench_t *b, const char *name,
+                   const uint8_t *data, size_t n, feed_mode_t mode)
+{
+    bench_total_t t = {0};
+    uint64_t      goal = min_ticks(b);
+    dm_stats_t    st;
+
+    if (n == 0) return;
+    do {
+        dm_init(&s_null);
+        uint32_t t0 = b->now();
+        if (mode == FEED_BYTE) {
+            for (size_t i = 0; i < n; i++) dm_receive_byte(data[i]);
+        } else {
+            for (size_t i = 0; i < n; i += DM_BENCH_CHUNK) {
+                size_t k = n - i < DM_BENCH_CHUNK ? n - i : DM_BENCH_CHUNK;
+                dm_receive_bytes(&data[i], k);
+            }
+        }
+        t.ticks += b->now() - t0;
+        dm_get_stats(&st);
+        t.bytes  += n;
+        t.frames += st.frames_ok;
+    } while (t.ticks < goal);
+
+    report(b, name, mode == FEED_BYTE ? "byte" : "span", &t, "frame");
+}
+
+static void bench_crc(const dm_bench_t *b, const uint8_t *data, size_t n)
+{
+    bench_total_t     t = {0};
+    uint64_t          goal = min_ticks(b);
+    volatile uint16_t sink;
+
+    do {
+        uint32_t t0 = b->now();
+        sink = crc16_ccitt(data, n);
+        t.ticks += b->now() - t0;
+        t.bytes += n;
+    } while (t.ticks < goal);
+    (void)sink;
+
+    report(b, "crc16", "span", &t, "frame");
+}
+
+/* dm_packet_send() of DM_BENCH_FRAMES events per pass. */
+static void bench_encode(const dm_bench_t *b, const char *name, uint16_t len)
+{
+    static uint8_t payload[ENCODE_BIG];
+    bench_total_t  t = {0};
+    uint64_t       goal = min_ticks(b);
+    dm_stats_t     st;
+
+    for (uint16_t i = 0; i < len; i++) payload[i] = (uint8_t)(i * 7u);
+    do {
+        dm_init(&s_null);
+        uint32_t t0 = b->now();
+        for (unsigned i = 0; i < DM_BENCH_FRAMES; i++) {
+            dm_packet_send(EVT_SLIDER_CHANGED, 0, payload, len, &s_null);
+        }
+        t.ticks += b->now() - t0;
+        dm_get_stats(&st);
+        t.bytes  += st.tx_bytes;
+        t.frames += DM_BENCH_FRAMES;
+    } while (t.ticks < goal);
+
+    report(b, name, "send", &t, "frame");
+}
+
+void dm_bench_replay(const dm_bench_t *b, const char *name,
+                     const uint8_t *data, size_t n)
+{
+    replay(b, name, data, n, FEED_BYTE);
+    replay(b, name, data, n, FEED_SPAN);
+}
+
+void dm_bench_run_all(const dm_bench_t *b)
+{
+    size_t n;
+
+    n = build_clean(s_stream);
+    bench_crc(b, s_stream, n);
+    dm_bench_replay(b, "clean", s_stream, n);
+    corrupt_crcs(s_stream, n);
+    dm_bench_replay(b, "crc_err", s_stream, n);
+    n = build_noise(s_stream, n);
+    dm_bench_replay(b, "noise", s_stream, n);
+
+    n = build_aa(s_stream);
+    dm_bench_replay(b, "aa_payload", s_stream, n);
+    corrupt_crcs(s_stream, n);
+    dm_bench_replay(b, "aa_crc_err", s_stream, n);
+
+    bench_encode(b, "encode_3", 3);
+    bench_encode(b, "encode_big", ENCODE_BIG);
+}
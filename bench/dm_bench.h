@@ -0,0 +1,85 @@
+/**
+ * @file dm_bench.h
+ * @brief Parser / CRC / dispatch / encode microbenchmarks for hmic_core.
+ *
+ * Replays byte streams through dm_receive_byte() and dm_receive_bytes()
+ * with a null platform (writes discarded, clock frozen) and reports
+ * bytes/s parsed, frames/s dispatched and the encode cost of
+ * dm_packet_send().  The built-in streams are:
+ *
+ *   clean       PING / SET_VALUE / SET_TEXT traffic, all CRCs good
+ *   crc_err     the same frames with one CRC byte flipped in each
+ *   noise       pseudo-random bytes (about one 0xAA in 256)
+ *   aa_payload  SET_TEXT frames whose text is all 0xAA
+ *   aa_crc_err  the same with bad CRCs (worst case for DM_RX_RESCAN)
+ *
+ * The runner only needs a free-running counter, so the same code runs on
+ * the host (hmic_bench, nanosecond clock) and on the boards (cycle
+ * counter, see HMIC_BENCH_AT_BOOT).  It re-initialises the core with its
+ * own platform: run it before dm_init() and the UI, never alongside them.
+ */
+#ifndef DM_BENCH_H
+#define DM_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Frames in each built-in stream (seq IDs 0..N-1, so replays never hit the seq window). */
+#ifndef DM_BENCH_FRAMES
+#define DM_BENCH_FRAMES 128
+#endif
+
+/** Span size handed to dm_receive_bytes() (a typical UART DMA chunk). */
+#ifndef DM_BENCH_CHUNK
+#define DM_BENCH_CHUNK 64
+#endif
+
+/** Minimum measuring time per case; replays repeat until it has passed. */
+#ifndef DM_BENCH_MIN_MS
+#define DM_BENCH_MIN_MS 200
+#endif
+
+/** Clock and output of a benchmark run. */
+typedef struct {
+    /** Free-running counter (wraps at 2^32; one replay must be shorter). */
+    uint32_t (*now)(void);
+
+    /** Counter ticks per second. */
+    uint32_t hz;
+
+    /** Name of one tick in the report ("ns", "cyc", "us"). */
+    const char *unit;
+
+    /** Measuring time per case in ms (0 = DM_BENCH_MIN_MS). */
+    uint32_t min_ms;
+
+    /** Receives one report line at a time (no newline). */
+    void (*print)(const char *line);
+} dm_bench_t;
+
+/**
+ * @brief Run every built-in case and print one line per case.
+ * @param b  Clock and output.
+ */
+void dm_bench_run_all(const dm_bench_t *b);
+
+/**
+ * @brief Replay a recorded byte stream, byte-wise and in spans.
+ *
+ * @param b      Clock and output.
+ * @param name   Label for the report lines.
+ * @param data   Raw bytes as captured from the host link.
+ * @param n      Number of bytes in @p data.
+ */
+void dm_bench_replay(const dm_bench_t *b, const char *name,
+                     const uint8_t *data, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_BENCH_H */
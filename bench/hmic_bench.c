@@ -0,0 +1,79 @@
+/**
+ * @file hmic_bench.c
+ * @brief Host driver for the dm_bench microbenchmarks.
+ *
+ * Runs the built-in streams, then each recorded capture given with
+ * --replay (raw host→device bytes, e.g. logged from the serial line).
+ *
+ *   ./build-sim/hmic_bench
+ *   ./build-sim/hmic_bench --ms 1000 --replay capture.bin
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "dm_bench.h"
+
+static uint32_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+static void host_print(const char *line)
+{
+    puts(line);
+}
+
+static int replay_file(const dm_bench_t *b, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *data = size > 0 ? malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        free(data);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    const char *name = strrchr(path, '/');
+    dm_bench_replay(b, name ? name + 1 : path, data, (size_t)size);
+    free(data);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    dm_bench_t b = {
+        .now   = host_ns,
+        .hz    = 1000000000u,
+        .unit  = "ns",
+        .print = host_print,
+    };
+
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--ms") == 0) b.min_ms = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    dm_bench_run_all(&b);
+
+    int rc = 0;
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--replay") == 0) rc |= replay_file(&b, argv[i + 1]);
+    }
+    return rc;
+}
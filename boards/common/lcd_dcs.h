@@ -0,0 +1,71 @@
+/**
+ * @file lcd_dcs.h
+ * @brief MIPI DCS command set and power-up sequence for SPI TFT panels.
+ *
+ * Shared by the board HALs that drive the panel over raw SPI (RP2040,
+ * STM32).  The sequence suits the ST7789 and ILI9341 family in RGB565;
+ * panels needing vendor gamma / power tables add them after
+ * LCD_DCS_SLPOUT.  Header only: the HALs supply the byte transport.
+ */
+#ifndef LCD_DCS_H
+#define LCD_DCS_H
+
+#include <stdint.h>
+
+#define LCD_DCS_SWRESET 0x01
+#define LCD_DCS_SLPOUT  0x11
+#define LCD_DCS_NORON   0x13
+#define LCD_DCS_INVON   0x21
+#define LCD_DCS_DISPON  0x29
+#define LCD_DCS_CASET   0x2A   /**< [x0:u16 BE][x1:u16 BE] */
+#define LCD_DCS_RASET   0x2B   /**< [y0:u16 BE][y1:u16 BE] */
+#define LCD_DCS_RAMWR   0x2C
+#define LCD_DCS_MADCTL  0x36
+#define LCD_DCS_COLMOD  0x3A
+
+#define LCD_DCS_MADCTL_MY  0x80
+#define LCD_DCS_MADCTL_MX  0x40
+#define LCD_DCS_MADCTL_MV  0x20
+#define LCD_DCS_MADCTL_BGR 0x08
+
+#define LCD_DCS_COLMOD_RGB565 0x55
+
+/** Delay after a command, in ms (datasheet worst cases). */
+#define LCD_DCS_RESET_MS   150
+#define LCD_DCS_SLPOUT_MS  120
+
+/** One step: command, parameter count, parameters, delay afterwards. */
+typedef struct {
+    uint8_t cmd;
+    uint8_t n;
+    uint8_t data[2];
+    uint8_t delay_ms;
+} lcd_dcs_step_t;
+
+/**
+ * @brief Power-up sequence: reset, wake, RGB565, @p madctl orientation.
+ *
+ * LCD_DCS_INVON is for IPS panels (ST7789); drop that step for an
+ * ILI9341.
+ */
+#define LCD_DCS_INIT_SEQUENCE(madctl)                                         \
+    {                                                                         \
+        { LCD_DCS_SWRESET, 0, { 0 },                     LCD_DCS_RESET_MS  }, \
+        { LCD_DCS_SLPOUT,  0, { 0 },                     LCD_DCS_SLPOUT_MS }, \
+        { LCD_DCS_COLMOD,  1, { LCD_DCS_COLMOD_RGB565 }, 0 },                 \
+        { LCD_DCS_MADCTL,  1, { (madctl) },              0 },                 \
+        { LCD_DCS_INVON,   0, { 0 },                     0 },                 \
+        { LCD_DCS_NORON,   0, { 0 },                     0 },                 \
+        { LCD_DCS_DISPON,  0, { 0 },                     0 },                 \
+    }
+
+/** Fill @p out with the CASET / RASET parameters of window [a, b]. */
+static inline void lcd_dcs_window(uint8_t out[4], uint16_t a, uint16_t b)
+{
+    out[0] = (uint8_t)(a >> 8);
+    out[1] = (uint8_t)a;
+    out[2] = (uint8_t)(b >> 8);
+    out[3] = (uint8_t)b;
+}
+
+#endif /* LCD_DCS_H */
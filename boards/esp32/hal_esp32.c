@@ -6,24 +6,62 @@
  *
  * Wiring assumptions:
  *   - UART1 for RS485 communication.
+ *   - The IDF UART driver's ISR fills its own buffer; a dedicated RX task
+ *     blocks on the driver event queue and forwards bytes to the core RX
+ *     ring, so LVGL work in hmic_task never delays reception.  It wakes
+ *     the task running dm_process() as soon as bytes are in.
+ *   - HMIC_UI_SPLIT (DM_UI_SPLIT): hmic_task keeps only LVGL, pinned to
+ *     core 1; UART, parsing and ACKs run in hmic_proto on core 0, so ACK
+ *     latency does not depend on render time.
  *   - Adjust TX/RX pins below for your hardware.
- *   - Initialise display + touch drivers before calling dm_board_init().
+ *
+ * Display: an ST7789 SPI panel through esp_lcd (pins in Config).  LVGL
+ * renders into one of two partial buffers while the SPI master's DMA
+ * sends the other; on_color_trans_done hands it back with
+ * lv_display_flush_ready().  The buffers are internal DMA-capable RAM by
+ * default; DM_LCD_BUF_PSRAM moves them to PSRAM (taller bands, at the
+ * cost of slower CPU rendering into them).  Touch is left to the board:
+ * add an lv_indev in lcd_init().
+ *
+ * Screen state (dm_snapshot) is kept in a data partition named
+ * "hmic_state"; add a line like this to partitions.csv (4 sectors):
+ *
+ *   hmic_state, data, 0x40, , 16K,
+ *
+ * Without it nothing is persisted.  Writes stall both cores' flash cache
+ * for the duration, as every esp_partition write does.
  *
  * Build with ESP-IDF (idf.py build) or via cmake with the ESP-IDF toolchain.
  */
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <assert.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/uart.h"
+#include "driver/spi_master.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_partition.h"
+#include "lvgl.h"
 
 #include "../../core/dm_core.h"
 #include "../../core/dm_platform.h"
 #include "../../app/dm_binder.h"
+#include "../../app/dm_ui_queue.h"
+#include "../../app/dm_snapshot.h"
+#ifdef HMIC_BENCH_AT_BOOT
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#include "../../bench/dm_bench.h"
+#endif
 
 /* ── Config ──────────────────────────────────────────────────────────────── */
 
@@ -33,9 +71,42 @@
 #define DM_UART_RX_PIN    18
 #define DM_UART_BAUDRATE  115200
 #define DM_UART_BUF_SIZE  256
+#define DM_UART_EVT_DEPTH 16
+
+#define DM_LCD_HOST       SPI2_HOST
+#define DM_LCD_SCK_PIN    12
+#define DM_LCD_MOSI_PIN   11
+#define DM_LCD_CS_PIN     10
+#define DM_LCD_DC_PIN     9
+#define DM_LCD_RST_PIN    14
+#define DM_LCD_PCLK_HZ    (40 * 1000 * 1000)
+#define DM_LCD_WIDTH      320
+#define DM_LCD_HEIGHT     240
+/* Lines per partial buffer (two of them) */
+#ifdef DM_LCD_BUF_PSRAM
+#define DM_LCD_BUF_LINES  (DM_LCD_HEIGHT / 2)   /* 2 × 75 KB, no internal RAM used */
+#define DM_LCD_BUF_CAPS   (MALLOC_CAP_SPIRAM | MALLOC_CAP_DMA)
+#else
+#define DM_LCD_BUF_LINES  40        /* 2 × 320 × 40 × 2 B = 50 KB */
+#define DM_LCD_BUF_CAPS   (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+#endif
+
+#define DM_STATE_PART     "hmic_state"   /* Screen-state snapshot partition */
+#define DM_STATE_SECTOR   4096
+
+#define DM_PROTO_CORE     0    /* DM_UI_SPLIT: UART ISR, RX, parser, ACKs */
+#define DM_UI_CORE        1    /* DM_UI_SPLIT: LVGL */
+
+static QueueHandle_t s_uart_evt_queue = NULL;
+static TaskHandle_t  s_proto_task = NULL;   /* Runs dm_process(); woken by RX */
 
 /* ── Platform function implementations ───────────────────────────────────── */
 
+/*
+ * The IDF driver is installed with a TX ring buffer, so this only copies
+ * into it and returns; the driver's ISR drains it to the FIFO.  That gives
+ * non-blocking TX without a write_async entry.
+ */
 static void esp32_write_bytes(const uint8_t *data, uint16_t len)
 {
     uart_write_bytes(DM_UART_PORT, (const char *)data, len);
@@ -46,6 +117,11 @@ static uint32_t esp32_millis(void)
     return (uint32_t)(esp_timer_get_time() / 1000LL);
 }
 
+static uint32_t esp32_micros(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
 static void esp32_log(const char *msg)
 {
     ESP_LOGI(DM_TAG, "%s", msg);
@@ -56,12 +132,14 @@ static void esp32_log(const char *msg)
 static dm_platform_t s_platform = {
     .write_bytes = esp32_write_bytes,
     .millis      = esp32_millis,
+    .micros      = esp32_micros,
     .log         = esp32_log,
 };
 
 /* ── Board init ──────────────────────────────────────────────────────────── */
 
-static void dm_board_init(void)
+/* The driver's ISR lands on the core that installs it. */
+static void esp32_uart_init(void)
 {
     uart_config_t uart_config = {
         .baud_rate  = DM_UART_BAUDRATE,
@@ -73,43 +151,281 @@ static void dm_board_init(void)
     uart_param_config(DM_UART_PORT, &uart_config);
     uart_set_pin(DM_UART_PORT, DM_UART_TX_PIN, DM_UART_RX_PIN,
                  UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-    uart_driver_install(DM_UART_PORT, DM_UART_BUF_SIZE * 2, 0, 0, NULL, 0);
+    uart_driver_install(DM_UART_PORT, DM_UART_BUF_SIZE * 2, DM_UART_BUF_SIZE * 4,
+                        DM_UART_EVT_DEPTH, &s_uart_evt_queue, 0);
+}
+
+/* ── Display: esp_lcd SPI panel, DMA flush ─────────────────────────────── */
+
+static esp_lcd_panel_handle_t s_lcd_panel = NULL;
+
+/* SPI transaction done (ISR context): LVGL may reuse the buffer. */
+static bool lcd_trans_done(esp_lcd_panel_io_handle_t io,
+                           esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    (void)io;
+    (void)edata;
+    lv_display_flush_ready((lv_display_t *)user_ctx);
+    return false;
+}
 
-    /*
-     * TODO: Initialise your TFT display + touch driver here.
-     * Example (pseudo-code):
-     *   lv_init();
-     *   my_tft_init();
-     *   my_touch_init();
-     */
+/* Called by LVGL with the other buffer free; returns once DMA is queued. */
+static void lcd_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px)
+{
+    (void)disp;
+    /* The panel wants RGB565 MSB first; the SPI master sends bytes in memory order. */
+    lv_draw_sw_rgb565_swap(px, lv_area_get_size(area));
+    esp_lcd_panel_draw_bitmap(s_lcd_panel, area->x1, area->y1,
+                              area->x2 + 1, area->y2 + 1, px);
 }
 
-/* ── FreeRTOS task ───────────────────────────────────────────────────────── */
+static void lcd_init(void)
+{
+    const spi_bus_config_t bus = {
+        .sclk_io_num     = DM_LCD_SCK_PIN,
+        .mosi_io_num     = DM_LCD_MOSI_PIN,
+        .miso_io_num     = -1,
+        .quadwp_io_num   = -1,
+        .quadhd_io_num   = -1,
+        .max_transfer_sz = DM_LCD_WIDTH * DM_LCD_BUF_LINES * sizeof(uint16_t),
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(DM_LCD_HOST, &bus, SPI_DMA_CH_AUTO));
+
+    lv_init();
+    lv_tick_set_cb(esp32_millis);
+    lv_display_t *disp = lv_display_create(DM_LCD_WIDTH, DM_LCD_HEIGHT);
 
-static void hmic_task(void *arg)
+    esp_lcd_panel_io_handle_t io = NULL;
+    const esp_lcd_panel_io_spi_config_t io_cfg = {
+        .cs_gpio_num         = DM_LCD_CS_PIN,
+        .dc_gpio_num         = DM_LCD_DC_PIN,
+        .spi_mode            = 0,
+        .pclk_hz             = DM_LCD_PCLK_HZ,
+        .trans_queue_depth   = 2,
+        .on_color_trans_done = lcd_trans_done,
+        .user_ctx            = disp,
+        .lcd_cmd_bits        = 8,
+        .lcd_param_bits      = 8,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)DM_LCD_HOST,
+                                             &io_cfg, &io));
+
+    const esp_lcd_panel_dev_config_t panel_cfg = {
+        .reset_gpio_num = DM_LCD_RST_PIN,
+        .rgb_ele_order  = LCD_RGB_ELEMENT_ORDER_RGB,
+        .bits_per_pixel = 16,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_panel_st7789(io, &panel_cfg, &s_lcd_panel));
+    esp_lcd_panel_reset(s_lcd_panel);
+    esp_lcd_panel_init(s_lcd_panel);
+    esp_lcd_panel_invert_color(s_lcd_panel, true);
+    esp_lcd_panel_swap_xy(s_lcd_panel, true);            /* landscape */
+    esp_lcd_panel_mirror(s_lcd_panel, true, false);
+    esp_lcd_panel_disp_on_off(s_lcd_panel, true);
+
+    size_t buf_size = DM_LCD_WIDTH * DM_LCD_BUF_LINES * sizeof(uint16_t);
+    void *buf1 = heap_caps_malloc(buf_size, DM_LCD_BUF_CAPS);
+    void *buf2 = heap_caps_malloc(buf_size, DM_LCD_BUF_CAPS);
+    assert(buf1 && buf2);
+    lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(disp, buf1, buf2, buf_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, lcd_flush);
+}
+
+/* ── Screen-state store: "hmic_state" partition ─────────────────────────── */
+
+static const esp_partition_t *s_state_part = NULL;
+
+static bool state_read(uint32_t addr, void *buf, size_t len)
+{
+    return esp_partition_read(s_state_part, addr, buf, len) == ESP_OK;
+}
+
+static bool state_erase(uint32_t addr)
+{
+    return esp_partition_erase_range(s_state_part, addr, DM_STATE_SECTOR) == ESP_OK;
+}
+
+static bool state_program(uint32_t addr, const void *data, size_t len)
+{
+    /* The rest of the last 16-byte block stays erased (0xFF). */
+    return esp_partition_write(s_state_part, addr, data, len) == ESP_OK;
+}
+
+static dm_snapshot_store_t s_state_store = {
+    .sector_size = DM_STATE_SECTOR,
+    .prog_size   = 16,          /* Flash-encryption block */
+    .read        = state_read,
+    .erase       = state_erase,
+    .program     = state_program,
+};
+
+static void state_store_init(void)
+{
+    s_state_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                            ESP_PARTITION_SUBTYPE_ANY, DM_STATE_PART);
+    if (!s_state_part) {
+        ESP_LOGW(DM_TAG, "no \"%s\" partition: screen state not kept", DM_STATE_PART);
+        return;
+    }
+    uint32_t sectors = s_state_part->size / DM_STATE_SECTOR;
+    s_state_store.sector_count = (uint8_t)(sectors > 255 ? 255 : sectors);
+    dm_snapshot_set_store(&s_state_store);
+}
+
+static void dm_board_init(void)
+{
+    lcd_init();
+    state_store_init();
+}
+
+/* ── FreeRTOS tasks ──────────────────────────────────────────────────────── */
+
+/*
+ * Blocking time for a dm_process() / lv_timer_handler() result, rounded
+ * up to a whole tick.  With CONFIG_FREERTOS_USE_TICKLESS_IDLE the idle
+ * task then sleeps through long waits.
+ */
+static TickType_t wait_ticks(uint32_t wait_ms)
+{
+    if (wait_ms == DM_WAIT_FOREVER) return portMAX_DELAY;
+    TickType_t t = pdMS_TO_TICKS(wait_ms);
+    return (t == 0 && wait_ms > 0) ? 1 : t;
+}
+
+/* A queued event / RX bytes: run dm_process() now. */
+static void proto_wake(void)
+{
+    if (s_proto_task) xTaskNotifyGive(s_proto_task);
+}
+
+/* Sole producer of the core RX ring. */
+static void hmic_rx_task(void *arg)
 {
     (void)arg;
     uint8_t buf[64];
+    uart_event_t evt;
+
+    while (1) {
+        if (!xQueueReceive(s_uart_evt_queue, &evt, portMAX_DELAY)) continue;
+
+        switch (evt.type) {
+        case UART_DATA: {
+            size_t pending = evt.size;
+            while (pending > 0) {
+                size_t chunk = pending < sizeof(buf) ? pending : sizeof(buf);
+                int len = uart_read_bytes(DM_UART_PORT, buf, chunk, 0);
+                if (len <= 0) break;
+                dm_rx_write(buf, (size_t)len);
+                pending -= (size_t)len;
+            }
+            proto_wake();
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uart_flush_input(DM_UART_PORT);
+            xQueueReset(s_uart_evt_queue);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+#ifdef HMIC_BENCH_AT_BOOT
+static uint32_t esp32_cycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+/* CPU cycle counter of the core running hmic_task. */
+static void bench_at_boot(void)
+{
+    const dm_bench_t b = {
+        .now   = esp32_cycles,
+        .hz    = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000u,
+        .unit  = "cyc",
+        .print = esp32_log,
+    };
+    dm_bench_run_all(&b);
+}
+#endif
+
+#if DM_UI_SPLIT
+static TaskHandle_t s_ui_task = NULL;
+
+/* Queued widget commands: render them without waiting out the sleep. */
+static void ui_wake(void)
+{
+    xTaskNotifyGive(s_ui_task);
+}
+
+/* Protocol core: everything between the UART and the UI queue. */
+static void hmic_proto_task(void *arg)
+{
+    (void)arg;
+
+    esp32_uart_init();
+    xTaskCreatePinnedToCore(hmic_rx_task, "hmic_rx", 3072, NULL, 6, NULL, DM_PROTO_CORE);
+
+    while (1) {
+        dm_uiq_poll_events();
+        ulTaskNotifyTake(pdTRUE, wait_ticks(dm_process()));
+    }
+}
+#endif
+
+static void hmic_task(void *arg)
+{
+    (void)arg;
 
     dm_board_init();
+#ifdef HMIC_BENCH_AT_BOOT
+    bench_at_boot();
+#endif
     dm_init(&s_platform);
-    dm_binder_init(&s_platform);
+    dm_binder_init();
+
+#if DM_UI_SPLIT
+    s_ui_task = xTaskGetCurrentTaskHandle();
+    dm_uiq_set_wake(ui_wake);
+    dm_uiq_set_event_wake(proto_wake);
+    xTaskCreatePinnedToCore(hmic_proto_task, "hmic_proto", 4096, NULL, 6,
+                            &s_proto_task, DM_PROTO_CORE);
 
     while (1) {
-        int len = uart_read_bytes(DM_UART_PORT, buf, sizeof(buf),
-                                  pdMS_TO_TICKS(5));
-        for (int i = 0; i < len; i++) {
-            dm_receive_byte(buf[i]);
-        }
+        dm_uiq_apply();
+
+        uint32_t t    = dm_micros();
+        uint32_t wait = lv_timer_handler();
+        dm_uiq_render_time(t);
+
+        ulTaskNotifyTake(pdTRUE, wait_ticks(wait));
+    }
+#else
+    esp32_uart_init();
+    s_proto_task = xTaskGetCurrentTaskHandle();
+    xTaskCreate(hmic_rx_task, "hmic_rx", 3072, NULL, 6, NULL);
+
+    while (1) {
+        uint32_t wait = dm_process();
 
-        dm_process();
-        /* lv_timer_handler(); */  /* Uncomment when LVGL is initialised */
+        uint32_t t    = dm_micros();
+        uint32_t next = lv_timer_handler();
+        dm_render_time(t);
+        if (next < wait) wait = next;
 
-        vTaskDelay(pdMS_TO_TICKS(5));
+        ulTaskNotifyTake(pdTRUE, wait_ticks(wait));
     }
+#endif
 }
 
 void app_main(void)
 {
+#if DM_UI_SPLIT
+    xTaskCreatePinnedToCore(hmic_task, "hmic", 8192, NULL, 5, NULL, DM_UI_CORE);
+#else
     xTaskCreate(hmic_task, "hmic", 8192, NULL, 5, NULL);
+#endif
 }
@@ -0,0 +1,18 @@
+/**
+ * @file lv_conf_board.h
+ * @brief LVGL overlay for the ESP32-S3 (see app/ui/lv_conf.h).
+ *
+ * RGB565; the render buffers come from heap_caps_malloc() in
+ * hal_esp32.c (internal DMA RAM, or PSRAM with DM_LCD_BUF_PSRAM), not
+ * from this heap.  Xtensa has no LVGL assembly back end, and the PPA
+ * draw unit is an ESP32-P4 peripheral.
+ */
+#ifndef LV_CONF_BOARD_H
+#define LV_CONF_BOARD_H
+
+#define LV_COLOR_DEPTH      16
+#define LV_MEM_SIZE         (64 * 1024U)
+#define LV_USE_DRAW_SW_ASM  LV_DRAW_SW_ASM_NONE
+#define LV_LOG_LEVEL        LV_LOG_LEVEL_WARN
+
+#endif /* LV_CONF_BOARD_H */
@@ -6,22 +6,53 @@
  *
  * Wiring assumptions:
  *   - UART0 (pins 0/1) at DM_UART_BAUDRATE – used for RS485 or direct UART.
+ *   - RS485: define DM_RS485_DE_PIN as the transceiver's DE (and /RE) pin.
  *   - Adjust TX/RX pins and UART instance as needed for your hardware.
  *
- * LVGL display and touch drivers are initialised in dm_board_init().
- * Adapt the display section for your specific TFT + touch controller.
+ * Display: an ST7789-class SPI panel on SPI0 (pins in Config).  LVGL
+ * renders into one of two partial buffers while DMA sends the other in
+ * 16-bit SPI frames (RGB565 goes out MSB first, no byte swap).  The DMA
+ * interrupt hands the buffer back with lv_display_flush_ready().  Touch
+ * is left to the board: add an lv_indev in lcd_init().
+ *
+ * Screen state (dm_snapshot) lives in the last DM_STATE_SECTORS flash
+ * sectors, written through flash_safe_execute(): the other core is
+ * parked and interrupts are off for the ~50 ms of a 4 KB erase, which
+ * happens only once the screen has been quiet for DM_SNAPSHOT_SETTLE_MS.
+ * The RX interrupt cannot run meanwhile and the 32-byte UART FIFO fills
+ * in ~3 ms at 115200 Bd, so bytes after that are lost.  The frames they
+ * belonged to fail their CRC or expire, and the host's retransmit (well
+ * inside HMIC_HOST_TIMEOUT_MS × HMIC_HOST_RETRIES) brings them again.
+ *
+ * HMIC_UI_SPLIT (DM_UI_SPLIT): core 1 owns the UART and DMA interrupts,
+ * parsing and ACKs; core 0 only applies queued widget commands and runs
+ * LVGL, so ACK latency does not depend on render time.
  */
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
 #include "hardware/timer.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
 #include "pico/stdio.h"
+#include "pico/multicore.h"
 
 #include <stdio.h>
 #include <string.h>
 
 #include "../../core/dm_core.h"
 #include "../../core/dm_platform.h"
+#include "../../core/crc16.h"
 #include "../../app/dm_binder.h"
+#include "../../app/dm_ui_queue.h"
+#include "../../app/dm_snapshot.h"
+#include "../common/lcd_dcs.h"
+#include "lvgl.h"
+#ifdef HMIC_BENCH_AT_BOOT
+#include "../../bench/dm_bench.h"
+#endif
 
 /* ── Config ──────────────────────────────────────────────────────────────── */
 
@@ -30,6 +61,23 @@
 #define DM_UART_RX_PIN   1
 #define DM_UART_BAUDRATE 115200
 
+#define DM_LCD_SPI       spi0
+#define DM_LCD_SCK_PIN   18
+#define DM_LCD_MOSI_PIN  19
+#define DM_LCD_CS_PIN    17
+#define DM_LCD_DC_PIN    20
+#define DM_LCD_RST_PIN   21
+#define DM_LCD_BAUDRATE  (62500 * 1000)   /* clk_peri / 2 */
+#define DM_LCD_WIDTH     320
+#define DM_LCD_HEIGHT    240
+#define DM_LCD_MADCTL    (LCD_DCS_MADCTL_MV | LCD_DCS_MADCTL_MX)   /* landscape */
+/* Lines per partial buffer; two of them: 2 × 320 × 24 × 2 B = 30 KB */
+#define DM_LCD_BUF_LINES 24
+
+/* Screen-state snapshot: the last sectors of flash (keep the image clear of them) */
+#define DM_STATE_SECTORS 4
+#define DM_STATE_OFFSET  (PICO_FLASH_SIZE_BYTES - DM_STATE_SECTORS * FLASH_SECTOR_SIZE)
+
 /* ── Platform function implementations ───────────────────────────────────── */
 
 static void rp2040_write_bytes(const uint8_t *data, uint16_t len)
@@ -37,23 +85,285 @@ static void rp2040_write_bytes(const uint8_t *data, uint16_t len)
     uart_write_blocking(DM_UART_INSTANCE, data, len);
 }
 
+/* ── TX path: DMA into the UART TX FIFO ─────────────────────────────────── */
+
+static int s_tx_dma_chan = -1;
+
+static void rp2040_tx_dma_isr(void)
+{
+    if (dma_channel_get_irq0_status(s_tx_dma_chan)) {
+        dma_channel_acknowledge_irq0(s_tx_dma_chan);
+        dm_tx_complete();
+    }
+}
+
+static void rp2040_tx_dma_init(void)
+{
+    s_tx_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(s_tx_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(DM_UART_INSTANCE, true));
+    dma_channel_configure(s_tx_dma_chan, &c,
+                          &uart_get_hw(DM_UART_INSTANCE)->dr, NULL, 0, false);
+}
+
+/* IRQs are per core: call on the core that runs dm_process(). */
+static void rp2040_tx_dma_irq_init(void)
+{
+    dma_channel_set_irq0_enabled(s_tx_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, rp2040_tx_dma_isr,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+}
+
+static void rp2040_write_async(const uint8_t *data, uint16_t len)
+{
+    dma_channel_transfer_from_buffer_now(s_tx_dma_chan, data, len);
+}
+
+#ifdef DM_RS485_DE_PIN
+/* ── RS485 driver enable ────────────────────────────────────────────────── */
+
+static void rp2040_bus_tx_enable(bool enable)
+{
+    /* DMA is done once the FIFO holds the tail: let it drain first. */
+    if (!enable) uart_tx_wait_blocking(DM_UART_INSTANCE);
+    gpio_put(DM_RS485_DE_PIN, enable);
+}
+#endif
+
 static uint32_t rp2040_millis(void)
 {
     return (uint32_t)(time_us_64() / 1000ULL);
 }
 
+static uint32_t rp2040_micros(void)
+{
+    return time_us_32();
+}
+
 static void rp2040_log(const char *msg)
 {
     /* Routed to stdio (USB or UART depending on CMake config) */
     puts(msg);
 }
 
+/* ── Hardware CRC backend (DMA sniffer) ──────────────────────────────────── */
+
+#if DM_CRC_ENGINE == DM_CRC_ENGINE_HW
+#define DMA_SNIFF_CALC_CRC16_CCITT 0x2
+
+static int     s_crc_dma_chan = -1;
+static uint8_t s_crc_dma_sink;
+
+static void crc_dma_init(void)
+{
+    s_crc_dma_chan = dma_claim_unused_channel(true);
+}
+
+uint16_t crc16_hw_update(uint16_t crc, const uint8_t *data, size_t length)
+{
+    dma_channel_config c = dma_channel_get_default_config(s_crc_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_sniff_enable(&c, true);
+
+    /* MSB-first CRC-16-CCITT, no bit reversal, no output inversion */
+    dma_sniffer_enable(s_crc_dma_chan, DMA_SNIFF_CALC_CRC16_CCITT, true);
+    dma_hw->sniff_data = crc;
+
+    dma_channel_configure(s_crc_dma_chan, &c, &s_crc_dma_sink, data,
+                          length, true);
+    dma_channel_wait_for_finish_blocking(s_crc_dma_chan);
+    dma_sniffer_disable();
+
+    return (uint16_t)dma_hw->sniff_data;
+}
+#endif
+
+/* ── RX path: UART interrupt → core RX ring ──────────────────────────────── */
+
+/* Fires on RX FIFO threshold and RX timeout; drains the whole FIFO. */
+static void rp2040_uart_rx_isr(void)
+{
+    uint8_t buf[32];
+    size_t  n = 0;
+    while (uart_is_readable(DM_UART_INSTANCE)) {
+        buf[n++] = (uint8_t)uart_getc(DM_UART_INSTANCE);
+        if (n == sizeof(buf)) {
+            dm_rx_write(buf, n);
+            n = 0;
+        }
+    }
+    if (n > 0) dm_rx_write(buf, n);
+}
+
+static void rp2040_uart_rx_irq_init(void)
+{
+    int irq = (DM_UART_INSTANCE == uart0) ? UART0_IRQ : UART1_IRQ;
+    irq_set_exclusive_handler(irq, rp2040_uart_rx_isr);
+    irq_set_enabled(irq, true);
+    uart_set_irq_enables(DM_UART_INSTANCE, true, false);
+}
+
 /* ── Platform struct ─────────────────────────────────────────────────────── */
 
 static dm_platform_t s_platform = {
     .write_bytes = rp2040_write_bytes,
+    .write_async = rp2040_write_async,
     .millis      = rp2040_millis,
+    .micros      = rp2040_micros,
     .log         = rp2040_log,
+#ifdef DM_RS485_DE_PIN
+    .bus_tx_enable = rp2040_bus_tx_enable,
+#endif
+};
+
+/* ── Display: SPI panel, DMA flush ──────────────────────────────────────── */
+
+static uint16_t      s_lcd_buf[2][DM_LCD_WIDTH * DM_LCD_BUF_LINES];
+static int           s_lcd_dma_chan = -1;
+static lv_display_t *s_lcd_disp = NULL;
+
+/* A command and its parameters, in 8-bit frames (no DMA: a few bytes). */
+static void lcd_cmd(uint8_t cmd, const uint8_t *data, size_t n)
+{
+    while (spi_is_busy(DM_LCD_SPI)) {}      /* last pixels still shifting out */
+    spi_set_format(DM_LCD_SPI, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    gpio_put(DM_LCD_DC_PIN, 0);
+    spi_write_blocking(DM_LCD_SPI, &cmd, 1);
+    gpio_put(DM_LCD_DC_PIN, 1);
+    if (n > 0) spi_write_blocking(DM_LCD_SPI, data, n);
+}
+
+/* Called by LVGL with the other buffer free; returns once DMA is running. */
+static void lcd_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px)
+{
+    (void)disp;
+    uint8_t win[4];
+    lcd_dcs_window(win, (uint16_t)area->x1, (uint16_t)area->x2);
+    lcd_cmd(LCD_DCS_CASET, win, sizeof(win));
+    lcd_dcs_window(win, (uint16_t)area->y1, (uint16_t)area->y2);
+    lcd_cmd(LCD_DCS_RASET, win, sizeof(win));
+    lcd_cmd(LCD_DCS_RAMWR, NULL, 0);
+
+    spi_set_format(DM_LCD_SPI, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    dma_channel_transfer_from_buffer_now(s_lcd_dma_chan, px, lv_area_get_size(area));
+}
+
+static void lcd_dma_isr(void)
+{
+    if (dma_channel_get_irq1_status(s_lcd_dma_chan)) {
+        dma_channel_acknowledge_irq1(s_lcd_dma_chan);
+        lv_display_flush_ready(s_lcd_disp);
+    }
+}
+
+/*
+ * Runs on core 0 with LVGL.  DMA_IRQ_1 keeps the flush interrupt apart
+ * from the UART TX one (DMA_IRQ_0), which in split mode is core 1's.
+ */
+static void lcd_init(void)
+{
+    spi_init(DM_LCD_SPI, DM_LCD_BAUDRATE);
+    gpio_set_function(DM_LCD_SCK_PIN, GPIO_FUNC_SPI);
+    gpio_set_function(DM_LCD_MOSI_PIN, GPIO_FUNC_SPI);
+    gpio_init(DM_LCD_CS_PIN);
+    gpio_set_dir(DM_LCD_CS_PIN, GPIO_OUT);
+    gpio_put(DM_LCD_CS_PIN, 0);             /* only device on the bus */
+    gpio_init(DM_LCD_DC_PIN);
+    gpio_set_dir(DM_LCD_DC_PIN, GPIO_OUT);
+    gpio_init(DM_LCD_RST_PIN);
+    gpio_set_dir(DM_LCD_RST_PIN, GPIO_OUT);
+    gpio_put(DM_LCD_RST_PIN, 0);
+    sleep_ms(10);
+    gpio_put(DM_LCD_RST_PIN, 1);
+    sleep_ms(LCD_DCS_RESET_MS);
+
+    static const lcd_dcs_step_t init[] = LCD_DCS_INIT_SEQUENCE(DM_LCD_MADCTL);
+    for (size_t i = 0; i < sizeof(init) / sizeof(init[0]); i++) {
+        lcd_cmd(init[i].cmd, init[i].data, init[i].n);
+        if (init[i].delay_ms) sleep_ms(init[i].delay_ms);
+    }
+
+    s_lcd_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(s_lcd_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(DM_LCD_SPI, true));
+    dma_channel_configure(s_lcd_dma_chan, &c, &spi_get_hw(DM_LCD_SPI)->dr, NULL, 0, false);
+    dma_channel_set_irq1_enabled(s_lcd_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_1, lcd_dma_isr,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    lv_init();
+    lv_tick_set_cb(rp2040_millis);
+    s_lcd_disp = lv_display_create(DM_LCD_WIDTH, DM_LCD_HEIGHT);
+    lv_display_set_color_format(s_lcd_disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(s_lcd_disp, s_lcd_buf[0], s_lcd_buf[1], sizeof(s_lcd_buf[0]),
+                           LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(s_lcd_disp, lcd_flush);
+}
+
+/* ── Screen-state store: last flash sectors ─────────────────────────────── */
+
+typedef struct {
+    uint32_t       addr;
+    const uint8_t *data;
+    size_t         len;
+} flash_op_t;
+
+static void flash_erase_op(void *param)
+{
+    const flash_op_t *op = param;
+    flash_range_erase(DM_STATE_OFFSET + op->addr, FLASH_SECTOR_SIZE);
+}
+
+static void flash_program_op(void *param)
+{
+    const flash_op_t *op = param;
+    static uint8_t page[FLASH_PAGE_SIZE];
+
+    /* Whole pages only: the tail goes out of a 0xFF-padded copy. */
+    size_t whole = op->len & ~(size_t)(FLASH_PAGE_SIZE - 1);
+    if (whole) flash_range_program(DM_STATE_OFFSET + op->addr, op->data, whole);
+    if (whole < op->len) {
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page, op->data + whole, op->len - whole);
+        flash_range_program(DM_STATE_OFFSET + op->addr + whole, page, sizeof(page));
+    }
+}
+
+static bool state_read(uint32_t addr, void *buf, size_t len)
+{
+    memcpy(buf, (const void *)(XIP_BASE + DM_STATE_OFFSET + addr), len);
+    return true;
+}
+
+static bool state_erase(uint32_t addr)
+{
+    flash_op_t op = { .addr = addr };
+    return flash_safe_execute(flash_erase_op, &op, 100) == PICO_OK;
+}
+
+static bool state_program(uint32_t addr, const void *data, size_t len)
+{
+    flash_op_t op = { .addr = addr, .data = data, .len = len };
+    return flash_safe_execute(flash_program_op, &op, 100) == PICO_OK;
+}
+
+static const dm_snapshot_store_t s_state_store = {
+    .sector_size  = FLASH_SECTOR_SIZE,
+    .sector_count = DM_STATE_SECTORS,
+    .prog_size    = FLASH_PAGE_SIZE,
+    .read         = state_read,
+    .erase        = state_erase,
+    .program      = state_program,
 };
 
 /* ── Board init ──────────────────────────────────────────────────────────── */
@@ -66,41 +376,123 @@ static void dm_board_init(void)
     uart_init(DM_UART_INSTANCE, DM_UART_BAUDRATE);
     gpio_set_function(DM_UART_TX_PIN, GPIO_FUNC_UART);
     gpio_set_function(DM_UART_RX_PIN, GPIO_FUNC_UART);
+#ifdef DM_RS485_DE_PIN
+    gpio_init(DM_RS485_DE_PIN);
+    gpio_set_dir(DM_RS485_DE_PIN, GPIO_OUT);
+    gpio_put(DM_RS485_DE_PIN, 0);       /* receive until we have something to say */
+#endif
+
+    rp2040_tx_dma_init();
+
+#if DM_CRC_ENGINE == DM_CRC_ENGINE_HW
+    crc_dma_init();
+#endif
+
+    lcd_init();
+    dm_snapshot_set_store(&s_state_store);
+}
+
+/* ── Boot benchmark ──────────────────────────────────────────────────────── */
 
-    /*
-     * TODO: Initialise your TFT display + touch driver here.
-     * Example (pseudo-code):
-     *   lv_init();
-     *   my_tft_init();
-     *   my_touch_init();
-     *   lv_display_t *disp = lv_display_create(...);
-     *   lv_indev_t   *indev = lv_indev_create(...);
-     */
+#ifdef HMIC_BENCH_AT_BOOT
+/*
+ * The Cortex-M0+ has no cycle counter (no DWT); the 1 MHz timer is good
+ * enough because the runner adds up many short passes.
+ */
+static void bench_at_boot(void)
+{
+    const dm_bench_t b = {
+        .now   = time_us_32,
+        .hz    = 1000000u,
+        .unit  = "us",
+        .print = rp2040_log,
+    };
+    dm_bench_run_all(&b);
 }
+#endif
 
 /* ── Main entry ──────────────────────────────────────────────────────────── */
 
+/*
+ * Sleep until @p wait_ms has passed, an interrupt fires (UART RX, TX DMA)
+ * or the other core calls __sev().  An interrupt taken since the last
+ * dm_process() has already set the event flag, so WFE returns at once.
+ */
+static void rp2040_sleep(uint32_t wait_ms)
+{
+    if (wait_ms == 0) return;
+    if (wait_ms == DM_WAIT_FOREVER) {
+        __wfe();
+        return;
+    }
+    best_effort_wfe_or_timeout(make_timeout_time_ms(wait_ms));
+}
+
+/* RX is interrupt driven from here on; dm_process() drains the ring. */
+static void protocol_irq_init(void)
+{
+    rp2040_tx_dma_irq_init();
+    rp2040_uart_rx_irq_init();
+}
+
+#if DM_UI_SPLIT
+/* Core 1: everything between the UART and the UI queue. */
+static void protocol_core(void)
+{
+    /* Lets core 0 park this core while it erases or programs flash. */
+    flash_safe_execute_core_init();
+    protocol_irq_init();
+    while (true) {
+        dm_uiq_poll_events();
+        rp2040_sleep(dm_process());
+    }
+}
+#endif
+
 int main(void)
 {
     dm_board_init();
 
+#ifdef HMIC_BENCH_AT_BOOT
+    bench_at_boot();
+#endif
+
     /* Initialise core and app binder */
     dm_init(&s_platform);
-    dm_binder_init(&s_platform);
+    dm_binder_init();
 
-    /* Main loop */
+#if DM_UI_SPLIT
+    /* Each core wakes the other when it queues something. */
+    dm_uiq_set_wake(__sev);
+    dm_uiq_set_event_wake(__sev);
+    multicore_launch_core1(protocol_core);
+
+    /* Core 0: widget commands queued by core 1, then LVGL */
     while (true) {
-        /* Feed incoming UART bytes */
-        while (uart_is_readable(DM_UART_INSTANCE)) {
-            uint8_t b = uart_getc(DM_UART_INSTANCE);
-            dm_receive_byte(b);
-        }
+        dm_uiq_apply();
+
+        uint32_t t    = dm_micros();
+        uint32_t wait = lv_timer_handler();
+        dm_uiq_render_time(t);
+
+        rp2040_sleep(wait);
+    }
+#else
+    protocol_irq_init();
+
+    /* Main loop: sleep until the next core or LVGL deadline */
+    while (true) {
+        uint32_t wait = dm_process();
 
-        dm_process();
+        /* lv_timer_handler drives LVGL animations and redraws (timed for stats) */
+        uint32_t t    = dm_micros();
+        uint32_t next = lv_timer_handler();
+        dm_render_time(t);
+        if (next < wait) wait = next;
 
-        /* lv_timer_handler drives LVGL animations and redraws */
-        /* lv_timer_handler(); */  /* Uncomment when LVGL is initialised */
+        rp2040_sleep(wait);
     }
+#endif
 
     return 0;
 }
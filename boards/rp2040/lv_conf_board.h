@@ -0,0 +1,18 @@
+/**
+ * @file lv_conf_board.h
+ * @brief LVGL overlay for the RP2040 (see app/ui/lv_conf.h).
+ *
+ * RGB565, sent over SPI in 16-bit frames so no byte swap is needed.  The
+ * heap is kept small: the two partial render buffers (hal_rp2040.c) live
+ * outside it in the 264 KB SRAM.  The Cortex-M0+ has no SIMD, so
+ * drawing stays in C.
+ */
+#ifndef LV_CONF_BOARD_H
+#define LV_CONF_BOARD_H
+
+#define LV_COLOR_DEPTH      16
+#define LV_MEM_SIZE         (48 * 1024U)
+#define LV_USE_DRAW_SW_ASM  LV_DRAW_SW_ASM_NONE
+#define LV_LOG_LEVEL        LV_LOG_LEVEL_WARN
+
+#endif /* LV_CONF_BOARD_H */
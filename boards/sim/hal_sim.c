@@ -4,28 +4,51 @@
  *
  * Allows developing and testing the core library and UI on a PC without
  * any hardware.  Uses:
- *   - POSIX UART (serial port or pty) for protocol bytes.
- *   - LVGL SDL2 backend for display.
- *   - POSIX clock_gettime for the millisecond counter.
+ *   - A serial port, a pty, or a TCP / Unix socket for protocol bytes.
+ *   - LVGL SDL2 backend for display, or an off-screen framebuffer
+ *     (--headless) for CI and load tests.
+ *   - POSIX clock_gettime for the millisecond / microsecond counters.
+ *   - A file (--state) as the flash region for the screen-state snapshot.
+ *
+ * The main loop blocks in poll() until input arrives or the next core
+ * deadline, LVGL timer or TX completion is due, so an idle simulator uses
+ * no CPU and a busy one is not held back by a fixed tick.  On a pty or socket the
+ * link is paced at a virtual baud rate (--baud, 0 = as fast as the host
+ * can push); transmits go through write_async and complete after the
+ * time the bytes would take on the wire, like a DMA UART.
  *
  * Build:
  *   cmake -B build-sim -DHMIC_BOARD=sim
  *   cmake --build build-sim
  *   ./build-sim/hmic_sim --port /dev/pts/3
+ *   ./build-sim/hmic_sim --headless --listen tcp:7000 --baud 0
  */
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
 #include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <termios.h>
 #include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include "../../core/dm_core.h"
 #include "../../core/dm_platform.h"
+#include "../../core/dm_trace.h"
 #include "../../app/dm_binder.h"
+#include "../../app/dm_snapshot.h"
 
 /* LVGL + SDL backend – provided by the sim CMakeLists */
 #include "lvgl/lvgl.h"
@@ -35,35 +58,188 @@
 #define SIM_DISPLAY_WIDTH  800
 #define SIM_DISPLAY_HEIGHT 480
 
-/* ── Serial port state ────────────────────────────────────────────────────── */
+/* Most bytes read from the link per loop pass (before LVGL gets a turn). */
+#define SIM_RX_CHUNK       512
+
+/* Default virtual baud rate of pty / socket links. */
+#define SIM_DEFAULT_BAUD   115200
+
+/* --state file geometry (like a small SPI NOR region) */
+#define SIM_STATE_SECTOR   4096
+#define SIM_STATE_SECTORS  4
+
+/* ── Link state ──────────────────────────────────────────────────────────── */
 
-static int s_serial_fd = -1;
+typedef enum {
+    LINK_NONE,      /* loopback: TX printed as hex, no RX */
+    LINK_SERIAL,    /* real UART: the driver does the timing */
+    LINK_PTY,
+    LINK_SOCKET,
+} link_kind_t;
 
-static int open_serial(const char *port, int baud)
+static link_kind_t s_link_kind   = LINK_NONE;
+static int         s_link_fd     = -1;  /* Serial, pty master or connected client */
+static int         s_listen_fd   = -1;  /* Listening socket (LINK_SOCKET) */
+static int         s_pty_slave   = -1;  /* Kept open so the master never sees HUP */
+static uint32_t    s_baud        = SIM_DEFAULT_BAUD;
+
+/* Virtual line timing (LINK_PTY / LINK_SOCKET with s_baud > 0). */
+static uint64_t       s_rx_free_us = 0;     /* Line may deliver more bytes from here */
+static const uint8_t *s_tx_data    = NULL;  /* Transfer on the virtual wire */
+static uint16_t       s_tx_len     = 0;
+static uint64_t       s_tx_done_us = 0;
+
+static uint64_t now_us(void)
 {
-    int fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
-    if (fd < 0) return -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static bool link_paced(void)
+{
+    return s_baud > 0 && (s_link_kind == LINK_PTY || s_link_kind == LINK_SOCKET);
+}
+
+/* Time @p n bytes take on the line (8N1: 10 bits per byte). */
+static uint64_t wire_us(size_t n)
+{
+    return (uint64_t)n * 10000000ULL / s_baud;
+}
+
+static speed_t baud_to_speed(uint32_t baud)
+{
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+    default:     return B115200;
+    }
+}
 
+static void set_raw(int fd, uint32_t baud)
+{
     struct termios tty;
     tcgetattr(fd, &tty);
-    cfsetspeed(&tty, baud);
-    tty.c_cflag = CS8 | CREAD | CLOCAL;
-    tty.c_iflag = 0;
-    tty.c_oflag = 0;
-    tty.c_lflag = 0;
+    cfmakeraw(&tty);
+    cfsetspeed(&tty, baud_to_speed(baud));
+    tty.c_cflag |= CREAD | CLOCAL;
     tty.c_cc[VMIN]  = 0;
     tty.c_cc[VTIME] = 0;
     tcsetattr(fd, TCSANOW, &tty);
+}
+
+static int open_serial(const char *port, uint32_t baud)
+{
+    int fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return -1;
+    set_raw(fd, baud);
+    fcntl(fd, F_SETFL, 0);      /* poll() decides when to read; writes block */
+    return fd;
+}
+
+/* Create a pty pair; the host opens the slave path printed here. */
+static int open_pty(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    const char *name = ptsname(fd);
+    s_pty_slave = name ? open(name, O_RDWR | O_NOCTTY) : -1;
+    if (s_pty_slave < 0) {
+        close(fd);
+        return -1;
+    }
+    set_raw(s_pty_slave, SIM_DEFAULT_BAUD);
+    fcntl(fd, F_SETFL, O_NONBLOCK);     /* nobody on the slave: TX is dropped, not blocked */
+    printf("[SIM] pty: %s\n", name);
     return fd;
 }
 
+/* "tcp:PORT" (loopback interface) or "unix:PATH". */
+static int open_listener(const char *spec)
+{
+    int fd = -1;
+
+    if (strncmp(spec, "tcp:", 4) == 0) {
+        struct sockaddr_in a;
+        int one = 1;
+        memset(&a, 0, sizeof(a));
+        a.sin_family      = AF_INET;
+        a.sin_port        = htons((uint16_t)atoi(spec + 4));
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&a, sizeof(a)) < 0) goto fail;
+    } else if (strncmp(spec, "unix:", 5) == 0) {
+        struct sockaddr_un a;
+        memset(&a, 0, sizeof(a));
+        a.sun_family = AF_UNIX;
+        strncpy(a.sun_path, spec + 5, sizeof(a.sun_path) - 1);
+        unlink(a.sun_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (bind(fd, (struct sockaddr *)&a, sizeof(a)) < 0) goto fail;
+    } else {
+        errno = EINVAL;
+        return -1;
+    }
+    if (listen(fd, 1) < 0) goto fail;
+    printf("[SIM] Listening on %s\n", spec);
+    return fd;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+/* A new client replaces the current one (host restarted). */
+static void accept_client(void)
+{
+    int fd = accept(s_listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    if (s_link_fd >= 0) close(s_link_fd);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   /* fails harmlessly on AF_UNIX */
+    s_link_fd    = fd;
+    s_rx_free_us = 0;
+    printf("[SIM] Host connected\n");
+}
+
+static void drop_client(void)
+{
+    close(s_link_fd);
+    s_link_fd = -1;
+    printf("[SIM] Host disconnected\n");
+}
+
 /* ── Platform implementations ─────────────────────────────────────────────── */
 
 static void sim_write_bytes(const uint8_t *data, uint16_t len)
 {
-    if (s_serial_fd >= 0) {
-        write(s_serial_fd, data, len);
-    } else {
+    if (s_link_fd >= 0) {
+        while (len > 0) {
+            ssize_t n = write(s_link_fd, data, len);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                break;              /* host gone: the bytes are lost, as on a wire */
+            }
+            data += n;
+            len  -= (uint16_t)n;
+        }
+    } else if (s_link_kind == LINK_NONE) {
         /* Loopback when no serial port: print hex to stdout */
         printf("[TX] ");
         for (uint16_t i = 0; i < len; i++) printf("%02X ", data[i]);
@@ -71,6 +247,32 @@ static void sim_write_bytes(const uint8_t *data, uint16_t len)
     }
 }
 
+/*
+ * Paced links hold the transfer for its wire time and then write it out
+ * and complete it from the main loop – the host sees the same latency as
+ * from a DMA UART.  Unpaced links complete at once.
+ */
+static void sim_write_async(const uint8_t *data, uint16_t len)
+{
+    if (!link_paced()) {
+        sim_write_bytes(data, len);
+        dm_tx_complete();
+        return;
+    }
+    s_tx_data    = data;
+    s_tx_len     = len;
+    s_tx_done_us = now_us() + wire_us(len);
+}
+
+static void sim_tx_service(uint64_t now)
+{
+    if (!s_tx_data || now < s_tx_done_us) return;
+    const uint8_t *data = s_tx_data;
+    s_tx_data = NULL;
+    sim_write_bytes(data, s_tx_len);
+    dm_tx_complete();
+}
+
 static uint32_t sim_millis(void)
 {
     struct timespec ts;
@@ -78,6 +280,13 @@ static uint32_t sim_millis(void)
     return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
 }
 
+static uint32_t sim_micros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
 static void sim_log(const char *msg)
 {
     printf("[DM] %s\n", msg);
@@ -87,61 +296,298 @@ static void sim_log(const char *msg)
 
 static dm_platform_t s_platform = {
     .write_bytes = sim_write_bytes,
+    .write_async = sim_write_async,
     .millis      = sim_millis,
+    .micros      = sim_micros,
     .log         = sim_log,
 };
 
+/* ── RX path ─────────────────────────────────────────────────────────────── */
+
+/*
+ * Read what the line may deliver by now and parse it in place.  On a
+ * paced link at most ~1 ms of line time is taken per pass, so bytes are
+ * handed over at the rate (and granularity) a real UART would.
+ */
+static void sim_rx_service(uint64_t now)
+{
+    size_t max = SIM_RX_CHUNK;
+
+    if (link_paced()) {
+        if (now < s_rx_free_us) return;
+        size_t per_ms = s_baud / 10000U;
+        max = per_ms == 0 ? 1 : (per_ms < SIM_RX_CHUNK ? per_ms : SIM_RX_CHUNK);
+    }
+
+    uint8_t buf[SIM_RX_CHUNK];
+    ssize_t n = read(s_link_fd, buf, max);
+    if (n > 0) {
+        dm_receive_bytes(buf, (size_t)n);
+        if (link_paced()) {
+            s_rx_free_us = (s_rx_free_us > now ? s_rx_free_us : now) + wire_us((size_t)n);
+        }
+    } else if (s_link_kind == LINK_SOCKET &&
+               (n == 0 || (errno != EINTR && errno != EAGAIN))) {
+        drop_client();
+    }
+}
+
+/* Wait for input, a new client, or @p wait_ms – whichever comes first. */
+static void sim_wait(uint32_t wait_ms, uint64_t now)
+{
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+    int    link = -1, lst = -1;
+
+    if (s_tx_data) {
+        uint64_t ms = s_tx_done_us > now ? (s_tx_done_us - now + 999) / 1000 : 0;
+        if (ms < wait_ms) wait_ms = (uint32_t)ms;
+    }
+    if (s_link_fd >= 0) {
+        if (link_paced() && now < s_rx_free_us) {
+            /* Line still busy with earlier bytes: come back when it is free. */
+            uint64_t ms = (s_rx_free_us - now + 999) / 1000;
+            if (ms < wait_ms) wait_ms = (uint32_t)ms;
+        } else {
+            fds[nfds].fd     = s_link_fd;
+            fds[nfds].events = POLLIN;
+            link = (int)nfds++;
+        }
+    }
+    if (s_listen_fd >= 0) {
+        fds[nfds].fd     = s_listen_fd;
+        fds[nfds].events = POLLIN;
+        lst = (int)nfds++;
+    }
+
+    int timeout = wait_ms > INT_MAX ? -1 : (int)wait_ms;   /* DM_WAIT_FOREVER */
+    if (poll(fds, nfds, timeout) <= 0) return;
+
+    now = now_us();
+    if (link >= 0 && (fds[link].revents & (POLLIN | POLLHUP | POLLERR))) sim_rx_service(now);
+    if (lst >= 0 && (fds[lst].revents & POLLIN)) accept_client();
+}
+
+/* ── Display ─────────────────────────────────────────────────────────────── */
+
+/* Off-screen framebuffer for --headless (LV_COLOR_DEPTH 32). */
+static uint32_t s_framebuf[SIM_DISPLAY_WIDTH * SIM_DISPLAY_HEIGHT];
+
+static void headless_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px)
+{
+    /* Direct mode: LVGL drew straight into s_framebuf; nothing to copy. */
+    (void)area;
+    (void)px;
+    lv_display_flush_ready(disp);
+}
+
+static void sim_display_init(bool headless)
+{
+    lv_init();
+    lv_tick_set_cb(sim_millis);
+
+#if LV_USE_SDL
+    if (!headless) {
+        lv_sdl_window_create(SIM_DISPLAY_WIDTH, SIM_DISPLAY_HEIGHT);
+        lv_sdl_mouse_create();
+        return;
+    }
+#else
+    if (!headless) printf("[SIM] Built without SDL, running headless.\n");
+#endif
+
+    lv_display_t *disp = lv_display_create(SIM_DISPLAY_WIDTH, SIM_DISPLAY_HEIGHT);
+    lv_display_set_buffers(disp, s_framebuf, NULL, sizeof(s_framebuf),
+                           LV_DISPLAY_RENDER_MODE_DIRECT);
+    lv_display_set_flush_cb(disp, headless_flush);
+}
+
+/* ── Screen-state store ──────────────────────────────────────────────────── */
+
+/* --state FILE stands in for the flash region; bytes never written read as 0xFF. */
+static int s_state_fd = -1;
+
+static bool state_read(uint32_t addr, void *buf, size_t len)
+{
+    ssize_t n = pread(s_state_fd, buf, len, addr);
+    if (n < 0) return false;
+    memset((uint8_t *)buf + n, 0xFF, len - (size_t)n);
+    return true;
+}
+
+static bool state_erase(uint32_t addr)
+{
+    uint8_t blank[SIM_STATE_SECTOR];
+    memset(blank, 0xFF, sizeof(blank));
+    return pwrite(s_state_fd, blank, sizeof(blank), addr) == (ssize_t)sizeof(blank);
+}
+
+static bool state_program(uint32_t addr, const void *data, size_t len)
+{
+    return pwrite(s_state_fd, data, len, addr) == (ssize_t)len &&
+           fdatasync(s_state_fd) == 0;
+}
+
+static const dm_snapshot_store_t s_state_store = {
+    .sector_size  = SIM_STATE_SECTOR,
+    .sector_count = SIM_STATE_SECTORS,
+    .prog_size    = 4,
+    .read         = state_read,
+    .erase        = state_erase,
+    .program      = state_program,
+};
+
+/* ── Trace dump ──────────────────────────────────────────────────────────── */
+
+static volatile sig_atomic_t s_quit = 0;
+
+static void sim_on_sigint(int sig)
+{
+    (void)sig;
+    s_quit = 1;
+}
+
+#if DM_TRACE_DEPTH > 0
+/* Print the trace ring to stdout, with the gap to the previous entry. */
+static void sim_dump_trace(void)
+{
+    static const char *const names[] = {
+        "?", "FRAME_RX", "DISPATCH_BEGIN", "DISPATCH_END",
+        "TX_START", "TX_END", "RENDER_BEGIN", "RENDER_END",
+    };
+    dm_trace_entry_t e[32];
+    uint32_t from = 0, at, n, prev = 0;
+    bool started = false;
+
+    printf("[SIM] trace (t_us, +delta, event, arg, value):\n");
+    while ((n = dm_trace_read(from, e, 32, &at)) > 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            uint8_t ev = e[i].event < 8 ? e[i].event : 0;
+            printf("  %10u %+8d  %-14s %3u %5u\n", (unsigned)e[i].t_us,
+                   started ? (int)(e[i].t_us - prev) : 0, names[ev],
+                   e[i].arg, e[i].value);
+            prev    = e[i].t_us;
+            started = true;
+        }
+        from = at + n;
+    }
+}
+#endif
+
 /* ── Entry point ──────────────────────────────────────────────────────────── */
 
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--port DEV | --pty | --listen tcp:PORT | --listen unix:PATH]\n"
+            "          [--baud N] [--headless] [--no-render] [--state FILE]\n"
+            "  --baud N     UART speed; virtual line rate of pty/socket links\n"
+            "               (0 = unlimited, default %u)\n"
+            "  --headless   render into an off-screen framebuffer (no SDL window)\n"
+            "  --no-render  never run LVGL (protocol + widget state only)\n"
+            "  --state FILE keep the screen state in FILE across runs (warm restore)\n",
+            argv0, (unsigned)SIM_DEFAULT_BAUD);
+}
+
 int main(int argc, char *argv[])
 {
-    const char *port = NULL;
-    for (int i = 1; i < argc - 1; i++) {
-        if (strcmp(argv[i], "--port") == 0) port = argv[i + 1];
+    const char *port = NULL, *listen_spec = NULL, *state_path = NULL;
+    bool use_pty = false, headless = false, render = true;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && has_arg) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--listen") == 0 && has_arg) {
+            listen_spec = argv[++i];
+        } else if (strcmp(argv[i], "--baud") == 0 && has_arg) {
+            s_baud = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--state") == 0 && has_arg) {
+            state_path = argv[++i];
+        } else if (strcmp(argv[i], "--pty") == 0) {
+            use_pty = true;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--no-render") == 0) {
+            headless = true;
+            render   = false;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
     }
 
     if (port) {
-        s_serial_fd = open_serial(port, B115200);
-        if (s_serial_fd < 0) {
+        s_link_kind = LINK_SERIAL;
+        s_link_fd   = open_serial(port, s_baud ? s_baud : SIM_DEFAULT_BAUD);
+        if (s_link_fd < 0) {
             fprintf(stderr, "Could not open serial port %s: %s\n",
                     port, strerror(errno));
-        } else {
-            printf("[SIM] Serial port: %s\n", port);
+            return 1;
         }
+        printf("[SIM] Serial port: %s\n", port);
+    } else if (use_pty) {
+        s_link_kind = LINK_PTY;
+        s_link_fd   = open_pty();
+        if (s_link_fd < 0) {
+            fprintf(stderr, "Could not create a pty: %s\n", strerror(errno));
+            return 1;
+        }
+    } else if (listen_spec) {
+        s_link_kind = LINK_SOCKET;
+        s_listen_fd = open_listener(listen_spec);
+        if (s_listen_fd < 0) {
+            fprintf(stderr, "Could not listen on %s: %s\n",
+                    listen_spec, strerror(errno));
+            return 1;
+        }
+        signal(SIGPIPE, SIG_IGN);   /* a vanished host must not kill us */
     } else {
         printf("[SIM] No --port specified, running in loopback mode.\n");
     }
+    if (link_paced()) printf("[SIM] Virtual baud rate: %u\n", (unsigned)s_baud);
+
+    if (state_path) {
+        s_state_fd = open(state_path, O_RDWR | O_CREAT, 0644);
+        if (s_state_fd < 0) {
+            fprintf(stderr, "Could not open state file %s: %s\n",
+                    state_path, strerror(errno));
+            return 1;
+        }
+        dm_snapshot_set_store(&s_state_store);
+    }
 
-    /*
-     * TODO: Initialise LVGL SDL2 backend here.
-     * Reference: lvgl/examples/porting/lv_port_disp_template.c
-     *
-     *   lv_init();
-     *   lv_sdl_window_create(SIM_DISPLAY_WIDTH, SIM_DISPLAY_HEIGHT);
-     *   lv_sdl_mouse_create();
-     */
+    sim_display_init(headless);
 
     dm_init(&s_platform);
-    dm_binder_init(&s_platform);
+    dm_binder_init();
 
     printf("[SIM] hmic simulator running. Ctrl-C to quit.\n");
+    fflush(stdout);
+    signal(SIGINT, sim_on_sigint);
 
-    while (1) {
-        /* Read serial bytes */
-        if (s_serial_fd >= 0) {
-            uint8_t buf[64];
-            ssize_t n = read(s_serial_fd, buf, sizeof(buf));
-            for (ssize_t i = 0; i < n; i++) {
-                dm_receive_byte(buf[i]);
-            }
-        }
+    while (!s_quit) {
+        sim_tx_service(now_us());
+        uint32_t wait_ms = dm_process();
 
-        dm_process();
-        /* lv_timer_handler(); */
+        if (render) {
+            /* lv_timer_handler drives LVGL animations and redraws (timed for stats) */
+            uint32_t t    = dm_micros();
+            uint32_t next = lv_timer_handler();
+            dm_render_time(t);
+            if (next < wait_ms) wait_ms = next;
+        }
 
-        usleep(5000); /* ~200 Hz tick */
+        sim_wait(wait_ms, now_us());
     }
 
-    if (s_serial_fd >= 0) close(s_serial_fd);
+    dm_snapshot_flush();   /* Ctrl-C: keep what the settle timer had not written yet */
+#if DM_TRACE_DEPTH > 0
+    sim_dump_trace();
+#endif
+    if (s_state_fd >= 0) close(s_state_fd);
+    if (s_link_fd >= 0) close(s_link_fd);
+    if (s_pty_slave >= 0) close(s_pty_slave);
+    if (s_listen_fd >= 0) close(s_listen_fd);
     return 0;
 }
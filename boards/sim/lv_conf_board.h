@@ -0,0 +1,16 @@
+/**
+ * @file lv_conf_board.h
+ * @brief LVGL overlay for the simulator (see app/ui/lv_conf.h).
+ *
+ * 32-bit colour to match the SDL window and the --headless framebuffer,
+ * and a large heap: the host has memory to spare.  No Arm assembly, as
+ * the simulator also builds on x86.
+ */
+#ifndef LV_CONF_BOARD_H
+#define LV_CONF_BOARD_H
+
+#define LV_COLOR_DEPTH      32
+#define LV_MEM_SIZE         (128 * 1024U)
+#define LV_USE_DRAW_SW_ASM  LV_DRAW_SW_ASM_NONE
+
+#endif /* LV_CONF_BOARD_H */
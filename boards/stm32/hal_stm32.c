@@ -7,7 +7,19 @@
  *
  * Assumptions:
  *   - huart1 is initialized and configured for the host communication.
+ *   - huart1's RX DMA stream is configured in CIRCULAR mode (CubeMX).
+ *   - huart1's TX DMA stream is configured in NORMAL mode (CubeMX).
  *   - The board layer provides the standard STM32 HAL headers.
+ *
+ * Display: an ST7789-class panel on hspi1 (8-bit frames, TX DMA in
+ * NORMAL mode; DC/CS/RST pins in Config).  LVGL renders into one of two
+ * partial buffers while DMA sends the other, and HAL_SPI_TxCpltCallback()
+ * hands it back with lv_display_flush_ready().  On F7/H7 the buffer is
+ * cleaned from the D-cache before each transfer.  Touch is left to the
+ * board: add an lv_indev in lcd_init().
+ *
+ * Screen state (dm_snapshot) goes to two spare 16 KB flash sectors
+ * (Config; keep them out of the linker script's FLASH region).
  */
 #include "stm32f4xx_hal.h" // Replace with your specific family header
 #include <stdio.h>
@@ -15,11 +27,69 @@
 
 #include "../../core/dm_core.h"
 #include "../../core/dm_platform.h"
+#include "../../core/crc16.h"
 #include "../../app/dm_binder.h"
+#include "../../app/dm_snapshot.h"
+#include "../common/lcd_dcs.h"
+#include "lvgl.h"
+#ifdef HMIC_BENCH_AT_BOOT
+#include "../../bench/dm_bench.h"
+#endif
 
 /* ── Externs ─────────────────────────────────────────────────────────────── */
 
 extern UART_HandleTypeDef huart1; // Communication UART
+extern SPI_HandleTypeDef  hspi1;  // Display SPI
+
+/* ── Config ──────────────────────────────────────────────────────────────── */
+
+#ifndef DM_LCD_DC_PORT
+#define DM_LCD_DC_PORT   GPIOB
+#define DM_LCD_DC_PIN    GPIO_PIN_1
+#endif
+#ifndef DM_LCD_CS_PORT
+#define DM_LCD_CS_PORT   GPIOB
+#define DM_LCD_CS_PIN    GPIO_PIN_2
+#endif
+#ifndef DM_LCD_RST_PORT
+#define DM_LCD_RST_PORT  GPIOB
+#define DM_LCD_RST_PIN   GPIO_PIN_0
+#endif
+#define DM_LCD_WIDTH     320
+#define DM_LCD_HEIGHT    240
+#define DM_LCD_MADCTL    (LCD_DCS_MADCTL_MV | LCD_DCS_MADCTL_MX)   /* landscape */
+/* Lines per partial buffer; two of them: 2 × 320 × 20 × 2 B = 25 KB */
+#define DM_LCD_BUF_LINES 20
+
+/*
+ * Screen-state snapshot: F4 sectors 2 and 3 (16 KB each at 0x08008000),
+ * the smallest erase units on the part.  The linker script must keep the
+ * vector table in sectors 0–1 and the rest of the image from sector 4.
+ *
+ * Code fetches from flash stall while a sector erases: 250 ms typical,
+ * 500 ms worst case for 16 KB (1–2 s for the 128 KB sectors higher up).
+ * The RX DMA keeps running but its circular buffer wraps every ~11 ms
+ * at 115200 Bd, so frames that arrive meanwhile are lost.  The stall stays
+ * inside the host's retransmit window (HMIC_HOST_TIMEOUT_MS ×
+ * HMIC_HOST_RETRIES), which recovers them; a 128 KB sector would not.
+ */
+#ifndef DM_STATE_SECTOR
+#define DM_STATE_SECTOR      FLASH_SECTOR_2   /* First of DM_STATE_SECTORS */
+#define DM_STATE_ADDR        0x08008000u
+#define DM_STATE_SECTOR_SIZE (16 * 1024u)
+#define DM_STATE_SECTORS     2
+#endif
+
+/*
+ * Log output (stm32_log): a spare UART handle, e.g. huart2, or leave it
+ * undefined for ITM/SWO.  Never huart1: that is the host link.
+ */
+/* #define DM_LOG_UART huart2 */
+
+/* HAL_SPI_Transmit_DMA() counts bytes in a uint16_t. */
+#if DM_LCD_WIDTH * DM_LCD_BUF_LINES * 2 > 0xFFFF
+#error "DM_LCD_BUF_LINES too large for one SPI DMA transfer"
+#endif
 
 /* ── Platform function implementations ───────────────────────────────────── */
 
@@ -28,34 +98,303 @@ static void stm32_write_bytes(const uint8_t *data, uint16_t len)
     HAL_UART_Transmit(&huart1, (uint8_t*)data, len, HAL_MAX_DELAY);
 }
 
+/* TX via DMA; the core keeps @p data untouched until dm_tx_complete(). */
+static void stm32_write_async(const uint8_t *data, uint16_t len)
+{
+    if (HAL_UART_Transmit_DMA(&huart1, (uint8_t *)data, len) != HAL_OK) {
+        /* Could not start – report done so the queue is not stuck. */
+        dm_tx_complete();
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1) dm_tx_complete();
+}
+
 static uint32_t stm32_millis(void)
 {
     return HAL_GetTick();
 }
 
+/*
+ * HAL tick plus the SysTick down-counter, re-read if the tick moved in
+ * between.  Wraps at 2^32 µs as dm_platform_t requires – DWT->CYCCNT
+ * divided by the core clock would not, and Cortex-M0 parts lack DWT.
+ */
+static uint32_t stm32_micros(void)
+{
+    uint32_t ms, val;
+    do {
+        ms  = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+
+    uint32_t load = SysTick->LOAD + 1U;          /* core cycles per ms */
+    return ms * 1000U + (load - val) / (load / 1000U);
+}
+
+#ifdef DM_LOG_UART
+extern UART_HandleTypeDef DM_LOG_UART;
+#endif
+
+/*
+ * One line per call: to DM_LOG_UART when the board defines it, otherwise
+ * to ITM stimulus port 0 (SWO, read with the debug probe).  ITM_SendChar()
+ * returns at once while no probe has enabled the port.
+ */
 static void stm32_log(const char *msg)
 {
-    // Log to a secondary ITM or UART if available
-    // For now, just a stub
+#if defined(DM_LOG_UART)
+    HAL_UART_Transmit(&DM_LOG_UART, (uint8_t *)msg, (uint16_t)strlen(msg), HAL_MAX_DELAY);
+    HAL_UART_Transmit(&DM_LOG_UART, (uint8_t *)"\r\n", 2, HAL_MAX_DELAY);
+#elif defined(ITM_TCR_ITMENA_Msk)
+    while (*msg) ITM_SendChar((uint32_t)*msg++);
+    ITM_SendChar('\n');
+#else
+    (void)msg;   /* Cortex-M0/M0+: no ITM; define DM_LOG_UART */
+#endif
+}
+
+/* ── RX path: circular DMA + idle-line detection ─────────────────────────── */
+
+/*
+ * The DMA engine fills s_rx_dma_buf continuously.  The HAL reports the
+ * current write position on half-transfer, transfer-complete and UART
+ * idle; the bytes written since the last event are pushed into the core
+ * RX ring, which dm_process() drains from the main loop.
+ * On cores with a D-cache (F7/H7) place s_rx_dma_buf in non-cacheable RAM.
+ */
+#define RX_DMA_BUF_SIZE 128
+
+static uint8_t  s_rx_dma_buf[RX_DMA_BUF_SIZE];
+static uint16_t s_rx_dma_pos = 0;
+
+static void rx_dma_start(void)
+{
+    s_rx_dma_pos = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart1, s_rx_dma_buf, RX_DMA_BUF_SIZE);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t pos)
+{
+    if (huart != &huart1) return;
+
+    if (pos < s_rx_dma_pos) {
+        /* Wrapped: tail of the buffer first, then the head. */
+        dm_rx_write(&s_rx_dma_buf[s_rx_dma_pos], RX_DMA_BUF_SIZE - s_rx_dma_pos);
+        s_rx_dma_pos = 0;
+    }
+    dm_rx_write(&s_rx_dma_buf[s_rx_dma_pos], pos - s_rx_dma_pos);
+    s_rx_dma_pos = (pos == RX_DMA_BUF_SIZE) ? 0 : pos;
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    /* Overrun/noise aborts the DMA – restart reception. */
+    if (huart == &huart1) rx_dma_start();
+}
+
+/* ── Hardware CRC backend ────────────────────────────────────────────────── */
+
+#if DM_CRC_ENGINE == DM_CRC_ENGINE_HW
+/*
+ * Requires a family whose CRC unit has a programmable polynomial
+ * (F0/F3/F7/G0/G4/L4/H7).  The F4's fixed CRC-32 unit cannot do this.
+ */
+#if !defined(CRC_CR_POLYSIZE)
+#error "DM_CRC_ENGINE_HW needs an STM32 CRC unit with programmable polynomial"
+#endif
+
+uint16_t crc16_hw_update(uint16_t crc, const uint8_t *data, size_t length)
+{
+    CRC->POL  = 0x1021U;
+    CRC->INIT = crc;
+    /* 16-bit polynomial, no input/output reversal, load INIT */
+    CRC->CR   = CRC_CR_POLYSIZE_0 | CRC_CR_RESET;
+
+    for (size_t i = 0; i < length; i++) {
+        *(__IO uint8_t *)&CRC->DR = data[i];
+    }
+    return (uint16_t)CRC->DR;
 }
+#endif
 
 /* ── Platform struct ─────────────────────────────────────────────────────── */
 
 static dm_platform_t s_platform = {
     .write_bytes = stm32_write_bytes,
+    .write_async = stm32_write_async,
     .millis      = stm32_millis,
+    .micros      = stm32_micros,
     .log         = stm32_log,
 };
 
-/* ── Board init stub ─────────────────────────────────────────────────────── */
+/* ── Display: SPI panel, DMA flush ──────────────────────────────────────── */
+
+/* 32-byte aligned: SCB_CleanDCache_by_Addr() works on whole cache lines. */
+static uint16_t      s_lcd_buf[2][DM_LCD_WIDTH * DM_LCD_BUF_LINES] __attribute__((aligned(32)));
+static lv_display_t *s_lcd_disp = NULL;
+
+/* A command and its parameters, polled (a few bytes). */
+static void lcd_cmd(uint8_t cmd, const uint8_t *data, uint16_t n)
+{
+    while (HAL_SPI_GetState(&hspi1) != HAL_SPI_STATE_READY) {}   /* last flush */
+    HAL_GPIO_WritePin(DM_LCD_DC_PORT, DM_LCD_DC_PIN, GPIO_PIN_RESET);
+    HAL_SPI_Transmit(&hspi1, &cmd, 1, HAL_MAX_DELAY);
+    HAL_GPIO_WritePin(DM_LCD_DC_PORT, DM_LCD_DC_PIN, GPIO_PIN_SET);
+    if (n > 0) HAL_SPI_Transmit(&hspi1, (uint8_t *)data, n, HAL_MAX_DELAY);
+}
+
+/* Called by LVGL with the other buffer free; returns once DMA is running. */
+static void lcd_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px)
+{
+    uint8_t  win[4];
+    uint32_t bytes = lv_area_get_size(area) * 2U;
+
+    lcd_dcs_window(win, (uint16_t)area->x1, (uint16_t)area->x2);
+    lcd_cmd(LCD_DCS_CASET, win, sizeof(win));
+    lcd_dcs_window(win, (uint16_t)area->y1, (uint16_t)area->y2);
+    lcd_cmd(LCD_DCS_RASET, win, sizeof(win));
+    lcd_cmd(LCD_DCS_RAMWR, NULL, 0);
+
+    /* 8-bit frames go out in memory order; the panel wants MSB first. */
+    lv_draw_sw_rgb565_swap(px, lv_area_get_size(area));
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    SCB_CleanDCache_by_Addr((uint32_t *)px, (int32_t)bytes);
+#endif
+    if (HAL_SPI_Transmit_DMA(&hspi1, px, (uint16_t)bytes) != HAL_OK) {
+        lv_display_flush_ready(disp);   /* could not start – drop the area */
+    }
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi1) lv_display_flush_ready(s_lcd_disp);
+}
+
+static void lcd_init(void)
+{
+    HAL_GPIO_WritePin(DM_LCD_CS_PORT, DM_LCD_CS_PIN, GPIO_PIN_RESET);   /* only device on the bus */
+    HAL_GPIO_WritePin(DM_LCD_RST_PORT, DM_LCD_RST_PIN, GPIO_PIN_RESET);
+    HAL_Delay(10);
+    HAL_GPIO_WritePin(DM_LCD_RST_PORT, DM_LCD_RST_PIN, GPIO_PIN_SET);
+    HAL_Delay(LCD_DCS_RESET_MS);
+
+    static const lcd_dcs_step_t init[] = LCD_DCS_INIT_SEQUENCE(DM_LCD_MADCTL);
+    for (size_t i = 0; i < sizeof(init) / sizeof(init[0]); i++) {
+        lcd_cmd(init[i].cmd, init[i].data, init[i].n);
+        if (init[i].delay_ms) HAL_Delay(init[i].delay_ms);
+    }
+
+    lv_init();
+    lv_tick_set_cb(stm32_millis);
+    s_lcd_disp = lv_display_create(DM_LCD_WIDTH, DM_LCD_HEIGHT);
+    lv_display_set_color_format(s_lcd_disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(s_lcd_disp, s_lcd_buf[0], s_lcd_buf[1], sizeof(s_lcd_buf[0]),
+                           LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(s_lcd_disp, lcd_flush);
+}
+
+/* ── Screen-state store: spare flash sectors ─────────────────────────────── */
+
+static bool state_read(uint32_t addr, void *buf, size_t len)
+{
+    memcpy(buf, (const void *)(DM_STATE_ADDR + addr), len);
+    return true;
+}
+
+static bool state_erase(uint32_t addr)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase    = FLASH_TYPEERASE_SECTORS,
+        .Sector       = DM_STATE_SECTOR + addr / DM_STATE_SECTOR_SIZE,
+        .NbSectors    = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+    };
+    uint32_t bad = 0;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&erase, &bad);
+    HAL_FLASH_Lock();
+    return st == HAL_OK;
+}
+
+static bool state_program(uint32_t addr, const void *data, size_t len)
+{
+    const uint8_t *p  = data;
+    bool           ok = true;
+
+    HAL_FLASH_Unlock();
+    for (size_t off = 0; ok && off < len; off += 4) {
+        uint32_t word = 0xFFFFFFFFu;   /* Tail padded with erased bytes */
+        memcpy(&word, p + off, len - off < 4 ? len - off : 4);
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, DM_STATE_ADDR + addr + off,
+                               word) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+static const dm_snapshot_store_t s_state_store = {
+    .sector_size  = DM_STATE_SECTOR_SIZE,
+    .sector_count = DM_STATE_SECTORS,
+    .prog_size    = 4,
+    .read         = state_read,
+    .erase        = state_erase,
+    .program      = state_program,
+};
+
+/* ── Board init ──────────────────────────────────────────────────────────── */
 
 static void dm_board_init(void)
 {
-    /*
-     * TODO: Initialise your TFT display + touch driver here.
-     * Ensure LVGL is initialized including display and input buffers.
-     */
+#if DM_CRC_ENGINE == DM_CRC_ENGINE_HW
+    __HAL_RCC_CRC_CLK_ENABLE();
+#endif
+
+    lcd_init();
+    dm_snapshot_set_store(&s_state_store);
+}
+
+/* ── Boot benchmark ──────────────────────────────────────────────────────── */
+
+#ifdef HMIC_BENCH_AT_BOOT
+#if !defined(DM_LOG_UART) && !defined(ITM_TCR_ITMENA_Msk)
+#error "HMIC_BENCH_AT_BOOT needs DM_LOG_UART on a core without ITM"
+#endif
+
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+static uint32_t stm32_cycles(void)
+{
+    return DWT->CYCCNT;
 }
+#endif
+
+/* Core cycles where DWT exists (M3/M4/M7), stm32_micros on Cortex-M0. */
+static void bench_at_boot(void)
+{
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    const dm_bench_t b = {
+        .now   = stm32_cycles,
+        .hz    = SystemCoreClock,
+        .unit  = "cyc",
+        .print = stm32_log,
+    };
+#else
+    const dm_bench_t b = {
+        .now   = stm32_micros,
+        .hz    = 1000000u,
+        .unit  = "us",
+        .print = stm32_log,
+    };
+#endif
+    dm_bench_run_all(&b);
+}
+#endif
 
 /* ── Main loop integration ───────────────────────────────────────────────── */
 
@@ -65,23 +404,29 @@ static void dm_board_init(void)
 void hmic_run(void)
 {
     dm_board_init();
+#ifdef HMIC_BENCH_AT_BOOT
+    bench_at_boot();            /* results via stm32_log */
+#endif
     dm_init(&s_platform);
-    dm_binder_init(&s_platform);
+    dm_binder_init();
 
-    uint8_t rx_byte;
+    rx_dma_start();
 
     while (1) {
+        /* RX bytes arrive via DMA; dm_process() drains the ring. */
+        uint32_t wait = dm_process();
+
+        /* Drives LVGL timers (timed for stats) */
+        uint32_t t    = dm_micros();
+        uint32_t next = lv_timer_handler();
+        dm_render_time(t);
+        if (next < wait) wait = next;
+
         /*
-         * Non-blocking UART receive example. 
-         * In a production app, use DMA or Interrupts per dm_receive_byte.
+         * Nothing due now: sleep until the next interrupt – UART idle /
+         * DMA, TX DMA done, or the 1 ms HAL tick, which bounds every
+         * deadline to tick resolution.
          */
-        if (HAL_UART_Receive(&huart1, &rx_byte, 1, 10) == HAL_OK) {
-            dm_receive_byte(rx_byte);
-        }
-
-        dm_process();
-        
-        /* Drives LVGL timers */
-        /* lv_timer_handler(); */ // Uncomment when LVGL is ready
+        if (wait > 0) __WFI();
     }
 }
@@ -0,0 +1,22 @@
+/**
+ * @file lv_conf_board.h
+ * @brief LVGL overlay for STM32 (see app/ui/lv_conf.h).
+ *
+ * RGB565.  Cortex-M55/M85 parts (e.g. STM32N6) get LVGL's Helium blend
+ * routines; older cores (M0/M4/M7) draw in C.  Logging is off, as
+ * stm32_log() has no output by default.
+ */
+#ifndef LV_CONF_BOARD_H
+#define LV_CONF_BOARD_H
+
+#define LV_COLOR_DEPTH      16
+#define LV_MEM_SIZE         (32 * 1024U)
+#define LV_USE_LOG          0
+
+#if defined(__ARM_FEATURE_MVE)
+#define LV_USE_DRAW_SW_ASM  LV_DRAW_SW_ASM_HELIUM
+#else
+#define LV_USE_DRAW_SW_ASM  LV_DRAW_SW_ASM_NONE
+#endif
+
+#endif /* LV_CONF_BOARD_H */
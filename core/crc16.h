@@ -1,17 +1,25 @@
 /**
  * @file crc16.h
  * @brief CRC16-CCITT (polynomial 0x1021, seed 0xFFFF, no XOR out).
+ *
+ * The engine behind these functions is chosen at compile time with
+ * DM_CRC_ENGINE (see dm_config.h).  Every engine produces bit-identical
+ * results, so frames are interchangeable between boards.
  */
 #ifndef CRC16_H
 #define CRC16_H
 
 #include <stdint.h>
 #include <stddef.h>
+#include "dm_config.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Initial CRC value (seed). */
+#define CRC16_INIT 0xFFFFU
+
 /**
  * @brief Compute CRC16-CCITT over a buffer.
  * @param data    Pointer to data.
@@ -28,6 +36,31 @@ uint16_t crc16_ccitt(const uint8_t *data, size_t length);
  */
 uint16_t crc16_update(uint16_t crc, uint8_t byte);
 
+/**
+ * @brief Update a running CRC16 with a block of bytes.
+ *
+ * Equivalent to calling crc16_update() for every byte, but lets the
+ * table, slice-by-4 and hardware engines work on the whole span.
+ *
+ * @param crc     Current CRC value (start with 0xFFFF).
+ * @param data    Pointer to data.
+ * @param length  Number of bytes.
+ * @return        Updated CRC value.
+ */
+uint16_t crc16_update_buf(uint16_t crc, const uint8_t *data, size_t length);
+
+#if DM_CRC_ENGINE == DM_CRC_ENGINE_HW
+/**
+ * @brief Board-provided hardware CRC backend.
+ *
+ * Implemented by the board port (STM32 CRC peripheral, RP2040 DMA sniffer)
+ * when DM_CRC_ENGINE is DM_CRC_ENGINE_HW.  Must return exactly what
+ * crc16_update_buf() would in software.  Only called for spans of at least
+ * DM_CRC_HW_MIN_LEN bytes; shorter spans use the table engine.
+ */
+uint16_t crc16_hw_update(uint16_t crc, const uint8_t *data, size_t length);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,114 @@
+/**
+ * @file dm_bulk.c
+ * @brief Bulk transfer state machine (see dm_bulk.h).
+ */
+#include "dm_bulk.h"
+#include "dm_packet.h"
+#include "crc16.h"
+
+#include <stddef.h>
+
+typedef struct {
+    bool     open;
+    uint8_t  id;
+    uint32_t size;
+    uint16_t crc;      /* Expected CRC16 of the whole resource */
+} bulk_session_t;
+
+static const dm_bulk_store_t *s_store = NULL;
+static bulk_session_t         s_bulk;
+
+static uint32_t rd_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+}
+
+/* The open transfer, if it is for @p id. */
+static bool session_is(uint8_t id)
+{
+    return s_store && s_bulk.open && s_bulk.id == id;
+}
+
+static void session_close(bool ok)
+{
+    s_bulk.open = false;
+    s_store->finish(s_bulk.id, ok);
+}
+
+void dm_bulk_init(void)
+{
+    s_bulk.open = false;
+}
+
+void dm_bulk_set_store(const dm_bulk_store_t *store)
+{
+    s_store     = store;
+    s_bulk.open = false;
+}
+
+void dm_bulk_open(uint8_t seq, const uint8_t *p, uint16_t len,
+                  const dm_platform_t *plat)
+{
+    (void)len;
+    if (!s_store) { dm_packet_send_nack(seq, plat); return; }
+
+    /* A new OPEN implicitly abandons an unfinished transfer. */
+    if (s_bulk.open) session_close(false);
+
+    uint32_t size = rd_u32(&p[2]);
+    if (size == 0 || !s_store->open(p[0], p[1], size)) {
+        dm_packet_send_nack(seq, plat);
+        return;
+    }
+    s_bulk.open = true;
+    s_bulk.id   = p[0];
+    s_bulk.size = size;
+    s_bulk.crc  = (uint16_t)(((uint16_t)p[6] << 8) | p[7]);
+
+    uint8_t max_chunk[2] = { (uint8_t)(DM_BULK_CHUNK_MAX >> 8),
+                             (uint8_t)(DM_BULK_CHUNK_MAX & 0xFF) };
+    dm_packet_send_ack(seq, plat, max_chunk, sizeof(max_chunk));
+}
+
+void dm_bulk_chunk(uint8_t seq, const uint8_t *p, uint16_t len,
+                   const dm_platform_t *plat)
+{
+    if (!session_is(p[0])) {
+        dm_packet_send_nack(seq, plat);
+        return;
+    }
+    uint32_t offset = rd_u32(&p[1]);
+    uint16_t n      = (uint16_t)(len - DM_BULK_CHUNK_HDR);
+    if (offset > s_bulk.size || n > s_bulk.size - offset ||
+        !s_store->write(s_bulk.id, offset, p + DM_BULK_CHUNK_HDR, n)) {
+        dm_packet_send_nack(seq, plat);
+        return;
+    }
+    dm_packet_send_ack(seq, plat, NULL, 0);
+}
+
+void dm_bulk_commit(uint8_t seq, const uint8_t *p, uint16_t len,
+                    const dm_platform_t *plat)
+{
+    (void)len;
+    if (!session_is(p[0])) { dm_packet_send_nack(seq, plat); return; }
+
+    /* Check what actually landed in the destination, holes included. */
+    const uint8_t *data = s_store->map(s_bulk.id);
+    bool ok = data && crc16_ccitt(data, s_bulk.size) == s_bulk.crc;
+    session_close(ok);
+    if (ok) {
+        dm_packet_send_ack(seq, plat, NULL, 0);
+    } else {
+        dm_packet_send_nack(seq, plat);
+    }
+}
+
+void dm_bulk_abort(uint8_t seq, const uint8_t *p, uint16_t len,
+                   const dm_platform_t *plat)
+{
+    (void)len;
+    if (session_is(p[0])) session_close(false);
+    dm_packet_send_ack(seq, plat, NULL, 0);   /* nothing open is fine too */
+}
@@ -0,0 +1,97 @@
+/**
+ * @file dm_bulk.h
+ * @brief Chunked bulk transfer of resources (images, fonts, raw blobs).
+ *
+ * CMD_BULK_OPEN announces a resource (id, type, size, CRC16 of the whole
+ * resource); CMD_BULK_CHUNK frames carry offset-addressed pieces that are
+ * written straight from the frame payload into the destination – no
+ * staging copy; CMD_BULK_COMMIT checks the whole-resource CRC over the
+ * destination and publishes it; CMD_BULK_ABORT drops it.
+ *
+ * Chunk ACKs carry no data, so with DM_ACK_MODE_CUMULATIVE and a pipelined
+ * host a long run of chunks is answered by a few EVT_ACK_RANGEs.  Chunks
+ * may arrive in any order; each is protected by its frame CRC.
+ *
+ * Where the bytes go is up to a dm_bulk_store_t registered by the
+ * application (RAM arena, flash partition, ...).  One transfer is open at
+ * a time, shared by all links (dm_ctx_t).
+ */
+#ifndef DM_BULK_H
+#define DM_BULK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm_config.h"
+#include "dm_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Resource types (CMD_BULK_OPEN type field) */
+#define DM_RES_TYPE_RAW   0x00
+#define DM_RES_TYPE_IMAGE 0x01 /**< LVGL v9 binary image (lv_image_header_t + pixels) */
+#define DM_RES_TYPE_FONT  0x02 /**< LVGL binary font */
+
+/** CMD_BULK_CHUNK header: [res_id:u8][offset:u32 BE] */
+#define DM_BULK_CHUNK_HDR 5
+
+/** Largest data span one CMD_BULK_CHUNK can carry (at DM_MAX_PAYLOAD). */
+#define DM_BULK_CHUNK_MAX (DM_MAX_PAYLOAD - DM_BULK_CHUNK_HDR)
+
+/**
+ * @brief Destination backend for bulk transfers.
+ *
+ * All callbacks run in dm_process() context.  The destination must be
+ * memory-mapped (RAM, or XIP flash) so dm_bulk can verify the CRC of the
+ * committed bytes where they actually landed.
+ */
+typedef struct {
+    /** Prepare room for @p size bytes of resource @p id.  false = no room. */
+    bool (*open)(uint8_t id, uint8_t type, uint32_t size);
+
+    /** Store @p len bytes at @p offset (already bounds-checked). */
+    bool (*write)(uint8_t id, uint32_t offset, const uint8_t *data, uint16_t len);
+
+    /** Memory-mapped view of the bytes written so far (NULL if unavailable). */
+    const uint8_t *(*map)(uint8_t id);
+
+    /** End of the transfer: @p ok = publish the resource, false = discard it. */
+    void (*finish)(uint8_t id, bool ok);
+} dm_bulk_store_t;
+
+/**
+ * @brief Reset the bulk channel (no transfer open).  Keeps the store.
+ */
+void dm_bulk_init(void);
+
+/**
+ * @brief Register the destination backend (NULL = bulk commands NACK).
+ * @param store  Backend callbacks; must stay valid.
+ */
+void dm_bulk_set_store(const dm_bulk_store_t *store);
+
+/**
+ * @brief Command handlers, called by the protocol dispatcher (which has
+ *        already checked the payload lengths below).
+ *
+ *   CMD_BULK_OPEN    [res_id:u8][type:u8][size:u32 BE][crc:u16 BE]
+ *                    → EVT_ACK [max_chunk:u16 BE]
+ *   CMD_BULK_CHUNK   [res_id:u8][offset:u32 BE][data…]   → EVT_ACK
+ *   CMD_BULK_COMMIT  [res_id:u8]                         → EVT_ACK / EVT_NACK (CRC)
+ *   CMD_BULK_ABORT   [res_id:u8]                         → EVT_ACK
+ */
+void dm_bulk_open(uint8_t seq, const uint8_t *p, uint16_t len,
+                  const dm_platform_t *plat);
+void dm_bulk_chunk(uint8_t seq, const uint8_t *p, uint16_t len,
+                   const dm_platform_t *plat);
+void dm_bulk_commit(uint8_t seq, const uint8_t *p, uint16_t len,
+                    const dm_platform_t *plat);
+void dm_bulk_abort(uint8_t seq, const uint8_t *p, uint16_t len,
+                   const dm_platform_t *plat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_BULK_H */
@@ -8,14 +8,21 @@
 #ifndef DM_CONFIG_H
 #define DM_CONFIG_H
 
-/** Maximum payload bytes in a single frame (excludes header + CRC). */
+/**
+ * Maximum payload bytes in a single frame (excludes header + CRC).
+ * v1 frames carry at most 255; larger values need a v2 peer.
+ */
 #ifndef DM_MAX_PAYLOAD
 #define DM_MAX_PAYLOAD 128
 #endif
 
-/** Protocol version reported in every outgoing frame. */
+/** Frame format versions (VERSION byte). */
+#define DM_PROTOCOL_V1 0x01 /**< 8-bit PAYLOAD_LEN */
+#define DM_PROTOCOL_V2 0x02 /**< 16-bit PAYLOAD_LEN (big-endian) */
+
+/** Highest protocol version spoken; frames go out as v1 until negotiated. */
 #ifndef DM_PROTOCOL_VERSION
-#define DM_PROTOCOL_VERSION 0x01
+#define DM_PROTOCOL_VERSION DM_PROTOCOL_V2
 #endif
 
 /** Start-of-frame magic byte. */
@@ -24,11 +31,37 @@
 /** Header size: START(1) + VERSION(1) + CMD(1) + SEQ(1) + LEN(1) = 5 */
 #define DM_HEADER_SIZE 5
 
+/** v2 header size: as v1 with a 2-byte LEN = 6 */
+#define DM_HEADER_SIZE_V2 6
+
 /** CRC size in bytes. */
 #define DM_CRC_SIZE 2
 
-/** Total maximum frame size. */
-#define DM_MAX_FRAME_SIZE (DM_HEADER_SIZE + DM_MAX_PAYLOAD + DM_CRC_SIZE)
+/** VERSION flag: an ADDRESS byte follows VERSION (multi-drop buses). */
+#define DM_VERSION_ADDR_FLAG 0x80
+
+/** ADDRESS byte size in bytes (addressed frames only). */
+#define DM_ADDR_SIZE 1
+
+/** Total maximum frame size (either version, addressed). */
+#define DM_MAX_FRAME_SIZE (DM_HEADER_SIZE_V2 + DM_ADDR_SIZE + DM_MAX_PAYLOAD + DM_CRC_SIZE)
+
+/** ADDRESS of a point-to-point link: accept every frame, send unaddressed. */
+#define DM_ADDR_NONE 0x00
+
+/** ADDRESS every panel on the bus accepts; nobody answers it. */
+#define DM_ADDR_BROADCAST 0xFF
+
+/** dm_process() result: nothing is due until new input arrives. */
+#define DM_WAIT_FOREVER 0xFFFFFFFFu
+
+/**
+ * This panel's bus address (1..254), or DM_ADDR_NONE for a point-to-point
+ * link.  dm_set_address() changes it at runtime (e.g. from DIP switches).
+ */
+#ifndef DM_DEVICE_ADDRESS
+#define DM_DEVICE_ADDRESS DM_ADDR_NONE
+#endif
 
 /** Maximum length of a widget ID string (null-terminated). */
 #ifndef DM_MAX_WIDGET_ID
@@ -40,11 +73,207 @@
 #define DM_MAX_TEXT_LEN 64
 #endif
 
+#if DM_MAX_PAYLOAD > 0xFFFF
+#error "DM_MAX_PAYLOAD must fit the v2 16-bit PAYLOAD_LEN"
+#endif
+
+/** Widgets addressable by widget_idx (max 255; 0xFF means "none"). */
+#ifndef DM_MAX_WIDGETS
+#define DM_MAX_WIDGETS 64
+#endif
+
 /** Number of pages the UI binder can manage. */
 #ifndef DM_MAX_PAGES
 #define DM_MAX_PAGES 8
 #endif
 
+/** Max pages kept built at once; others are freed LRU (lazy rebuild). */
+#ifndef DM_UI_MAX_RESIDENT_PAGES
+#define DM_UI_MAX_RESIDENT_PAGES DM_MAX_PAGES
+#endif
+
+/** LVGL heap usage (%) above which non-visible pages are freed. */
+#ifndef DM_UI_RECLAIM_USED_PCT
+#define DM_UI_RECLAIM_USED_PCT 85
+#endif
+
+/**
+ * LVGL heap bytes budgeted per widget (object, styles, label text) when
+ * checking that a page fits before it is built; see ui_pages.c.
+ */
+#ifndef DM_UI_WIDGET_HEAP_BYTES
+#define DM_UI_WIDGET_HEAP_BYTES 256
+#endif
+
+/**
+ * Interned label text slots (DM_MAX_TEXT_LEN bytes each) shown with
+ * lv_label_set_text_static(); 0 = LVGL keeps its own copy of all text.
+ */
+#ifndef DM_TEXT_POOL_SLOTS
+#define DM_TEXT_POOL_SLOTS 16
+#endif
+
+/** Host string table ids for CMD_DEFINE_STRING (0 = disabled). */
+#ifndef DM_MAX_STRINGS
+#define DM_MAX_STRINGS 32
+#endif
+
+/** Bytes of string table text. */
+#ifndef DM_STRING_TABLE_SIZE
+#define DM_STRING_TABLE_SIZE 512
+#endif
+
+/**
+ * Largest screen-state snapshot kept in flash (app/dm_snapshot.h), and
+ * its RAM buffer; 0 = nothing persisted (CMD_GET_STATE_HASH still works).
+ */
+#ifndef DM_SNAPSHOT_MAX_SIZE
+#define DM_SNAPSHOT_MAX_SIZE 1024
+#endif
+
+/** Quiet time after the last screen change before the snapshot is written. */
+#ifndef DM_SNAPSHOT_SETTLE_MS
+#define DM_SNAPSHOT_SETTLE_MS 2000
+#endif
+
+/** Longest a change waits for the screen to settle before it is written anyway. */
+#ifndef DM_SNAPSHOT_MAX_DELAY_MS
+#define DM_SNAPSHOT_MAX_DELAY_MS 30000
+#endif
+
+/**
+ * Dual-core split: the protocol runs on one core and LVGL on the other,
+ * with widget commands and events passed through app/dm_ui_queue.h.
+ * 0 = one loop runs both (commands applied in the dispatcher).
+ */
+#ifndef DM_UI_SPLIT
+#define DM_UI_SPLIT 0
+#endif
+
+/** Widget commands queued for the LVGL core (power of two, split mode). */
+#ifndef DM_UI_QUEUE_DEPTH
+#define DM_UI_QUEUE_DEPTH 32
+#endif
+
+/** Widget events / render times queued for the protocol core (power of two). */
+#ifndef DM_UI_EVENT_DEPTH
+#define DM_UI_EVENT_DEPTH 16
+#endif
+
+/**
+ * Largest layout CMD_LAYOUT_WRITE can upload (0 = no upload).  Two
+ * buffers of this size are kept: the live layout and the next upload.
+ */
+#ifndef DM_LAYOUT_MAX_SIZE
+#define DM_LAYOUT_MAX_SIZE 2048
+#endif
+
+/** Resource ids available to the bulk transfer channel (images, fonts). */
+#ifndef DM_RES_MAX_COUNT
+#define DM_RES_MAX_COUNT 16
+#endif
+
+/** RAM arena for bulk-transferred resources, in bytes. */
+#ifndef DM_RES_POOL_SIZE
+#define DM_RES_POOL_SIZE 16384
+#endif
+
+/** RX ring buffer size in bytes (ISR/DMA → dm_process); power of two. */
+#ifndef DM_RX_RING_SIZE
+#define DM_RX_RING_SIZE 512
+#endif
+
+/**
+ * Drop a partial frame when no byte has arrived for this long (ms), so a
+ * truncated frame cannot swallow the start of the next one.  0 = never.
+ */
+#ifndef DM_RX_TIMEOUT_MS
+#define DM_RX_TIMEOUT_MS 20
+#endif
+
+/**
+ * After a bad frame (CRC, length, timeout), rescan its bytes for an
+ * embedded start byte instead of discarding them.  Costs one
+ * DM_MAX_FRAME_SIZE buffer per parser.
+ */
+#ifndef DM_RX_RESCAN
+#define DM_RX_RESCAN 1
+#endif
+
+/** Size of each of the two async TX buffers (bytes of coalesced frames). */
+#ifndef DM_TX_QUEUE_SIZE
+#define DM_TX_QUEUE_SIZE 512
+#endif
+
+/** Commands that can be installed with dm_protocol_register(). */
+#ifndef DM_PROTOCOL_MAX_HANDLERS
+#define DM_PROTOCOL_MAX_HANDLERS 8
+#endif
+
+#if DM_PROTOCOL_MAX_HANDLERS > 255
+#error "DM_PROTOCOL_MAX_HANDLERS must be at most 255"
+#endif
+
+/** Maximum sub-commands in one CMD_BATCH frame (status bitmap width). */
+#ifndef DM_BATCH_MAX_CMDS
+#define DM_BATCH_MAX_CMDS 32
+#endif
+
+/** Recent host commands remembered for retransmit detection (window). */
+#ifndef DM_SEQ_WINDOW
+#define DM_SEQ_WINDOW 16
+#endif
+
+/** ACK payload bytes cached per window entry for replay on retransmit. */
+#ifndef DM_SEQ_CACHE_DATA
+#define DM_SEQ_CACHE_DATA 8
+#endif
+
+/**
+ * Minimum spacing of EVT_SLIDER_CHANGED per widget and of EVT_TOUCH_EVENT
+ * (ms).  Faster updates are coalesced to the latest value; 0 disables.
+ */
+#ifndef DM_EVENT_MIN_INTERVAL_MS
+#define DM_EVENT_MIN_INTERVAL_MS 20
+#endif
+
+/**
+ * Time every command dispatch (two clock reads each) for CMD_GET_STATS.
+ * The link counters are always kept; 0 reports zero dispatch times.
+ */
+#ifndef DM_STATS_TIMING
+#define DM_STATS_TIMING 1
+#endif
+
+/**
+ * Trace ring entries (8 bytes each, power of two) for CMD_GET_TRACE.
+ * 0 = tracing compiled out.
+ */
+#ifndef DM_TRACE_DEPTH
+#define DM_TRACE_DEPTH 0
+#endif
+
+/* ── CRC engine ─────────────────────────────────────────────────────────── */
+
+/** Bit-at-a-time loop, no table (smallest ROM, slowest). */
+#define DM_CRC_ENGINE_BITWISE 0
+/** 256-entry lookup table (512 bytes ROM), one lookup per byte. */
+#define DM_CRC_ENGINE_TABLE   1
+/** Slice-by-4 tables (2 KiB ROM) for bulk buffers, table for single bytes. */
+#define DM_CRC_ENGINE_SLICE4  2
+/** Board hardware (crc16_hw_update) for bulk buffers, table otherwise. */
+#define DM_CRC_ENGINE_HW      3
+
+/** CRC16 engine used by crc16.c – one of DM_CRC_ENGINE_*. */
+#ifndef DM_CRC_ENGINE
+#define DM_CRC_ENGINE DM_CRC_ENGINE_TABLE
+#endif
+
+/** Shortest span handed to the hardware CRC backend (setup cost cut-off). */
+#ifndef DM_CRC_HW_MIN_LEN
+#define DM_CRC_HW_MIN_LEN 16
+#endif
+
 /** Enable (1) or disable (0) debug logging via platform->log. */
 #ifndef DM_DEBUG_LOG
 #define DM_DEBUG_LOG 1
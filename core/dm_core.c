@@ -1,40 +1,247 @@
 /**
  * @file dm_core.c
  * @brief Display Manager core – ties parser, protocol, and platform together.
+ *
+ * Per-link state lives in a dm_ctx_t.  The packet encoder and dispatcher
+ * work on the context bound here: each dm_ctx_* entry point binds its
+ * context for the duration of the call and then goes back to the
+ * selected one, so replies always reach the link the command came from.
+ * With a single link the bind is one pointer compare.
  */
 #include "dm_core.h"
-#include "dm_parser.h"
-#include "dm_protocol.h"
+#include "dm_bulk.h"
+#include "dm_trace.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 
 // Module-private state
 
-static dm_platform_t *s_platform = NULL;
-static dm_parser_t s_parser;
+static dm_ctx_t s_default;                /* The dm_init() link */
+static dm_ctx_t *s_current = NULL;        /* Context the core is serving */
+static dm_ctx_t *s_selected = &s_default; /* Target of UI events */
+static dm_timing_t s_render_timing;       /* One UI for all links */
+
+static void bind(dm_ctx_t *ctx) {
+  if (s_current == ctx)
+    return;
+  s_current = ctx;
+  dm_packet_bind(&ctx->packet);
+  dm_protocol_bind(&ctx->protocol);
+}
+
+/* Note that bytes just reached the parser (inter-byte timeout). */
+static void rx_activity(dm_ctx_t *ctx) {
+#if DM_RX_TIMEOUT_MS > 0
+  if (ctx->platform && ctx->platform->millis)
+    ctx->rx_last_ms = ctx->platform->millis();
+#else
+  (void)ctx;
+#endif
+}
 
 // Public API
 
 void dm_init(dm_platform_t *platform) {
-  s_platform = platform;
-  dm_parser_init(&s_parser);
-  dm_protocol_init();
+#if DM_TRACE_DEPTH > 0
+  dm_trace_init(platform);
+#endif
+  dm_protocol_unregister_all();
+  dm_bulk_init();
+  dm_timing_clear(&s_render_timing);
+  s_selected = &s_default;
+  dm_ctx_init(&s_default, platform);
 
 #if DM_DEBUG_LOG
-  if (s_platform && s_platform->log) {
-    s_platform->log("DM: initialised");
+  if (platform && platform->log) {
+    platform->log("DM: initialised");
   }
 #endif
 }
 
-void dm_receive_byte(uint8_t byte) {
-  dm_parser_feed(&s_parser, byte, s_platform);
+void dm_receive_byte(uint8_t byte) { dm_ctx_receive_byte(&s_default, byte); }
+
+void dm_receive_bytes(const uint8_t *buf, size_t n) {
+  dm_ctx_receive_bytes(&s_default, buf, n);
+}
+
+size_t dm_rx_write(const uint8_t *buf, size_t n) {
+  return dm_ring_write(&s_default.rx_ring, buf, n);
+}
+
+void dm_get_stats(dm_stats_t *out) { dm_ctx_get_stats(&s_default, out); }
+
+void dm_clear_stats_peaks(void) { dm_ctx_clear_stats_peaks(&s_default); }
+
+uint32_t dm_micros(void) { return dm_stats_now_us(s_default.platform); }
+
+void dm_render_time(uint32_t start_us) {
+  dm_render_span(start_us, dm_micros());
+}
+
+void dm_render_span(uint32_t start_us, uint32_t end_us) {
+  dm_timing_add(&s_render_timing, end_us - start_us);
+  DM_TRACE_EVT_AT(start_us, DM_TRACE_RENDER_BEGIN, 0, 0);
+  DM_TRACE_EVT_AT(end_us, DM_TRACE_RENDER_END, 0, 0);
+}
+
+void dm_set_address(uint8_t address) {
+  dm_ctx_set_address(&s_default, address);
+}
+
+void dm_tx_complete(void) { dm_ctx_tx_complete(&s_default); }
+
+uint32_t dm_process(void) { return dm_ctx_process(&s_default); }
+
+// Contexts
+
+void dm_ctx_init(dm_ctx_t *ctx, dm_platform_t *platform) {
+  ctx->platform = platform;
+  ctx->rx_last_ms = 0;
+  ctx->rx_bytes = 0;
+  dm_parser_init(&ctx->parser);
+  dm_ring_init(&ctx->rx_ring);
+
+  bind(ctx);
+  dm_protocol_init();
+  dm_packet_init();
+  dm_ctx_set_address(ctx, DM_DEVICE_ADDRESS);
+  bind(s_selected);
+}
+
+void dm_ctx_receive_byte(dm_ctx_t *ctx, uint8_t byte) {
+  ctx->rx_bytes++;
+  rx_activity(ctx);
+  bind(ctx);
+  dm_parser_feed(&ctx->parser, byte, ctx->platform);
+  bind(s_selected);
+}
+
+void dm_ctx_receive_bytes(dm_ctx_t *ctx, const uint8_t *buf, size_t n) {
+  ctx->rx_bytes += (uint32_t)n;
+  rx_activity(ctx);
+  bind(ctx);
+  dm_parser_feed_buf(&ctx->parser, buf, n, ctx->platform);
+  bind(s_selected);
 }
 
-void dm_process(void) {
+size_t dm_ctx_rx_write(dm_ctx_t *ctx, const uint8_t *buf, size_t n) {
+  return dm_ring_write(&ctx->rx_ring, buf, n);
+}
+
+void dm_ctx_get_stats(const dm_ctx_t *ctx, dm_stats_t *out) {
+  const dm_txq_t *q = &ctx->packet.txq;
+
+  out->rx_bytes = ctx->rx_bytes;
+  out->frames_ok = ctx->parser.frames_ok;
+  out->frames_crc_err = ctx->parser.frames_crc_err;
+  out->frames_len_err = ctx->parser.frames_len_err;
+  out->frames_timeout = ctx->parser.frames_timeout;
+  out->frames_skipped = ctx->parser.frames_skipped;
+  out->rx_overflows = ctx->rx_ring.overflows;
+  out->rx_ring_peak = ctx->rx_ring.peak;
+  out->tx_bytes = q->bytes;
+  out->tx_dropped = q->dropped;
+  out->tx_queue_peak = q->peak;
+  out->nacks = ctx->packet.nack_count;
+  out->duplicates = ctx->protocol.dup_count;
+  out->dispatch = ctx->protocol.dispatch_timing;
+  out->render = s_render_timing;
+}
+
+void dm_ctx_clear_stats_peaks(dm_ctx_t *ctx) {
+  ctx->rx_ring.peak = (uint32_t)dm_ring_count(&ctx->rx_ring);
+  ctx->packet.txq.peak = 0;
+  dm_timing_clear(&ctx->protocol.dispatch_timing);
+  dm_timing_clear(&s_render_timing);
+}
+
+void dm_ctx_set_address(dm_ctx_t *ctx, uint8_t address) {
+  dm_parser_set_address(&ctx->parser, address);
+  ctx->packet.address = address;
+}
+
+void dm_ctx_tx_complete(dm_ctx_t *ctx) {
+  /* Turn the bus around before the next transfer may be started. */
+  if (ctx->platform && ctx->platform->bus_tx_enable)
+    ctx->platform->bus_tx_enable(false);
+#if DM_TRACE_DEPTH > 0
+  dm_trace_tx_end_isr();
+#endif
+  dm_txq_complete(&ctx->packet.txq);
+}
+
+uint32_t dm_ctx_process(dm_ctx_t *ctx) {
   /*
-   * Future: add timeout-based frame expiry, watchdog feed stub, etc.
+   * Drain what is in the ring right now – at most two contiguous spans
+   * (up to the wrap point, then from the start).  Bytes arriving while we
+   * parse are left for the next call so a busy link cannot starve LVGL.
+   *
    * LVGL's lv_timer_handler() is called by the board layer after dm_process().
    */
-  (void)s_platform;
+  bind(ctx);
+  bool got_bytes = false;
+  for (int span = 0; span < 2; span++) {
+    const uint8_t *data;
+    size_t n = dm_ring_peek(&ctx->rx_ring, &data);
+    if (n == 0)
+      break;
+    dm_parser_feed_buf(&ctx->parser, data, n, ctx->platform);
+    dm_ring_consume(&ctx->rx_ring, n);
+    ctx->rx_bytes += (uint32_t)n;
+    got_bytes = true;
+  }
+
+#if DM_RX_TIMEOUT_MS > 0
+  /*
+   * A frame left half-received by an idle line is dropped (and its bytes
+   * rescanned).  Only ticks that saw no new bytes count as idle, so a
+   * slow main loop is never mistaken for a gap on the wire.
+   */
+  if (got_bytes) {
+    rx_activity(ctx);
+  } else if (ctx->platform && ctx->platform->millis &&
+             ctx->platform->millis() - ctx->rx_last_ms >= DM_RX_TIMEOUT_MS) {
+    dm_parser_expire(&ctx->parser, ctx->platform);
+  }
+#else
+  (void)got_bytes;
+#endif
+
+  /* Rate-limited slider/touch events whose interval has elapsed. */
+  uint32_t wait = dm_packet_poll_events(ctx->platform);
+
+  /* One EVT_ACK_RANGE for the run of commands handled in this tick. */
+  dm_packet_flush_acks(ctx->platform);
+
+  /* Frames queued while a DMA transfer was in flight go out as one. */
+  dm_packet_tx_poll(ctx->platform);
+  bind(s_selected);
+
+#if DM_RX_TIMEOUT_MS > 0
+  /* A partial frame expires DM_RX_TIMEOUT_MS after its last byte. */
+  if (ctx->parser.state != PARSE_WAIT_START && ctx->platform &&
+      ctx->platform->millis) {
+    uint32_t idle = ctx->platform->millis() - ctx->rx_last_ms;
+    uint32_t left = idle >= DM_RX_TIMEOUT_MS ? 0 : DM_RX_TIMEOUT_MS - idle;
+    if (left < wait)
+      wait = left;
+  }
+#endif
+
+  /* Bytes that arrived while we were parsing: come straight back. */
+  if (dm_ring_count(&ctx->rx_ring) > 0)
+    wait = 0;
+  return wait;
+}
+
+void dm_ctx_select(dm_ctx_t *ctx) {
+  s_selected = ctx;
+  bind(ctx);
+}
+
+dm_ctx_t *dm_ctx_current(void) { return s_current; }
+
+const dm_platform_t *dm_current_platform(void) {
+  return s_current ? s_current->platform : NULL;
 }
@@ -2,22 +2,56 @@
  * @file dm_core.h
  * @brief Public API of the Display Manager core library.
  *
- * Board firmware interacts ONLY through these three functions:
+ * Board firmware interacts ONLY through these functions:
  *
- *   dm_init()         – one-time initialisation
- *   dm_receive_byte() – feed each incoming byte
- *   dm_process()      – call periodically in the main loop
+ *   dm_init()          – one-time initialisation
+ *   dm_receive_byte()  – feed each incoming byte
+ *   dm_receive_bytes() – feed a buffer of incoming bytes (preferred)
+ *   dm_rx_write()      – queue bytes from an ISR for dm_process()
+ *   dm_tx_complete()   – signal the end of an async (DMA) transmit
+ *   dm_set_address()   – join a multi-drop (RS485) bus
+ *   dm_get_stats()     – link and latency counters (also CMD_GET_STATS)
+ *   dm_process()       – call periodically in the main loop
+ *
+ * These serve the single link set up by dm_init().  A firmware with more
+ * links (USB-CDC and RS485, or many virtual panels in the simulator) gives
+ * each extra link a dm_ctx_t and uses the dm_ctx_* variants: every context
+ * has its own parser, RX ring, seq window, TX queue, framing and counters.
+ * Registered command handlers, the bulk channel, the trace ring and the UI
+ * are shared.
  */
 #ifndef DM_CORE_H
 #define DM_CORE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "dm_platform.h"
+#include "dm_stats.h"
+#include "dm_parser.h"
+#include "dm_ring.h"
+#include "dm_packet.h"
+#include "dm_protocol.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief State of one host link.
+ *
+ * Allocate statically and set up with dm_ctx_init(); the fields are
+ * private to the core.
+ */
+typedef struct {
+  dm_platform_t *platform;
+  dm_parser_t parser;
+  dm_ring_t rx_ring;
+  uint32_t rx_last_ms; /**< When bytes last reached the parser */
+  uint32_t rx_bytes;   /**< Bytes handed to the parser */
+  dm_packet_state_t packet;
+  dm_protocol_state_t protocol;
+} dm_ctx_t;
+
 /**
  * @brief Initialise the Display Manager.
  *
@@ -32,22 +66,178 @@ void dm_init(dm_platform_t *platform);
 /**
  * @brief Feed one received byte into the protocol parser.
  *
- * Call this from your UART/USB RX interrupt or polling loop.
- * This function is non-blocking and safe to call from an ISR if
- * dm_process() is called from the main loop.
+ * Call this from your polling loop.  The parser and command handlers run
+ * in the caller's context, so do NOT call this from an ISR – use
+ * dm_rx_write() there instead.
  *
  * @param byte  Received byte.
  */
 void dm_receive_byte(uint8_t byte);
 
 /**
- * @brief Periodic processing tick.
+ * @brief Feed a buffer of received bytes into the protocol parser.
+ *
+ * Equivalent to calling dm_receive_byte() for each byte, with much lower
+ * per-byte overhead.  Prefer this whenever the driver already reads into
+ * a buffer.
+ *
+ * @param buf  Received bytes.
+ * @param n    Number of bytes in @p buf.
+ */
+void dm_receive_bytes(const uint8_t *buf, size_t n);
+
+/**
+ * @brief Queue received bytes in the core RX ring (ISR-safe).
+ *
+ * Single producer: call from exactly one UART ISR / RX task.  The bytes
+ * are parsed on the next dm_process() call.  Bytes that do not fit are
+ * dropped and counted.
+ *
+ * @param buf  Received bytes.
+ * @param n    Number of bytes.
+ * @return     Number of bytes queued.
+ */
+size_t dm_rx_write(const uint8_t *buf, size_t n);
+
+/**
+ * @brief Signal that the transfer started by plat->write_async finished.
+ *
+ * Call from the board's TX-complete ISR / DMA callback.  ISR-safe.  Frames
+ * queued in the meantime are sent as one transfer by the next
+ * dm_process() (or the next outgoing frame).
+ */
+void dm_tx_complete(void);
+
+/**
+ * @brief Set this panel's address on a multi-drop bus.
+ *
+ * From then on only frames carrying this ADDRESS (or DM_ADDR_BROADCAST)
+ * are acted on, and replies carry it too.  dm_init() applies
+ * DM_DEVICE_ADDRESS; call this afterwards to take the address from DIP
+ * switches or flash instead.
+ *
+ * @param address  1..254, or DM_ADDR_NONE for a point-to-point link.
+ */
+void dm_set_address(uint8_t address);
+
+/**
+ * @brief Snapshot the link and latency statistics.
+ * @param out  Receives the counters (see dm_stats.h).
+ */
+void dm_get_stats(dm_stats_t *out);
+
+/**
+ * @brief Clear the high-water marks and timings (cumulative counters stay).
+ */
+void dm_clear_stats_peaks(void);
+
+/**
+ * @brief Microsecond clock of the platform (millis() × 1000 without micros).
+ */
+uint32_t dm_micros(void);
+
+/**
+ * @brief Record one render pass for the statistics.
+ *
+ * Wrap the board's lv_timer_handler() call:
  *
- * Call this as frequently as possible from the main loop (ideally every
- * 1–10 ms).  Drives LVGL timer handling via lv_timer_handler() and any
- * deferred protocol work.
+ *   uint32_t t = dm_micros();
+ *   lv_timer_handler();
+ *   dm_render_time(t);
+ *
+ * @param start_us  dm_micros() taken before the pass.
  */
-void dm_process(void);
+void dm_render_time(uint32_t start_us);
+
+/**
+ * @brief Record a render pass measured elsewhere (DM_UI_SPLIT).
+ *
+ * Same as dm_render_time() with both ends given, for passes timed on
+ * the LVGL core and reported here by dm_uiq_poll_events().
+ *
+ * @param start_us  dm_micros() before the pass.
+ * @param end_us    dm_micros() after it.
+ */
+void dm_render_span(uint32_t start_us, uint32_t end_us);
+
+/**
+ * @brief Processing tick; returns how long the core can sleep.
+ *
+ * Drains the RX ring into the parser (dispatching any complete frames),
+ * starts pending async transmits and runs deferred protocol work.  The
+ * board layer calls lv_timer_handler() afterwards and may then sleep
+ * (WFI, a blocking RTOS wait) for the smaller of the two results.  New
+ * input ends the sleep early: the UART RX interrupt / dm_rx_write() and
+ * the TX-done interrupt / dm_tx_complete() must wake the loop, as must
+ * UI events raised outside lv_timer_handler().
+ *
+ * @return ms until the next deadline (inter-byte timeout of a partial
+ *         frame, a coalesced slider/touch event), 0 if bytes are already
+ *         waiting in the RX ring, or DM_WAIT_FOREVER when idle.
+ */
+uint32_t dm_process(void);
+
+// Additional links
+
+/**
+ * @brief Set up @p ctx for the link behind @p platform.
+ *
+ * Call after dm_init(), which sets up the shared parts.  The context
+ * starts at DM_DEVICE_ADDRESS, v1 framing and per-command ACKs.
+ *
+ * @param ctx       Context to initialise (must stay valid).
+ * @param platform  The link's HAL vtable (must stay valid).
+ */
+void dm_ctx_init(dm_ctx_t *ctx, dm_platform_t *platform);
+
+/** @brief dm_receive_byte() for @p ctx. */
+void dm_ctx_receive_byte(dm_ctx_t *ctx, uint8_t byte);
+
+/** @brief dm_receive_bytes() for @p ctx. */
+void dm_ctx_receive_bytes(dm_ctx_t *ctx, const uint8_t *buf, size_t n);
+
+/** @brief dm_rx_write() for @p ctx (ISR-safe, one producer per context). */
+size_t dm_ctx_rx_write(dm_ctx_t *ctx, const uint8_t *buf, size_t n);
+
+/** @brief dm_tx_complete() for @p ctx (ISR-safe). */
+void dm_ctx_tx_complete(dm_ctx_t *ctx);
+
+/** @brief dm_set_address() for @p ctx. */
+void dm_ctx_set_address(dm_ctx_t *ctx, uint8_t address);
+
+/** @brief dm_get_stats() for @p ctx (render timing is shared). */
+void dm_ctx_get_stats(const dm_ctx_t *ctx, dm_stats_t *out);
+
+/** @brief dm_clear_stats_peaks() for @p ctx. */
+void dm_ctx_clear_stats_peaks(dm_ctx_t *ctx);
+
+/**
+ * @brief dm_process() for @p ctx; call for every context each loop and
+ * sleep for the smallest result.
+ */
+uint32_t dm_ctx_process(dm_ctx_t *ctx);
+
+/**
+ * @brief Choose the link that events from outside a command go to.
+ *
+ * Replies always go to the link the command came from.  Events raised by
+ * the UI (button, slider, touch) go to the selected context – the
+ * dm_init() one unless this is called.
+ *
+ * @param ctx  Context to select.
+ */
+void dm_ctx_select(dm_ctx_t *ctx);
+
+/**
+ * @brief The context being served.
+ *
+ * Inside handlers and platform callbacks this is the link the core is
+ * working for; elsewhere it is the selected context.
+ */
+dm_ctx_t *dm_ctx_current(void);
+
+/** @brief Platform of dm_ctx_current(), for sending events. */
+const dm_platform_t *dm_current_platform(void);
 
 #ifdef __cplusplus
 }
@@ -2,90 +2,358 @@
  * @file dm_packet.c
  * @brief Packet encoder implementation.
  *
- * Builds frames in a static stack-allocated buffer (no heap).
- * The buffer is sized to DM_MAX_FRAME_SIZE at compile time.
+ * Builds frames in place in the TX queue (no heap, no stack frame buffer),
+ * accumulating the CRC while the header and payload are written.
  */
 #include "dm_packet.h"
 #include "crc16.h"
 #include "dm_protocol.h"
+#include "dm_txq.h"
 
+#include <stdbool.h>
 #include <string.h>
 
 // Internal helpers
 
-static uint8_t s_seq_counter =
-    0; /* Auto-incremented for device-originated events */
+#define V1_MAX_PAYLOAD (DM_MAX_PAYLOAD < 0xFF ? DM_MAX_PAYLOAD : 0xFF)
+
+static dm_packet_state_t *s_pk = NULL; /* Link being served (dm_packet_bind) */
+
+void dm_packet_bind(dm_packet_state_t *state) { s_pk = state; }
+
+void dm_packet_init(void) {
+  s_pk->seq_counter = 0;
+  s_pk->capturing = false;
+  s_pk->captured = DM_CAPTURE_NONE;
+  s_pk->ack_mode = DM_ACK_MODE_EACH;
+  s_pk->ack_count = 0;
+  s_pk->tx_version = DM_PROTOCOL_V1;
+  s_pk->peer_max_payload = V1_MAX_PAYLOAD;
+  s_pk->muted = false;
+  s_pk->nack_count = 0;
+  memset(s_pk->slider_slots, 0, sizeof(s_pk->slider_slots));
+  memset(&s_pk->touch_slot, 0, sizeof(s_pk->touch_slot));
+  s_pk->pending_events = 0;
+  dm_txq_init(&s_pk->txq);
+}
+
+void dm_packet_set_ack_mode(uint8_t mode) { s_pk->ack_mode = mode; }
+
+void dm_packet_set_address(uint8_t address) { s_pk->address = address; }
+
+void dm_packet_set_muted(bool muted) { s_pk->muted = muted; }
+
+void dm_packet_set_peer(uint8_t version, uint16_t max_payload) {
+  s_pk->tx_version =
+      (version == DM_PROTOCOL_V2) ? DM_PROTOCOL_V2 : DM_PROTOCOL_V1;
+  if (s_pk->tx_version == DM_PROTOCOL_V1 && max_payload > V1_MAX_PAYLOAD)
+    max_payload = V1_MAX_PAYLOAD;
+  if (max_payload > DM_MAX_PAYLOAD)
+    max_payload = DM_MAX_PAYLOAD;
+  s_pk->peer_max_payload = max_payload;
+}
+
+uint8_t dm_packet_peer_version(void) { return s_pk->tx_version; }
+
+uint16_t dm_packet_max_payload(void) { return s_pk->peer_max_payload; }
+
+void dm_packet_flush_acks(const dm_platform_t *plat) {
+  if (s_pk->ack_count == 0)
+    return;
+  dm_tx_frame_t f;
+  uint8_t count = s_pk->ack_count;
+  s_pk->ack_count = 0;
+  dm_packet_reserve(&f, EVT_ACK_RANGE, s_pk->ack_first, 2, plat);
+  dm_packet_put_u8(&f, s_pk->ack_first);
+  dm_packet_put_u8(&f, count);
+  dm_packet_commit(&f, plat);
+}
+
+void dm_packet_tx_poll(const dm_platform_t *plat) {
+  if (plat && plat->write_async)
+    dm_txq_poll(&s_pk->txq, plat);
+}
+
+dm_txq_t *dm_packet_txq(void) { return &s_pk->txq; }
+
+uint32_t dm_packet_nack_count(void) { return s_pk->nack_count; }
 
 void dm_packet_send(uint8_t cmd, uint8_t seq, const uint8_t *payload,
-                    uint8_t payload_len, const dm_platform_t *plat) {
-  if (!plat || !plat->write_bytes)
+                    uint16_t payload_len, const dm_platform_t *plat) {
+  dm_tx_frame_t f;
+  if (!dm_packet_reserve(&f, cmd, seq, payload_len, plat))
     return;
+  if (payload)
+    dm_packet_put(&f, payload, payload_len);
+  dm_packet_commit(&f, plat);
+}
 
-  /* Guard against oversized payloads */
-  if (payload_len > DM_MAX_PAYLOAD)
-    payload_len = DM_MAX_PAYLOAD;
+// In-place frame building
 
-  uint8_t frame[DM_MAX_FRAME_SIZE];
-  uint16_t idx = 0;
+bool dm_packet_reserve(dm_tx_frame_t *f, uint8_t cmd, uint8_t seq,
+                       uint16_t payload_len, const dm_platform_t *plat) {
+  f->buf = NULL;
+  f->len = f->end = 0;
+  if (!plat || !plat->write_bytes || s_pk->muted)
+    return false;
 
-  /* Start byte (not included in CRC) */
-  frame[idx++] = DM_START_BYTE;
+  /* Keep wire order: pending cumulative ACKs go out first. */
+  dm_packet_flush_acks(plat);
 
-  /* Header fields (CRC starts here) */
-  frame[idx++] = DM_PROTOCOL_VERSION;
-  frame[idx++] = cmd;
-  frame[idx++] = seq;
-  frame[idx++] = payload_len;
+  /* Guard against payloads the peer cannot take */
+  if (payload_len > s_pk->peer_max_payload)
+    payload_len = s_pk->peer_max_payload;
 
-  /* Payload */
-  if (payload && payload_len > 0) {
-    memcpy(&frame[idx], payload, payload_len);
-    idx += payload_len;
+  bool addressed = s_pk->address != DM_ADDR_NONE;
+  uint16_t hdr =
+      (s_pk->tx_version == DM_PROTOCOL_V2) ? DM_HEADER_SIZE_V2 : DM_HEADER_SIZE;
+  if (addressed)
+    hdr += DM_ADDR_SIZE;
+  f->buf = dm_txq_reserve(&s_pk->txq, hdr + payload_len + DM_CRC_SIZE, plat);
+  if (!f->buf)
+    return false;
+
+  /* Start byte (not included in CRC), then the header (CRC starts here) */
+  uint16_t i = 0;
+  f->buf[i++] = DM_START_BYTE;
+  if (addressed) {
+    f->buf[i++] = (uint8_t)(s_pk->tx_version | DM_VERSION_ADDR_FLAG);
+    f->buf[i++] = s_pk->address;
+  } else {
+    f->buf[i++] = s_pk->tx_version;
   }
+  f->buf[i++] = cmd;
+  f->buf[i++] = seq;
+  if (s_pk->tx_version == DM_PROTOCOL_V2)
+    f->buf[i++] = (uint8_t)(payload_len >> 8);
+  f->buf[i] = (uint8_t)(payload_len & 0xFF);
+
+  f->len = hdr;
+  f->end = hdr + payload_len;
+  f->crc = crc16_update_buf(0xFFFFU, &f->buf[1], hdr - 1);
+  return true;
+}
+
+void dm_packet_put(dm_tx_frame_t *f, const uint8_t *data, uint16_t len) {
+  if (len > f->end - f->len)
+    len = f->end - f->len;
+  if (len == 0)
+    return;
+  memcpy(&f->buf[f->len], data, len);
+  f->crc = crc16_update_buf(f->crc, data, len);
+  f->len += len;
+}
+
+void dm_packet_put_u8(dm_tx_frame_t *f, uint8_t v) {
+  if (f->len >= f->end)
+    return;
+  f->buf[f->len++] = v;
+  f->crc = crc16_update(f->crc, v);
+}
 
-  /* CRC over VERSION..PAYLOAD (bytes 1..idx-1) */
-  uint16_t crc = crc16_ccitt(&frame[1], idx - 1);
-  frame[idx++] = (uint8_t)(crc >> 8);
-  frame[idx++] = (uint8_t)(crc & 0xFF);
+void dm_packet_put_u16(dm_tx_frame_t *f, uint16_t v) {
+  dm_packet_put_u8(f, (uint8_t)(v >> 8));
+  dm_packet_put_u8(f, (uint8_t)(v & 0xFF));
+}
 
-  plat->write_bytes(frame, idx);
+void dm_packet_commit(dm_tx_frame_t *f, const dm_platform_t *plat) {
+  if (!f->buf)
+    return;
+  while (f->len < f->end)
+    dm_packet_put_u8(f, 0);
+  f->buf[f->len++] = (uint8_t)(f->crc >> 8);
+  f->buf[f->len++] = (uint8_t)(f->crc & 0xFF);
+  dm_txq_commit(&s_pk->txq, f->len, plat);
+  f->buf = NULL;
 }
 
 // Convenience wrappers
 
+void dm_packet_capture_begin(void) {
+  s_pk->capturing = true;
+  s_pk->captured = DM_CAPTURE_NONE;
+}
+
+uint8_t dm_packet_capture_end(void) {
+  s_pk->capturing = false;
+  return s_pk->captured;
+}
+
 void dm_packet_send_ack(uint8_t seq, const dm_platform_t *plat,
-                        const uint8_t *payload, uint8_t payload_len) {
+                        const uint8_t *payload, uint16_t payload_len) {
+  if (s_pk->capturing) {
+    s_pk->captured = DM_CAPTURE_ACK; /* ACK data is dropped inside a batch */
+    return;
+  }
+  if (s_pk->muted)
+    return;
+  dm_protocol_note_response(seq, EVT_ACK, payload, payload_len);
+
+  if (s_pk->ack_mode == DM_ACK_MODE_CUMULATIVE && payload_len == 0) {
+    if (s_pk->ack_count > 0 && s_pk->ack_count < 0xFF &&
+        (uint8_t)(s_pk->ack_first + s_pk->ack_count) == seq) {
+      s_pk->ack_count++;
+      return;
+    }
+    dm_packet_flush_acks(plat);
+    s_pk->ack_first = seq;
+    s_pk->ack_count = 1;
+    return;
+  }
   dm_packet_send(EVT_ACK, seq, payload, payload_len, plat);
 }
 
 void dm_packet_send_nack(uint8_t seq, const dm_platform_t *plat) {
+  if (s_pk->capturing) {
+    s_pk->captured = DM_CAPTURE_NACK;
+    return;
+  }
+  if (s_pk->muted)
+    return;
+  s_pk->nack_count++;
+  dm_protocol_note_response(seq, EVT_NACK, NULL, 0);
   dm_packet_send(EVT_NACK, seq, NULL, 0, plat);
 }
 
 void dm_packet_send_button_pressed(uint8_t widget_idx,
                                    const dm_platform_t *plat) {
-  dm_packet_send(EVT_BUTTON_PRESSED, s_seq_counter++, &widget_idx, 1, plat);
+  dm_packet_send(EVT_BUTTON_PRESSED, s_pk->seq_counter++, &widget_idx, 1, plat);
+}
+
+static void send_slider(uint8_t widget_idx, int16_t value,
+                        const dm_platform_t *plat) {
+  dm_tx_frame_t f;
+  dm_packet_reserve(&f, EVT_SLIDER_CHANGED, s_pk->seq_counter++, 3, plat);
+  dm_packet_put_u8(&f, widget_idx);
+  dm_packet_put_u16(&f, (uint16_t)value);
+  dm_packet_commit(&f, plat);
+}
+
+static void send_touch(int16_t x, int16_t y, const dm_platform_t *plat) {
+  dm_tx_frame_t f;
+  dm_packet_reserve(&f, EVT_TOUCH_EVENT, s_pk->seq_counter++, 4, plat);
+  dm_packet_put_u16(&f, (uint16_t)x);
+  dm_packet_put_u16(&f, (uint16_t)y);
+  dm_packet_commit(&f, plat);
+}
+
+#if DM_EVENT_MIN_INTERVAL_MS > 0
+/*
+ * Returns true if the event may go out now; otherwise stores it in the
+ * slot (overwriting any older pending value) for dm_packet_poll_events().
+ */
+static bool event_admit(dm_event_slot_t *slot, int16_t a, int16_t b,
+                        const dm_platform_t *plat) {
+  uint32_t now = plat->millis();
+  if (!slot->started || now - slot->last_ms >= DM_EVENT_MIN_INTERVAL_MS) {
+    if (slot->pending) {
+      slot->pending = false;
+      s_pk->pending_events--;
+    }
+    slot->started = true;
+    slot->last_ms = now;
+    return true;
+  }
+  if (!slot->pending) {
+    slot->pending = true;
+    s_pk->pending_events++;
+  }
+  slot->a = a;
+  slot->b = b;
+  return false;
+}
+#endif
+
+static void event_settle(dm_event_slot_t *slot, const dm_platform_t *plat) {
+  if (slot->pending) {
+    slot->pending = false;
+    s_pk->pending_events--;
+  }
+  slot->started = true;
+  slot->last_ms = plat->millis();
 }
 
 void dm_packet_send_slider_changed(uint8_t widget_idx, int16_t value,
                                    const dm_platform_t *plat) {
-  uint8_t buf[3];
-  buf[0] = widget_idx;
-  buf[1] = (uint8_t)((value >> 8) & 0xFF);
-  buf[2] = (uint8_t)(value & 0xFF);
-  dm_packet_send(EVT_SLIDER_CHANGED, s_seq_counter++, buf, sizeof(buf), plat);
+  if (!plat)
+    return;
+#if DM_EVENT_MIN_INTERVAL_MS > 0
+  if (widget_idx < DM_MAX_WIDGETS &&
+      !event_admit(&s_pk->slider_slots[widget_idx], value, 0, plat))
+    return;
+#endif
+  send_slider(widget_idx, value, plat);
+}
+
+void dm_packet_send_slider_settled(uint8_t widget_idx, int16_t value,
+                                   const dm_platform_t *plat) {
+  if (!plat)
+    return;
+  if (widget_idx < DM_MAX_WIDGETS)
+    event_settle(&s_pk->slider_slots[widget_idx], plat);
+  send_slider(widget_idx, value, plat);
 }
 
 void dm_packet_send_page_changed(uint8_t page_id, const dm_platform_t *plat) {
-  dm_packet_send(EVT_PAGE_CHANGED, s_seq_counter++, &page_id, 1, plat);
+  dm_packet_send(EVT_PAGE_CHANGED, s_pk->seq_counter++, &page_id, 1, plat);
 }
 
 void dm_packet_send_touch_event(int16_t x, int16_t y,
                                 const dm_platform_t *plat) {
-  uint8_t buf[4];
-  buf[0] = (uint8_t)((x >> 8) & 0xFF);
-  buf[1] = (uint8_t)(x & 0xFF);
-  buf[2] = (uint8_t)((y >> 8) & 0xFF);
-  buf[3] = (uint8_t)(y & 0xFF);
-  dm_packet_send(EVT_TOUCH_EVENT, s_seq_counter++, buf, sizeof(buf), plat);
+  if (!plat)
+    return;
+#if DM_EVENT_MIN_INTERVAL_MS > 0
+  if (!event_admit(&s_pk->touch_slot, x, y, plat))
+    return;
+#endif
+  send_touch(x, y, plat);
+}
+
+void dm_packet_send_touch_settled(int16_t x, int16_t y,
+                                  const dm_platform_t *plat) {
+  if (!plat)
+    return;
+  event_settle(&s_pk->touch_slot, plat);
+  send_touch(x, y, plat);
+}
+
+#if DM_EVENT_MIN_INTERVAL_MS > 0
+/* True if @p slot went out; otherwise lowers *wait to its due time. */
+static bool event_due(const dm_event_slot_t *slot, uint32_t now,
+                      uint32_t *wait) {
+  uint32_t age = now - slot->last_ms;
+  if (age >= DM_EVENT_MIN_INTERVAL_MS)
+    return true;
+  if (DM_EVENT_MIN_INTERVAL_MS - age < *wait)
+    *wait = DM_EVENT_MIN_INTERVAL_MS - age;
+  return false;
+}
+#endif
+
+uint32_t dm_packet_poll_events(const dm_platform_t *plat) {
+  uint32_t wait = DM_WAIT_FOREVER;
+#if DM_EVENT_MIN_INTERVAL_MS > 0
+  if (s_pk->pending_events == 0 || !plat)
+    return wait;
+
+  uint32_t now = plat->millis();
+  uint16_t left = s_pk->pending_events;
+  for (uint16_t i = 0; i < DM_MAX_WIDGETS && left > 0; i++) {
+    dm_event_slot_t *slot = &s_pk->slider_slots[i];
+    if (!slot->pending)
+      continue;
+    left--;
+    if (event_due(slot, now, &wait)) {
+      event_settle(slot, plat);
+      send_slider((uint8_t)i, slot->a, plat);
+    }
+  }
+  if (s_pk->touch_slot.pending && event_due(&s_pk->touch_slot, now, &wait)) {
+    event_settle(&s_pk->touch_slot, plat);
+    send_touch(s_pk->touch_slot.a, s_pk->touch_slot.b, plat);
+  }
+#else
+  (void)plat; /* nothing is ever coalesced */
+#endif
+  return wait;
 }
@@ -4,18 +4,128 @@
  *
  * All outgoing frames follow the same wire format as incoming frames.
  * Convenience helpers are provided for ACK, NACK, and common events.
+ *
+ * Frames go through a TX queue (dm_txq.h): with plat->write_async they
+ * are coalesced into DMA transfers, otherwise sent via write_bytes.
  */
 #ifndef DM_PACKET_H
 #define DM_PACKET_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "dm_config.h"
 #include "dm_platform.h"
+#include "dm_txq.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Rate-limit slot of one event source (see DM_EVENT_MIN_INTERVAL_MS). */
+typedef struct {
+  int16_t a, b;     /**< slider: value / – ; touch: x / y */
+  uint32_t last_ms; /**< When the last frame for this source went out */
+  bool started;     /**< last_ms is valid (a frame has been sent) */
+  bool pending;     /**< a/b hold a value not yet sent */
+} dm_event_slot_t;
+
+/**
+ * @brief Encoder state of one link (held in its dm_ctx_t).
+ *
+ * Private to dm_packet.c; public only so contexts can be allocated
+ * statically.  Every dm_packet call works on the state last given to
+ * dm_packet_bind(), which dm_core does for the context it is serving.
+ */
+typedef struct {
+  dm_txq_t txq;         /**< Outgoing frames awaiting (async) transmission */
+  uint8_t seq_counter;  /**< Auto-incremented for device-originated events */
+
+  bool capturing;       /**< ACK/NACK captured for CMD_BATCH */
+  uint8_t captured;
+
+  uint8_t ack_mode;     /**< Cumulative ACKs: a run of plain ACKs for */
+  uint8_t ack_first;    /**< consecutive seqs */
+  uint8_t ack_count;
+
+  uint8_t tx_version;   /**< Peer framing: v1 until CMD_GET_CAPS agrees */
+  uint16_t peer_max_payload;
+
+  uint8_t address;      /**< Own ADDRESS on replies (multi-drop) */
+  bool muted;           /**< Nothing at all is sent during a broadcast */
+
+  uint32_t nack_count;
+
+  dm_event_slot_t slider_slots[DM_MAX_WIDGETS];
+  dm_event_slot_t touch_slot;
+  uint16_t pending_events;
+} dm_packet_state_t;
+
+/**
+ * @brief Direct all following dm_packet calls at @p state.
+ * @param state  Encoder state of the link being served.
+ */
+void dm_packet_bind(dm_packet_state_t *state);
+
+/**
+ * @brief Reset the bound encoder state (event sequence counter, TX queue,
+ *        ACK mode, peer framing).  Keeps the address.
+ */
+void dm_packet_init(void);
+
+/**
+ * @brief Start the next queued async transfer if the transmitter is idle.
+ * @param plat  Platform interface.
+ */
+void dm_packet_tx_poll(const dm_platform_t *plat);
+
+/** @brief The TX queue, for its byte / drop / high-water counters. */
+dm_txq_t *dm_packet_txq(void);
+
+/** @brief Number of EVT_NACKs sent. */
+uint32_t dm_packet_nack_count(void);
+
+/**
+ * @brief Select per-command ACKs or cumulative EVT_ACK_RANGE replies.
+ * @param mode  DM_ACK_MODE_EACH or DM_ACK_MODE_CUMULATIVE.
+ */
+void dm_packet_set_ack_mode(uint8_t mode);
+
+/**
+ * @brief Set the framing used for outgoing frames.
+ *
+ * @param version      DM_PROTOCOL_V1 or DM_PROTOCOL_V2.
+ * @param max_payload  Largest payload the peer accepts; clamped to
+ *                     DM_MAX_PAYLOAD (and to 255 for v1).
+ */
+void dm_packet_set_peer(uint8_t version, uint16_t max_payload);
+
+/** @brief Protocol version of outgoing frames (DM_PROTOCOL_V1 by default). */
+uint8_t dm_packet_peer_version(void);
+
+/** @brief Largest payload the peer accepts; longer payloads are truncated. */
+uint16_t dm_packet_max_payload(void);
+
+/**
+ * @brief Set the ADDRESS stamped on outgoing frames.
+ * @param address  Own bus address, or DM_ADDR_NONE for unaddressed frames.
+ */
+void dm_packet_set_address(uint8_t address);
+
+/**
+ * @brief Drop every outgoing frame (ACK, NACK, event) while set.
+ *
+ * Used around broadcast commands: all panels act on them, none answers.
+ */
+void dm_packet_set_muted(bool muted);
+
+/**
+ * @brief Send any pending cumulative ACK range now.
+ *
+ * Called from dm_process(); also flushed automatically before any other
+ * outgoing frame so replies never overtake one another.
+ */
+void dm_packet_flush_acks(const dm_platform_t *plat);
+
 /**
  * @brief Build and send a generic frame.
  *
@@ -28,34 +138,123 @@ extern "C" {
 void dm_packet_send(uint8_t cmd,
                     uint8_t seq,
                     const uint8_t *payload,
-                    uint8_t payload_len,
+                    uint16_t payload_len,
                     const dm_platform_t *plat);
 
+/**
+ * @brief A frame being built in place in the TX queue.
+ *
+ * dm_packet_reserve() writes the header straight into the queue; the
+ * dm_packet_put_*() helpers append payload bytes and fold them into the
+ * running CRC as they go; dm_packet_commit() appends the CRC and queues
+ * the frame.  No other dm_packet call may be made in between.
+ */
+typedef struct {
+  uint8_t *buf;  /**< Start byte of the frame (NULL = no room, puts ignored) */
+  uint16_t len;  /**< Bytes written so far, header included */
+  uint16_t end;  /**< Header + payload length */
+  uint16_t crc;  /**< Running CRC over VERSION..buf[len-1] */
+} dm_tx_frame_t;
+
+/**
+ * @brief Start a frame with a @p payload_len byte payload in the TX queue.
+ *
+ * Pending cumulative ACKs are sent first.  @p payload_len is clamped to
+ * the peer's maximum; bytes put past it are dropped, and a payload left
+ * short is zero-padded by dm_packet_commit().
+ *
+ * @return false if there is no room (the frame is dropped; commit is
+ *         still safe to call).
+ */
+bool dm_packet_reserve(dm_tx_frame_t *f, uint8_t cmd, uint8_t seq,
+                       uint16_t payload_len, const dm_platform_t *plat);
+
+/** @brief Append one payload byte. */
+void dm_packet_put_u8(dm_tx_frame_t *f, uint8_t v);
+
+/** @brief Append a big-endian 16-bit payload value. */
+void dm_packet_put_u16(dm_tx_frame_t *f, uint16_t v);
+
+/** @brief Append @p len payload bytes. */
+void dm_packet_put(dm_tx_frame_t *f, const uint8_t *data, uint16_t len);
+
+/** @brief Finish the frame (CRC) and hand it to the TX queue. */
+void dm_packet_commit(dm_tx_frame_t *f, const dm_platform_t *plat);
+
 /**
  * @brief Send an ACK response (EVT_ACK) with optional payload.
  */
 void dm_packet_send_ack(uint8_t seq,
                         const dm_platform_t *plat,
                         const uint8_t *payload,
-                        uint8_t payload_len);
+                        uint16_t payload_len);
 
 /**
  * @brief Send a NACK response (EVT_NACK, no payload).
  */
 void dm_packet_send_nack(uint8_t seq, const dm_platform_t *plat);
 
+/**
+ * @brief Start capturing ACK/NACK responses instead of transmitting them.
+ *
+ * Used by CMD_BATCH so each sub-command's handler can reply as usual
+ * while the dispatcher collects the outcome.  Events are still sent.
+ */
+void dm_packet_capture_begin(void);
+
+/** Capture results returned by dm_packet_capture_end(). */
+#define DM_CAPTURE_NONE 0 /**< Handler sent neither ACK nor NACK */
+#define DM_CAPTURE_ACK  1 /**< Last response was an ACK */
+#define DM_CAPTURE_NACK 2 /**< Last response was a NACK */
+
+/**
+ * @brief Stop capturing and return the last captured response.
+ * @return DM_CAPTURE_NONE, DM_CAPTURE_ACK or DM_CAPTURE_NACK.
+ */
+uint8_t dm_packet_capture_end(void);
+
 /** @brief Send EVT_BUTTON_PRESSED. Payload: 1 byte widget_id index. */
 void dm_packet_send_button_pressed(uint8_t widget_idx, const dm_platform_t *plat);
 
-/** @brief Send EVT_SLIDER_CHANGED. Payload: 1 byte widget_idx + 2 byte int16 value. */
+/**
+ * @brief Send EVT_SLIDER_CHANGED. Payload: 1 byte widget_idx + 2 byte int16 value.
+ *
+ * Rate-limited per widget to one frame per DM_EVENT_MIN_INTERVAL_MS;
+ * values arriving faster are coalesced and only the latest is sent, by
+ * dm_packet_poll_events() once the interval has elapsed.
+ */
 void dm_packet_send_slider_changed(uint8_t widget_idx, int16_t value, const dm_platform_t *plat);
 
+/**
+ * @brief Send the final EVT_SLIDER_CHANGED for a released slider.
+ *
+ * Always sent immediately (bypasses the rate limit) and discards any
+ * coalesced value still pending for the widget.
+ */
+void dm_packet_send_slider_settled(uint8_t widget_idx, int16_t value, const dm_platform_t *plat);
+
 /** @brief Send EVT_PAGE_CHANGED. Payload: 1 byte page_id. */
 void dm_packet_send_page_changed(uint8_t page_id, const dm_platform_t *plat);
 
-/** @brief Send EVT_TOUCH_EVENT. Payload: 2 × int16_t (x, y). */
+/**
+ * @brief Send EVT_TOUCH_EVENT. Payload: 2 × int16_t (x, y).
+ *
+ * Rate-limited and coalesced like dm_packet_send_slider_changed().
+ */
 void dm_packet_send_touch_event(int16_t x, int16_t y, const dm_platform_t *plat);
 
+/** @brief Send the final EVT_TOUCH_EVENT on release (never rate-limited). */
+void dm_packet_send_touch_settled(int16_t x, int16_t y, const dm_platform_t *plat);
+
+/**
+ * @brief Send coalesced events whose rate-limit interval has elapsed.
+ *
+ * Called from dm_process().
+ *
+ * @return ms until the next coalesced event is due, or DM_WAIT_FOREVER.
+ */
+uint32_t dm_packet_poll_events(const dm_platform_t *plat);
+
 #ifdef __cplusplus
 }
 #endif
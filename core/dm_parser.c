@@ -3,11 +3,14 @@
  * @brief Byte-at-a-time frame parser with automatic re-synchronisation.
  *
  * CRC is computed over bytes VERSION..PAYLOAD (everything between the start
- * byte and the two CRC bytes).  On CRC failure the parser resets to
- * PARSE_WAIT_START with no frame delivery.
+ * byte and the two CRC bytes).  On CRC failure the frame is not delivered
+ * and the parser resyncs – from inside the failed frame's bytes when
+ * DM_RX_RESCAN is enabled.  Frames addressed to another panel are skipped
+ * by length without CRC or copy.
  */
 #include "dm_parser.h"
 #include "dm_protocol.h"
+#include "dm_trace.h"
 #include "crc16.h"
 
 #include <string.h>
@@ -23,6 +26,94 @@ static void parser_reset(dm_parser_t *p)
     p->payload_index = 0;
     p->running_crc   = 0xFFFFU;
     p->crc_high      = 0;
+    p->len_high      = 0;
+    p->addressed     = false;
+    p->not_for_us    = false;
+    p->frame.address = DM_ADDR_NONE;
+    p->frame.data    = p->frame.payload;
+}
+
+#if DM_RX_RESCAN
+/*
+ * Copy the bytes received since the start byte of the frame in progress
+ * (header fields, payload so far, CRC MSB) into rescan_buf.
+ */
+static size_t rebuild_frame(dm_parser_t *p)
+{
+    uint8_t *raw = p->rescan_buf;
+    size_t   n   = 0;
+    bool     v2  = p->frame.version == DM_PROTOCOL_V2;
+
+    if (p->state > PARSE_VERSION)
+        raw[n++] = (uint8_t)(p->frame.version | (p->addressed ? DM_VERSION_ADDR_FLAG : 0));
+    if (p->addressed && p->state > PARSE_ADDRESS) raw[n++] = p->frame.address;
+    if (p->state > PARSE_COMMAND)              raw[n++] = p->frame.command;
+    if (p->state > PARSE_SEQ_ID)               raw[n++] = p->frame.seq_id;
+    if (v2 && p->state > PARSE_LENGTH_HIGH)    raw[n++] = p->len_high;
+    if (p->state > PARSE_LENGTH)               raw[n++] = (uint8_t)p->frame.payload_len;
+    if (p->state >= PARSE_PAYLOAD) {
+        memcpy(&raw[n], p->frame.data, p->payload_index);
+        n += p->payload_index;
+    }
+    if (p->state > PARSE_CRC_HIGH)             raw[n++] = p->crc_high;
+    return n;
+}
+
+/*
+ * Re-feed rescan_buf[0..n) starting at each embedded start byte in turn.
+ * A frame that fails again restarts the scan just past its own start byte;
+ * one still incomplete when the buffer runs out continues with live bytes.
+ */
+static void rescan(dm_parser_t *p, size_t n, const dm_platform_t *plat)
+{
+    const uint8_t *raw = p->rescan_buf;
+    size_t         pos = 0;
+
+    p->rescanning = true;
+    while (pos < n) {
+        const uint8_t *s = memchr(&raw[pos], DM_START_BYTE, n - pos);
+        if (!s) break;
+
+        size_t start = (size_t)(s - raw);
+        p->rescan_failed = false;
+        for (size_t i = start; i < n; i++) {
+            if (p->state == PARSE_WAIT_START && raw[i] == DM_START_BYTE) start = i;
+            dm_parser_feed(p, raw[i], plat);
+            if (p->rescan_failed) break;
+        }
+        if (!p->rescan_failed) break;
+        pos = start + 1;
+    }
+    p->rescanning = false;
+}
+#endif
+
+/* A frame went bad on @p byte (if @p with_byte): resync past its start. */
+static void frame_failed(dm_parser_t *p, bool with_byte, uint8_t byte,
+                         const dm_platform_t *plat)
+{
+    if (p->state == PARSE_SKIP) {
+        /* Only ever timeouts; a skipped frame's bytes are not kept. */
+        parser_reset(p);
+        return;
+    }
+#if DM_RX_RESCAN
+    if (p->rescanning) {
+        /* Already inside rescan(): it moves on to the next start byte. */
+        p->rescan_failed = true;
+        parser_reset(p);
+        return;
+    }
+    size_t n = rebuild_frame(p);
+    if (with_byte) p->rescan_buf[n++] = byte;
+    parser_reset(p);
+    rescan(p, n, plat);
+#else
+    (void)with_byte;
+    (void)byte;
+    (void)plat;
+    parser_reset(p);
+#endif
 }
 
 /* ── public API ───────────────────────────────────────────────────────────── */
@@ -33,6 +124,11 @@ void dm_parser_init(dm_parser_t *p)
     parser_reset(p);
 }
 
+void dm_parser_set_address(dm_parser_t *p, uint8_t address)
+{
+    p->address = address;
+}
+
 void dm_parser_feed(dm_parser_t *p, uint8_t byte, const dm_platform_t *plat)
 {
     switch (p->state) {
@@ -48,7 +144,22 @@ void dm_parser_feed(dm_parser_t *p, uint8_t byte, const dm_platform_t *plat)
 
     /* ── Header bytes – accumulate CRC ───────────────────────────────── */
     case PARSE_VERSION:
-        p->frame.version = byte;
+        p->addressed     = (byte & DM_VERSION_ADDR_FLAG) != 0;
+        p->frame.version = (uint8_t)(byte & ~DM_VERSION_ADDR_FLAG);
+        p->running_crc   = crc16_update(p->running_crc, byte);
+        if (p->addressed) {
+            p->state = PARSE_ADDRESS;
+        } else {
+            /* On a multi-drop bus only addressed frames are for us. */
+            p->not_for_us = p->address != DM_ADDR_NONE;
+            p->state      = PARSE_COMMAND;
+        }
+        break;
+
+    case PARSE_ADDRESS:
+        p->frame.address = byte;
+        p->not_for_us    = p->address != DM_ADDR_NONE && byte != p->address &&
+                           byte != DM_ADDR_BROADCAST;
         p->running_crc   = crc16_update(p->running_crc, byte);
         p->state         = PARSE_COMMAND;
         break;
@@ -62,29 +173,47 @@ void dm_parser_feed(dm_parser_t *p, uint8_t byte, const dm_platform_t *plat)
     case PARSE_SEQ_ID:
         p->frame.seq_id = byte;
         p->running_crc  = crc16_update(p->running_crc, byte);
-        p->state        = PARSE_LENGTH;
+        p->state        = (p->frame.version == DM_PROTOCOL_V2) ? PARSE_LENGTH_HIGH
+                                                               : PARSE_LENGTH;
+        break;
+
+    case PARSE_LENGTH_HIGH:
+        p->len_high    = byte;
+        p->running_crc = crc16_update(p->running_crc, byte);
+        p->state       = PARSE_LENGTH;
         break;
 
-    case PARSE_LENGTH:
-        if (byte > DM_MAX_PAYLOAD) {
+    case PARSE_LENGTH: {
+        uint16_t len = byte;
+        if (p->frame.version == DM_PROTOCOL_V2) len |= (uint16_t)p->len_high << 8;
+
+        if (p->not_for_us) {
+            /* Someone else's frame: step over payload and CRC unread. */
+            p->frames_skipped++;
+            p->skip_left = (uint32_t)len + DM_CRC_SIZE;
+            p->state     = PARSE_SKIP;
+            break;
+        }
+        if (len > DM_MAX_PAYLOAD) {
             /* Payload larger than our buffer – discard and resync. */
             p->frames_len_err++;
 #if DM_DEBUG_LOG
             if (plat && plat->log) plat->log("DM: frame length overflow, resyncing");
 #endif
-            parser_reset(p);
+            frame_failed(p, true, byte, plat);
             break;
         }
-        p->frame.payload_len = byte;
+        p->frame.payload_len = len;
         p->running_crc       = crc16_update(p->running_crc, byte);
         p->payload_index     = 0;
 
-        if (byte == 0) {
+        if (len == 0) {
             p->state = PARSE_CRC_HIGH;   /* zero-length payload */
         } else {
             p->state = PARSE_PAYLOAD;
         }
         break;
+    }
 
     /* ── Payload bytes ────────────────────────────────────────────────── */
     case PARSE_PAYLOAD:
@@ -107,19 +236,85 @@ void dm_parser_feed(dm_parser_t *p, uint8_t byte, const dm_platform_t *plat)
 
         if (received_crc == p->running_crc) {
             p->frames_ok++;
+            p->frame.crc = received_crc;
+            DM_TRACE_EVT(DM_TRACE_FRAME_RX, p->frame.command, p->frame.payload_len);
             dm_protocol_dispatch(&p->frame, plat);
+            parser_reset(p);
         } else {
             p->frames_crc_err++;
 #if DM_DEBUG_LOG
             if (plat && plat->log) plat->log("DM: CRC mismatch, frame dropped");
 #endif
+            frame_failed(p, true, byte, plat);
         }
-        parser_reset(p);
         break;
     }
 
+    case PARSE_SKIP:
+        if (--p->skip_left == 0) parser_reset(p);
+        break;
+
     default:
         parser_reset(p);
         break;
     }
 }
+
+void dm_parser_feed_buf(dm_parser_t *p, const uint8_t *buf, size_t n,
+                        const dm_platform_t *plat)
+{
+    while (n > 0) {
+        if (p->state == PARSE_WAIT_START) {
+            /* Skip everything up to (and including) the next start byte. */
+            const uint8_t *start = memchr(buf, DM_START_BYTE, n);
+            if (!start) break;
+            n  -= (size_t)(start - buf) + 1;
+            buf = start + 1;
+            parser_reset(p);
+            p->state = PARSE_VERSION;
+        } else if (p->state == PARSE_PAYLOAD) {
+            size_t chunk = p->frame.payload_len - p->payload_index;
+            if (chunk > n) chunk = n;
+            if (chunk == p->frame.payload_len) {
+                /* Whole payload in this span: dispatch it in place. */
+                p->frame.data = buf;
+            } else {
+                /* Split across spans: stage what this span holds. */
+                memcpy(&p->frame.payload[p->payload_index], buf, chunk);
+            }
+            p->running_crc    = crc16_update_buf(p->running_crc, buf, chunk);
+            p->payload_index += (uint16_t)chunk;
+            buf += chunk;
+            n   -= chunk;
+            if (p->payload_index >= p->frame.payload_len) {
+                p->state = PARSE_CRC_HIGH;
+            }
+        } else if (p->state == PARSE_SKIP) {
+            size_t chunk = p->skip_left;
+            if (chunk > n) chunk = n;
+            p->skip_left -= (uint32_t)chunk;
+            buf += chunk;
+            n   -= chunk;
+            if (p->skip_left == 0) parser_reset(p);
+        } else {
+            dm_parser_feed(p, *buf++, plat);
+            n--;
+        }
+    }
+
+    /* buf is gone after we return: keep a pending in-place payload. */
+    if (p->frame.data != p->frame.payload) {
+        memcpy(p->frame.payload, p->frame.data, p->payload_index);
+        p->frame.data = p->frame.payload;
+    }
+}
+
+void dm_parser_expire(dm_parser_t *p, const dm_platform_t *plat)
+{
+    if (p->state == PARSE_WAIT_START) return;
+    p->frames_timeout++;
+#if DM_DEBUG_LOG
+    if (plat && plat->log) plat->log("DM: inter-byte timeout, frame dropped");
+#endif
+    frame_failed(p, false, 0, plat);
+}
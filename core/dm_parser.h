@@ -2,11 +2,12 @@
  * @file dm_parser.h
  * @brief Frame state-machine parser.
  *
- * Processes one byte at a time (dm_parser_feed).
+ * Processes one byte at a time (dm_parser_feed) or a whole span of
+ * received bytes (dm_parser_feed_buf).
  * Performs CRC validation and calls dm_protocol_dispatch on a valid frame.
  * Handles re-synchronisation on corrupted/truncated frames.
  *
- * Frame layout:
+ * Frame layout (v1):
  *   [0]    START  (0xAA)
  *   [1]    VERSION
  *   [2]    COMMAND
@@ -15,11 +16,30 @@
  *   [5..N] PAYLOAD
  *   [N+1]  CRC_HIGH
  *   [N+2]  CRC_LOW
+ *
+ * A VERSION of DM_PROTOCOL_V2 selects a 16-bit big-endian PAYLOAD_LENGTH
+ * in bytes [4..5]; everything else is identical.  Both versions are
+ * always accepted, frame by frame.
+ *
+ * Multi-drop: a VERSION with DM_VERSION_ADDR_FLAG set is followed by an
+ * ADDRESS byte (covered by the CRC).  Once the parser has an address of
+ * its own (dm_parser_set_address()), frames for other addresses – and
+ * unaddressed ones – are skipped by length as soon as the header is in:
+ * their payload is neither copied nor CRC'd.  DM_ADDR_BROADCAST frames
+ * are accepted by everyone.
+ *
+ * Resync: 0xAA may occur inside a payload, so a corrupted or truncated
+ * frame can start in the wrong place.  When a frame fails (CRC, length, or
+ * dm_parser_expire() timeout) and DM_RX_RESCAN is set, the bytes after its
+ * start byte are scanned again for the next 0xAA rather than dropped, so
+ * a good frame caught inside a bad one still gets through.
  */
 #ifndef DM_PARSER_H
 #define DM_PARSER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "dm_config.h"
 #include "dm_platform.h"
 
@@ -29,23 +49,34 @@ extern "C" {
 
 /** Parsed frame handed to the dispatcher. */
 typedef struct {
-    uint8_t  version;
+    uint8_t  version;      /**< Without DM_VERSION_ADDR_FLAG */
+    uint8_t  address;      /**< ADDRESS byte, DM_ADDR_NONE if the frame had none */
     uint8_t  command;
     uint8_t  seq_id;
-    uint8_t  payload_len;
-    uint8_t  payload[DM_MAX_PAYLOAD];
+    uint16_t payload_len;
+    uint16_t crc;          /**< Received (validated) CRC – identifies retransmits */
+    /**
+     * Payload bytes.  When dm_parser_feed_buf() sees a whole payload in one
+     * span this points into that span (no copy); otherwise at payload[].
+     * Valid only during dm_protocol_dispatch().
+     */
+    const uint8_t *data;
+    uint8_t  payload[DM_MAX_PAYLOAD]; /**< Staging for payloads split across spans */
 } dm_frame_t;
 
 /** Parser states (internal – exposed for unit-testing only). */
 typedef enum {
     PARSE_WAIT_START = 0,
     PARSE_VERSION,
+    PARSE_ADDRESS,         /**< Addressed frames only */
     PARSE_COMMAND,
     PARSE_SEQ_ID,
+    PARSE_LENGTH_HIGH,     /**< v2 only */
     PARSE_LENGTH,
     PARSE_PAYLOAD,
     PARSE_CRC_HIGH,
     PARSE_CRC_LOW,
+    PARSE_SKIP,            /**< Payload + CRC of a frame for another address */
 } dm_parse_state_t;
 
 /** Parser context – one instance per interface. */
@@ -55,11 +86,24 @@ typedef struct {
     uint16_t         payload_index;
     uint16_t         running_crc;   /**< CRC accumulated over VERSION..PAYLOAD */
     uint8_t          crc_high;      /**< Received CRC MSB */
+    uint8_t          len_high;      /**< Received v2 PAYLOAD_LENGTH MSB */
+    uint8_t          address;       /**< Own bus address, DM_ADDR_NONE = accept all */
+    bool             addressed;     /**< Frame in progress has an ADDRESS byte */
+    bool             not_for_us;    /**< Frame in progress will be skipped */
+    uint32_t         skip_left;     /**< Bytes still to skip in PARSE_SKIP */
+
+#if DM_RX_RESCAN
+    bool             rescanning;    /**< Re-feeding rescan_buf */
+    bool             rescan_failed; /**< A frame failed while rescanning */
+    uint8_t          rescan_buf[DM_MAX_FRAME_SIZE]; /**< Bytes of a failed frame */
+#endif
 
     /* Statistics (read-only for host) */
     uint32_t frames_ok;
     uint32_t frames_crc_err;
     uint32_t frames_len_err;
+    uint32_t frames_timeout;        /**< Partial frames dropped by dm_parser_expire() */
+    uint32_t frames_skipped;        /**< Frames for other bus addresses */
 } dm_parser_t;
 
 /**
@@ -68,6 +112,13 @@ typedef struct {
  */
 void dm_parser_init(dm_parser_t *p);
 
+/**
+ * @brief Set the bus address this parser accepts frames for.
+ * @param p        Parser instance.
+ * @param address  1..254, or DM_ADDR_NONE to accept every frame.
+ */
+void dm_parser_set_address(dm_parser_t *p, uint8_t address);
+
 /**
  * @brief Feed one byte into the parser.
  *
@@ -79,6 +130,36 @@ void dm_parser_init(dm_parser_t *p);
  */
 void dm_parser_feed(dm_parser_t *p, uint8_t byte, const dm_platform_t *plat);
 
+/**
+ * @brief Feed a span of bytes into the parser.
+ *
+ * Behaves exactly like calling dm_parser_feed() for each byte, but scans
+ * for the start byte with memchr() and CRCs payload runs in bulk.  A frame
+ * whose payload lies entirely inside @p buf is dispatched with
+ * frame.data pointing into @p buf – @p buf must stay untouched until the
+ * call returns.  Partial payloads are copied into frame.payload[] before
+ * returning, so the next span may arrive in a different buffer.
+ *
+ * @param p     Parser instance.
+ * @param buf   Received bytes.
+ * @param n     Number of bytes in @p buf.
+ * @param plat  Platform interface (for logging).
+ */
+void dm_parser_feed_buf(dm_parser_t *p, const uint8_t *buf, size_t n,
+                        const dm_platform_t *plat);
+
+/**
+ * @brief Drop the frame in progress, if any (inter-byte timeout).
+ *
+ * Called by dm_process() when the line has been idle for DM_RX_TIMEOUT_MS
+ * in the middle of a frame.  The dropped bytes are rescanned like those of
+ * a CRC failure.
+ *
+ * @param p     Parser instance.
+ * @param plat  Platform interface (for logging).
+ */
+void dm_parser_expire(dm_parser_t *p, const dm_platform_t *plat);
+
 #ifdef __cplusplus
 }
 #endif
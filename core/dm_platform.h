@@ -6,13 +6,15 @@
  * through this structure, which the board layer fills in and passes
  * to dm_init().
  *
- * Board ports MUST implement every function pointer (no NULLs).
+ * Board ports MUST implement every function pointer (no NULLs), except
+ * the entries explicitly documented as optional.
  */
 #ifndef DM_PLATFORM_H
 #define DM_PLATFORM_H
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,7 +24,7 @@ extern "C" {
  * @brief Platform interface vtable.
  *
  * Filled by the board layer, injected into the core via dm_init().
- * No function pointer may be NULL.
+ * Only entries marked "optional" may be NULL.
  */
 typedef struct {
     /**
@@ -32,12 +34,51 @@ typedef struct {
      */
     void (*write_bytes)(const uint8_t *data, uint16_t len);
 
+    /**
+     * @brief Optional: start a non-blocking transmit (DMA / IRQ driven).
+     *
+     * Must return immediately.  @p data stays valid and untouched until the
+     * board calls dm_tx_complete() (typically from the DMA-complete ISR).
+     * The core never starts a second transfer before that.  When NULL,
+     * the core falls back to write_bytes() for every frame.
+     *
+     * @param data  Pointer to bytes to send.
+     * @param len   Number of bytes.
+     */
+    void (*write_async)(const uint8_t *data, uint16_t len);
+
+    /**
+     * @brief Optional: drive the RS485 transceiver's driver-enable (DE) line.
+     *
+     * Called with true before each transmission starts and with false once
+     * it has finished – straight after write_bytes() returns, or from
+     * dm_tx_complete() (so possibly in interrupt context) for write_async().
+     * Release the line only after the last stop bit has left the UART
+     * (e.g. wait for the TX-complete flag), or the final byte is cut off.
+     * Leave NULL on point-to-point links.
+     *
+     * @param enable  true = drive the bus, false = release it to receive.
+     */
+    void (*bus_tx_enable)(bool enable);
+
     /**
      * @brief Return a monotonically increasing millisecond counter.
      * @return Milliseconds since boot (may wrap).
      */
     uint32_t (*millis)(void);
 
+    /**
+     * @brief Optional: free-running microsecond counter (wraps at 2^32).
+     *
+     * Used to time command dispatch and rendering for CMD_GET_STATS and to
+     * stamp trace events.  With DM_TRACE_DEPTH > 0 it is also called from
+     * dm_tx_complete(), so it must be ISR-safe.  When NULL, millis() × 1000
+     * is used instead.
+     *
+     * @return Microseconds since boot (may wrap).
+     */
+    uint32_t (*micros)(void);
+
     /**
      * @brief Emit a null-terminated debug string.
      * @param msg  Message to log (no newline required).
@@ -2,70 +2,410 @@
  * @file dm_protocol.c
  * @brief Protocol dispatcher – routes validated frames to handler functions.
  *
- * Handlers are defined as __attribute__((weak)) here so the application
- * binder (app/dm_binder.c) can override individual ones without touching
- * the core.  Handlers not overridden send an automatic NACK.
+ * Commands are looked up in a 256-entry table (handler + payload length
+ * limits), so dispatch costs the same for every ID.  The built-in table is
+ * const; dm_protocol_register() installs runtime handlers on top of it.
+ *
+ * The dm_handle_* entries are defined as __attribute__((weak)) here so
+ * the application binder (app/dm_binder.c) can also override individual
+ * ones at link time.  Handlers not overridden send an automatic NACK.
  */
 #include "dm_protocol.h"
+#include "dm_core.h"
 #include "dm_packet.h"
+#include "dm_bulk.h"
+#include "dm_trace.h"
 
+#include <stdbool.h>
 #include <string.h>
 
+// Sequence window
+
+/*
+ * The last DM_SEQ_WINDOW host commands, slotted by seq % DM_SEQ_WINDOW.
+ * A frame whose SEQ_ID *and* CRC match a slot is a retransmit (the host
+ * missed our reply): the cached response is sent again and the handler is
+ * not re-run.  Keying on the CRC as well means a host that restarts its
+ * sequence numbering with different commands is never answered from stale
+ * entries.  Responses with more than DM_SEQ_CACHE_DATA bytes of ACK data
+ * are not cached; such commands simply run again on retransmit.  Each link
+ * has its own window, in the dm_protocol_state_t of its context.
+ */
+static dm_protocol_state_t *s_pr = NULL; /* Link being served */
+
+void dm_protocol_bind(dm_protocol_state_t *state) { s_pr = state; }
+
+void dm_protocol_note_response(uint8_t seq, uint8_t evt, const uint8_t *payload,
+                               uint16_t len) {
+  dm_seq_entry_t *e = s_pr->recording;
+  if (!e || e->seq != seq)
+    return;
+  s_pr->recording = NULL; /* first response wins */
+  if (len > DM_SEQ_CACHE_DATA)
+    return;
+  e->evt = evt;
+  e->len = len;
+  if (len > 0)
+    memcpy(e->data, payload, len);
+  e->valid = true;
+}
+
+uint32_t dm_protocol_dup_count(void) { return s_pr->dup_count; }
+
+const dm_timing_t *dm_protocol_dispatch_timing(void) {
+  return &s_pr->dispatch_timing;
+}
+
+void dm_protocol_clear_timing(void) {
+  dm_timing_clear(&s_pr->dispatch_timing);
+}
+
 // Dispatcher
 
+/* Runtime registrations: s_registered_slot[cmd] = index + 1, 0 = none */
+static dm_cmd_entry_t s_registered[DM_PROTOCOL_MAX_HANDLERS];
+static uint8_t s_registered_slot[256];
+static uint8_t s_registered_count = 0;
+
 void dm_protocol_init(void) {
-  /* Nothing to initialise yet; reserved for future seq-id tracking. */
+  memset(s_pr->seq_window, 0, sizeof(s_pr->seq_window));
+  s_pr->recording = NULL;
+  s_pr->dup_count = 0;
+  dm_timing_clear(&s_pr->dispatch_timing);
 }
 
-void dm_protocol_dispatch(const dm_frame_t *frame, const dm_platform_t *plat) {
-  switch (frame->command) {
-  case CMD_PING:
-    dm_handle_ping(frame->seq_id, frame->payload, frame->payload_len, plat);
-    break;
-  case CMD_GET_VERSION:
-    dm_handle_get_version(frame->seq_id, frame->payload, frame->payload_len,
-                          plat);
-    break;
-  case CMD_RESET:
-    dm_handle_reset(frame->seq_id, frame->payload, frame->payload_len, plat);
-    break;
-  case CMD_ENTER_BOOTLOADER:
-    dm_handle_enter_bootloader(frame->seq_id, frame->payload,
-                               frame->payload_len, plat);
-    break;
-  case CMD_SHOW_PAGE:
-    dm_handle_show_page(frame->seq_id, frame->payload, frame->payload_len,
-                        plat);
-    break;
-  case CMD_SET_TEXT:
-    dm_handle_set_text(frame->seq_id, frame->payload, frame->payload_len, plat);
-    break;
-  case CMD_SET_VALUE:
-    dm_handle_set_value(frame->seq_id, frame->payload, frame->payload_len,
-                        plat);
-    break;
-  case CMD_SET_VISIBLE:
-    dm_handle_set_visible(frame->seq_id, frame->payload, frame->payload_len,
-                          plat);
-    break;
-  case CMD_SET_ENABLED:
-    dm_handle_set_enabled(frame->seq_id, frame->payload, frame->payload_len,
-                          plat);
-    break;
-  default:
+void dm_protocol_unregister_all(void) {
+  memset(s_registered_slot, 0, sizeof(s_registered_slot));
+  s_registered_count = 0;
+}
+
+static void dispatch_command(uint8_t cmd, uint8_t seq, const uint8_t *p,
+                             uint16_t len, const dm_platform_t *plat);
+
+/*
+ * Smallest max_payload a host may ask for: the largest fixed-size reply
+ * (CMD_GET_STATS).  Anything lower would truncate replies for good.
+ */
+#define MIN_PEER_PAYLOAD (DM_STATS_WIRE_FIELDS * 4)
+
+/*
+ * CMD_GET_CAPS: [host_version:u8][host_max_payload:u16] (both optional)
+ *   → ACK [version:u8][max_payload:u16][features:u16][seq_window:u8]
+ * With a request payload the agreed values (lower of both sides) take
+ * effect after the reply, which is encoded at once and so still goes out
+ * in the old framing.  An empty request only reports what the device
+ * supports.  A host_max_payload below MIN_PEER_PAYLOAD is NACKed and
+ * changes nothing.
+ */
+static void handle_get_caps(uint8_t seq, const uint8_t *p, uint16_t len,
+                            const dm_platform_t *plat) {
+  uint8_t version = DM_PROTOCOL_VERSION;
+  uint16_t max = DM_MAX_PAYLOAD;
+  if (len >= 1 && p[0] < version)
+    version = p[0] < DM_PROTOCOL_V1 ? DM_PROTOCOL_V1 : p[0];
+  if (len >= 3) {
+    uint16_t host_max = (uint16_t)(((uint16_t)p[1] << 8) | p[2]);
+    if (host_max < MIN_PEER_PAYLOAD) {
+      dm_packet_send_nack(seq, plat);
+      return;
+    }
+    if (host_max < max)
+      max = host_max;
+  }
+  if (len >= 1 && version < DM_PROTOCOL_V2 && max > 0xFF)
+    max = 0xFF;
+
+  uint16_t features = DM_FEAT_BATCH | DM_FEAT_SEQ_WINDOW | DM_FEAT_BULK |
+                      DM_FEAT_SET_VALUES | DM_FEAT_STATE_HASH;
+#if DM_LAYOUT_MAX_SIZE > 0
+  features |= DM_FEAT_LAYOUT;
+#endif
+#if DM_TRACE_DEPTH > 0
+  features |= DM_FEAT_TRACE;
+#endif
+#if DM_MAX_STRINGS > 0
+  features |= DM_FEAT_STRINGS;
+#endif
+  uint8_t caps[6] = {version,
+                     (uint8_t)(max >> 8),
+                     (uint8_t)(max & 0xFF),
+                     (uint8_t)(features >> 8),
+                     (uint8_t)(features & 0xFF),
+                     DM_SEQ_WINDOW};
+  dm_packet_send_ack(seq, plat, caps, sizeof(caps));
+  if (len >= 1)
+    dm_packet_set_peer(version, max);
+}
+
+static uint8_t *put_u32(uint8_t *b, uint32_t v) {
+  b[0] = (uint8_t)(v >> 24);
+  b[1] = (uint8_t)(v >> 16);
+  b[2] = (uint8_t)(v >> 8);
+  b[3] = (uint8_t)v;
+  return b + 4;
+}
+
+static uint8_t *put_timing(uint8_t *b, const dm_timing_t *t) {
+  b = put_u32(b, t->count);
+  b = put_u32(b, t->min_us);
+  b = put_u32(b, dm_timing_avg(t));
+  return put_u32(b, t->max_us);
+}
+
+/*
+ * CMD_GET_STATS: [flags:u8] (optional, DM_STATS_FLAG_CLEAR)
+ *   → ACK DM_STATS_WIRE_FIELDS × u32 BE, in dm_stats_t order
+ * The snapshot is taken before this command's own reply and timing.
+ */
+static void handle_get_stats(uint8_t seq, const uint8_t *p, uint16_t len,
+                             const dm_platform_t *plat) {
+  dm_stats_t st;
+  dm_ctx_get_stats(dm_ctx_current(), &st);
+
+  uint8_t out[DM_STATS_WIRE_FIELDS * 4];
+  uint8_t *b = out;
+  b = put_u32(b, st.rx_bytes);
+  b = put_u32(b, st.frames_ok);
+  b = put_u32(b, st.frames_crc_err);
+  b = put_u32(b, st.frames_len_err);
+  b = put_u32(b, st.frames_timeout);
+  b = put_u32(b, st.frames_skipped);
+  b = put_u32(b, st.rx_overflows);
+  b = put_u32(b, st.rx_ring_peak);
+  b = put_u32(b, st.tx_bytes);
+  b = put_u32(b, st.tx_dropped);
+  b = put_u32(b, st.tx_queue_peak);
+  b = put_u32(b, st.nacks);
+  b = put_u32(b, st.duplicates);
+  b = put_timing(b, &st.dispatch);
+  put_timing(b, &st.render);
+  dm_packet_send_ack(seq, plat, out, sizeof(out));
+
+  if (len >= 1 && (p[0] & DM_STATS_FLAG_CLEAR))
+    dm_ctx_clear_stats_peaks(dm_ctx_current());
+}
+
+#if DM_TRACE_DEPTH > 0
+/*
+ * CMD_GET_TRACE: [from:u32 BE] (optional, default 0)
+ *   → ACK [head:u32][first:u32] then entries first, first+1, … as
+ *     [t_us:u32][event:u8][arg:u8][value:u16], as many as fit
+ * The host asks again from first + count until it reaches head.
+ */
+static void handle_get_trace(uint8_t seq, const uint8_t *p, uint16_t len,
+                             const dm_platform_t *plat) {
+  static uint8_t out[DM_MAX_PAYLOAD];
+  dm_trace_entry_t e[8];
+
+  uint32_t from = 0;
+  if (len >= 4)
+    from = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+
+  uint16_t room = dm_packet_max_payload();
+  uint32_t max = room > 8 ? (room - 8U) / DM_TRACE_WIRE_SIZE : 0;
+  uint32_t head = dm_trace_head();
+  uint32_t first = from;
+  uint8_t *b = out + 8;
+  for (uint32_t done = 0; done < max;) {
+    uint32_t at, want = max - done;
+    if (want > 8)
+      want = 8;
+    uint32_t n = dm_trace_read(from, e, want, &at);
+    if (done == 0)
+      first = at;
+    if (n == 0)
+      break;
+    for (uint32_t i = 0; i < n; i++) {
+      b = put_u32(b, e[i].t_us);
+      *b++ = e[i].event;
+      *b++ = e[i].arg;
+      *b++ = (uint8_t)(e[i].value >> 8);
+      *b++ = (uint8_t)e[i].value;
+    }
+    done += n;
+    from = at + n;
+  }
+  put_u32(out, head);
+  put_u32(out + 4, first);
+  dm_packet_send_ack(seq, plat, out, (uint16_t)(b - out));
+}
+#endif
+
+/* CMD_SET_ACK_MODE: the ACK goes out in the old mode. */
+static void handle_set_ack_mode(uint8_t seq, const uint8_t *p, uint16_t len,
+                                const dm_platform_t *plat) {
+  (void)len;
+  if (p[0] > DM_ACK_MODE_CUMULATIVE) {
+    dm_packet_send_nack(seq, plat);
+    return;
+  }
+  dm_packet_send_ack(seq, plat, NULL, 0);
+  dm_packet_set_ack_mode(p[0]);
+}
+
+/*
+ * CMD_BATCH payload: a sequence of [cmd:u8][len:u8][payload:len] records.
+ * The whole layout is validated before anything runs, so a malformed batch
+ * has no side effects.  Sub-commands run in order through the normal
+ * handlers with their ACK/NACK captured; one ACK answers the batch:
+ *   [count:u8][status bitmap, bit i (LSB-first) = sub-command i ACKed]
+ */
+static void dispatch_batch(uint8_t seq, const uint8_t *p, uint16_t len,
+                           const dm_platform_t *plat) {
+  uint8_t count = 0;
+  for (uint16_t off = 0; off < len; count++) {
+    if (count >= DM_BATCH_MAX_CMDS || len - off < 2 ||
+        p[off + 1] > len - off - 2 || p[off] == CMD_BATCH) {
+      dm_packet_send_nack(seq, plat);
+      return;
+    }
+    off += 2 + p[off + 1];
+  }
+
+  uint8_t ack[1 + (DM_BATCH_MAX_CMDS + 7) / 8] = {0};
+  ack[0] = count;
+
+  uint16_t off = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t sub_len = p[off + 1];
+    dm_packet_capture_begin();
+    dispatch_command(p[off], seq, &p[off + 2], sub_len, plat);
+    if (dm_packet_capture_end() == DM_CAPTURE_ACK) {
+      ack[1 + i / 8] |= (uint8_t)(1U << (i % 8));
+    }
+    off += 2 + sub_len;
+  }
+
+  dm_packet_send_ack(seq, plat, ack, (uint8_t)(1 + (count + 7) / 8));
+}
+
+/*
+ * Built-in commands, indexed by command ID.  Lengths are checked here once,
+ * so handlers may index their fixed fields directly.  const: lives in
+ * flash on the MCU targets.
+ */
+#define ANY_LEN DM_MAX_PAYLOAD
+static const dm_cmd_entry_t s_cmd_table[256] = {
+    [CMD_PING] = {dm_handle_ping, 0, ANY_LEN},
+    [CMD_GET_VERSION] = {dm_handle_get_version, 0, ANY_LEN},
+    [CMD_RESET] = {dm_handle_reset, 0, ANY_LEN},
+    [CMD_ENTER_BOOTLOADER] = {dm_handle_enter_bootloader, 0, ANY_LEN},
+    [CMD_SET_ACK_MODE] = {handle_set_ack_mode, 1, 1},
+    [CMD_GET_CAPS] = {handle_get_caps, 0, 3},
+    [CMD_GET_STATS] = {handle_get_stats, 0, 1},
+#if DM_TRACE_DEPTH > 0
+    [CMD_GET_TRACE] = {handle_get_trace, 0, 4},
+#endif
+    [CMD_GET_STATE_HASH] = {dm_handle_get_state_hash, 0, 0},
+    [CMD_SHOW_PAGE] = {dm_handle_show_page, 1, 1},
+    [CMD_SET_TEXT] = {dm_handle_set_text, 2, ANY_LEN},
+    [CMD_SET_VALUE] = {dm_handle_set_value, 3, 3},
+    [CMD_SET_VISIBLE] = {dm_handle_set_visible, 2, 2},
+    [CMD_SET_ENABLED] = {dm_handle_set_enabled, 2, 2},
+    [CMD_SET_VALUES] = {dm_handle_set_values, 3, ANY_LEN},
+    [CMD_DEFINE_STRING] = {dm_handle_define_string, 1, ANY_LEN},
+    [CMD_SET_TEXT_ID] = {dm_handle_set_text_id, 2, 2},
+    [CMD_BATCH] = {dispatch_batch, 0, ANY_LEN},
+    [CMD_LAYOUT_WRITE] = {dm_handle_layout_write, 2, ANY_LEN},
+    [CMD_LAYOUT_APPLY] = {dm_handle_layout_apply, 2, 2},
+    [CMD_BULK_OPEN] = {dm_bulk_open, 8, 8},
+    [CMD_BULK_CHUNK] = {dm_bulk_chunk, DM_BULK_CHUNK_HDR + 1, ANY_LEN},
+    [CMD_BULK_COMMIT] = {dm_bulk_commit, 1, 1},
+    [CMD_BULK_ABORT] = {dm_bulk_abort, 1, 1},
+};
+
+bool dm_protocol_register(uint8_t cmd, dm_cmd_handler_t handler,
+                          uint16_t min_len, uint16_t max_len) {
+  uint8_t slot = s_registered_slot[cmd];
+  if (slot == 0) {
+    if (s_registered_count >= DM_PROTOCOL_MAX_HANDLERS)
+      return false;
+    slot = ++s_registered_count;
+    s_registered_slot[cmd] = slot;
+  }
+  s_registered[slot - 1] = (dm_cmd_entry_t){handler, min_len, max_len};
+  return true;
+}
+
+static void dispatch_command(uint8_t cmd, uint8_t seq, const uint8_t *p,
+                             uint16_t len, const dm_platform_t *plat) {
+  uint8_t slot = s_registered_slot[cmd];
+  const dm_cmd_entry_t *e =
+      slot ? &s_registered[slot - 1] : &s_cmd_table[cmd];
+
+  if (!e->handler) {
 #if DM_DEBUG_LOG
     if (plat && plat->log)
       plat->log("DM: unknown command – sending NACK");
 #endif
-    dm_packet_send_nack(frame->seq_id, plat);
-    break;
+    dm_packet_send_nack(seq, plat);
+    return;
+  }
+  if (len < e->min_len || len > e->max_len) {
+    dm_packet_send_nack(seq, plat);
+    return;
+  }
+  e->handler(seq, p, len, plat);
+}
+
+/* One top-level command, timed for CMD_GET_STATS. */
+static void dispatch_frame(const dm_frame_t *frame, const dm_platform_t *plat) {
+#if DM_STATS_TIMING
+  uint32_t t0 = dm_stats_now_us(plat);
+#endif
+  DM_TRACE_EVT(DM_TRACE_DISPATCH_BEGIN, frame->command, frame->seq_id);
+  dispatch_command(frame->command, frame->seq_id, frame->data,
+                   frame->payload_len, plat);
+  DM_TRACE_EVT(DM_TRACE_DISPATCH_END, frame->command, frame->seq_id);
+#if DM_STATS_TIMING
+  dm_timing_add(&s_pr->dispatch_timing, dm_stats_now_us(plat) - t0);
+#endif
+}
+
+void dm_protocol_dispatch(const dm_frame_t *frame, const dm_platform_t *plat) {
+  /* A host that talks v1 (e.g. one that restarted) gets v1 back. */
+  if (frame->version != DM_PROTOCOL_V2 &&
+      dm_packet_peer_version() != DM_PROTOCOL_V1)
+    dm_packet_set_peer(DM_PROTOCOL_V1, DM_MAX_PAYLOAD);
+
+  if (frame->address == DM_ADDR_BROADCAST) {
+    /*
+     * Every panel on the bus acts on a broadcast; answers would collide,
+     * so none are sent, and without answers there is no retransmit to
+     * recognise either.
+     */
+    dm_packet_set_muted(true);
+    dispatch_frame(frame, plat);
+    dm_packet_set_muted(false);
+    return;
+  }
+
+  dm_seq_entry_t *e = &s_pr->seq_window[frame->seq_id % DM_SEQ_WINDOW];
+
+  if (e->valid && e->seq == frame->seq_id && e->crc == frame->crc) {
+    /* Retransmit: answer again, do not act again. */
+    s_pr->dup_count++;
+    if (e->evt == EVT_ACK) {
+      dm_packet_send_ack(frame->seq_id, plat, e->data, e->len);
+    } else {
+      dm_packet_send_nack(frame->seq_id, plat);
+    }
+    return;
   }
+
+  e->valid = false;
+  e->seq = frame->seq_id;
+  e->crc = frame->crc;
+  s_pr->recording = e;
+  dispatch_frame(frame, plat);
+  s_pr->recording = NULL;
 }
 
 // Default (weak) handler implementations
 
 __attribute__((weak)) void dm_handle_ping(uint8_t seq, const uint8_t *p,
-                                          uint8_t len,
+                                          uint16_t len,
                                           const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -74,7 +414,7 @@ __attribute__((weak)) void dm_handle_ping(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_get_version(uint8_t seq, const uint8_t *p,
-                                                 uint8_t len,
+                                                 uint16_t len,
                                                  const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -83,7 +423,7 @@ __attribute__((weak)) void dm_handle_get_version(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_reset(uint8_t seq, const uint8_t *p,
-                                           uint8_t len,
+                                           uint16_t len,
                                            const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -92,7 +432,7 @@ __attribute__((weak)) void dm_handle_reset(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void
-dm_handle_enter_bootloader(uint8_t seq, const uint8_t *p, uint8_t len,
+dm_handle_enter_bootloader(uint8_t seq, const uint8_t *p, uint16_t len,
                            const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -100,7 +440,7 @@ dm_handle_enter_bootloader(uint8_t seq, const uint8_t *p, uint8_t len,
 }
 
 __attribute__((weak)) void dm_handle_show_page(uint8_t seq, const uint8_t *p,
-                                               uint8_t len,
+                                               uint16_t len,
                                                const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -108,7 +448,7 @@ __attribute__((weak)) void dm_handle_show_page(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_set_text(uint8_t seq, const uint8_t *p,
-                                              uint8_t len,
+                                              uint16_t len,
                                               const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -116,7 +456,7 @@ __attribute__((weak)) void dm_handle_set_text(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_set_value(uint8_t seq, const uint8_t *p,
-                                               uint8_t len,
+                                               uint16_t len,
                                                const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -124,7 +464,7 @@ __attribute__((weak)) void dm_handle_set_value(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_set_visible(uint8_t seq, const uint8_t *p,
-                                                 uint8_t len,
+                                                 uint16_t len,
                                                  const dm_platform_t *plat) {
   (void)p;
   (void)len;
@@ -132,9 +472,57 @@ __attribute__((weak)) void dm_handle_set_visible(uint8_t seq, const uint8_t *p,
 }
 
 __attribute__((weak)) void dm_handle_set_enabled(uint8_t seq, const uint8_t *p,
-                                                 uint8_t len,
+                                                 uint16_t len,
                                                  const dm_platform_t *plat) {
   (void)p;
   (void)len;
   dm_packet_send_nack(seq, plat);
 }
+
+__attribute__((weak)) void dm_handle_set_values(uint8_t seq, const uint8_t *p,
+                                                uint16_t len,
+                                                const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
+
+__attribute__((weak)) void
+dm_handle_define_string(uint8_t seq, const uint8_t *p, uint16_t len,
+                        const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
+
+__attribute__((weak)) void dm_handle_set_text_id(uint8_t seq, const uint8_t *p,
+                                                 uint16_t len,
+                                                 const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
+
+__attribute__((weak)) void
+dm_handle_get_state_hash(uint8_t seq, const uint8_t *p, uint16_t len,
+                         const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
+
+__attribute__((weak)) void dm_handle_layout_write(uint8_t seq, const uint8_t *p,
+                                                  uint16_t len,
+                                                  const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
+
+__attribute__((weak)) void dm_handle_layout_apply(uint8_t seq, const uint8_t *p,
+                                                  uint16_t len,
+                                                  const dm_platform_t *plat) {
+  (void)p;
+  (void)len;
+  dm_packet_send_nack(seq, plat);
+}
@@ -14,7 +14,9 @@
 
 #include "dm_parser.h"
 #include "dm_platform.h"
+#include "dm_stats.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,6 +29,11 @@ extern "C" {
 #define CMD_GET_VERSION 0x02
 #define CMD_RESET 0x03
 #define CMD_ENTER_BOOTLOADER 0x04
+#define CMD_SET_ACK_MODE 0x05
+#define CMD_GET_CAPS 0x06
+#define CMD_GET_STATS 0x07
+#define CMD_GET_TRACE 0x08
+#define CMD_GET_STATE_HASH 0x09
 
 /** Navigation */
 #define CMD_SHOW_PAGE 0x10
@@ -36,6 +43,22 @@ extern "C" {
 #define CMD_SET_VALUE 0x21
 #define CMD_SET_VISIBLE 0x22
 #define CMD_SET_ENABLED 0x23
+#define CMD_SET_VALUES 0x24
+#define CMD_DEFINE_STRING 0x25
+#define CMD_SET_TEXT_ID 0x26
+
+/** Batching */
+#define CMD_BATCH 0x30
+
+/** Layout upload */
+#define CMD_LAYOUT_WRITE 0x40
+#define CMD_LAYOUT_APPLY 0x41
+
+/** Bulk transfer (see dm_bulk.h) */
+#define CMD_BULK_OPEN 0x50
+#define CMD_BULK_CHUNK 0x51
+#define CMD_BULK_COMMIT 0x52
+#define CMD_BULK_ABORT 0x53
 
 // Event IDs (Device → Host)
 
@@ -46,18 +69,95 @@ extern "C" {
 
 #define EVT_ACK 0xF0
 #define EVT_NACK 0xF1
+#define EVT_ACK_RANGE 0xF2
+
+/** CMD_SET_ACK_MODE modes */
+#define DM_ACK_MODE_EACH 0       /**< One EVT_ACK per command (default) */
+#define DM_ACK_MODE_CUMULATIVE 1 /**< Runs of plain ACKs → one EVT_ACK_RANGE */
+
+/** CMD_GET_STATE_HASH flags */
+#define DM_STATE_RESTORED 0x01 /**< Screen restored from flash at boot */
+#define DM_STATE_SAVED 0x02    /**< Flash holds the current state */
+
+/** CMD_SET_VALUES encodings */
+#define DM_VALUES_ABSOLUTE 0 /**< [value:i16 BE]… */
+#define DM_VALUES_DELTA 1    /**< [delta:i8]… added to the current value */
+
+/** CMD_GET_CAPS feature bits */
+#define DM_FEAT_BATCH 0x0001      /**< CMD_BATCH */
+#define DM_FEAT_SEQ_WINDOW 0x0002 /**< Retransmit replay + cumulative ACKs */
+#define DM_FEAT_BULK 0x0004       /**< CMD_BULK_* */
+#define DM_FEAT_LAYOUT 0x0008     /**< CMD_LAYOUT_* */
+#define DM_FEAT_TRACE 0x0010      /**< CMD_GET_TRACE (DM_TRACE_DEPTH > 0) */
+#define DM_FEAT_SET_VALUES 0x0020 /**< CMD_SET_VALUES */
+#define DM_FEAT_STRINGS 0x0040    /**< CMD_DEFINE_STRING / CMD_SET_TEXT_ID */
+#define DM_FEAT_STATE_HASH 0x0080 /**< CMD_GET_STATE_HASH */
 
 // Dispatcher
 
+/** One remembered command of the seq window (see dm_protocol.c). */
+typedef struct {
+  bool valid;
+  uint8_t seq;
+  uint16_t crc;
+  uint8_t evt; /**< EVT_ACK or EVT_NACK */
+  uint8_t len;
+  uint8_t data[DM_SEQ_CACHE_DATA];
+} dm_seq_entry_t;
+
+/**
+ * @brief Dispatcher state of one link (held in its dm_ctx_t).
+ *
+ * Private to dm_protocol.c; public only so contexts can be allocated
+ * statically.  Registered handlers are shared by all links.
+ */
+typedef struct {
+  dm_seq_entry_t seq_window[DM_SEQ_WINDOW];
+  dm_seq_entry_t *recording; /**< Slot of the frame in dispatch */
+  uint32_t dup_count;
+  dm_timing_t dispatch_timing;
+} dm_protocol_state_t;
+
 /**
- * @brief Initialise the protocol dispatcher (clears seq-id tracking).
+ * @brief Direct all following dispatches at @p state.
+ * @param state  Dispatcher state of the link being served.
+ */
+void dm_protocol_bind(dm_protocol_state_t *state);
+
+/**
+ * @brief Reset the bound dispatcher state (clears seq-id tracking).
  */
 void dm_protocol_init(void);
 
+/**
+ * @brief Remove every dm_protocol_register() installation.
+ */
+void dm_protocol_unregister_all(void);
+
+/**
+ * @brief Record the response sent for the command being dispatched.
+ *
+ * Called by dm_packet_send_ack / dm_packet_send_nack so a retransmitted
+ * command (same SEQ_ID and CRC) can be answered again from the seq window
+ * without running its handler twice.  Ignored outside of dispatch.
+ */
+void dm_protocol_note_response(uint8_t seq, uint8_t evt, const uint8_t *payload,
+                               uint16_t len);
+
+/** @brief Number of retransmitted commands answered from the seq window. */
+uint32_t dm_protocol_dup_count(void);
+
+/** @brief Handler run times since the last dm_protocol_clear_timing(). */
+const dm_timing_t *dm_protocol_dispatch_timing(void);
+
+/** @brief Start a new dispatch timing window. */
+void dm_protocol_clear_timing(void);
+
 /**
  * @brief Route a validated frame to the appropriate command handler.
  *
- * Called automatically by dm_parser_feed on a valid frame.
+ * Called automatically by dm_parser_feed on a valid frame.  The payload is
+ * read through frame->data.
  * Unknown commands receive an automatic NACK.
  *
  * @param frame  Validated frame.
@@ -65,30 +165,75 @@ void dm_protocol_init(void);
  */
 void dm_protocol_dispatch(const dm_frame_t *frame, const dm_platform_t *plat);
 
+/** Command handler: @p len is already within the entry's limits. */
+typedef void (*dm_cmd_handler_t)(uint8_t seq, const uint8_t *p, uint16_t len,
+                                 const dm_platform_t *plat);
+
+/** Dispatch table entry. */
+typedef struct {
+  dm_cmd_handler_t handler; /**< NULL = unknown command (NACK) */
+  uint16_t min_len;         /**< Payloads outside [min_len, max_len] */
+  uint16_t max_len;         /**< are NACKed without calling the handler */
+} dm_cmd_entry_t;
+
+/**
+ * @brief Install a handler for @p cmd at runtime.
+ *
+ * Takes precedence over the built-in entry (and over CMD_BATCH
+ * sub-commands with that ID).  Registering the same command again
+ * replaces the handler; a NULL handler makes the command unknown.
+ * dm_init() clears all registrations, so register after it.
+ *
+ * @param cmd      Command ID.
+ * @param handler  Handler function.
+ * @param min_len  Shortest accepted payload.
+ * @param max_len  Longest accepted payload.
+ * @return false if DM_PROTOCOL_MAX_HANDLERS commands are already registered.
+ */
+bool dm_protocol_register(uint8_t cmd, dm_cmd_handler_t handler,
+                          uint16_t min_len, uint16_t max_len);
+
 /* ── Weak handler stubs (override in app/dm_binder.c) ───────────────────── */
 
 /**
- * Each handler receives the raw payload and its length.
+ * Each handler receives the raw payload and its length, already checked
+ * against the dispatch table limits (docs/protocol_spec.md §2).
  * The binder layer overrides these weak symbols.
+ *
+ * @p p usually points straight into the receive buffer (see
+ * dm_frame_t::data) and is only valid until the handler returns:
+ * copy anything that must outlive the call.
  */
-void dm_handle_ping(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_ping(uint8_t seq, const uint8_t *p, uint16_t len,
                     const dm_platform_t *plat);
-void dm_handle_get_version(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_get_version(uint8_t seq, const uint8_t *p, uint16_t len,
                            const dm_platform_t *plat);
-void dm_handle_reset(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_reset(uint8_t seq, const uint8_t *p, uint16_t len,
                      const dm_platform_t *plat);
-void dm_handle_enter_bootloader(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_enter_bootloader(uint8_t seq, const uint8_t *p, uint16_t len,
                                 const dm_platform_t *plat);
-void dm_handle_show_page(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_show_page(uint8_t seq, const uint8_t *p, uint16_t len,
                          const dm_platform_t *plat);
-void dm_handle_set_text(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_set_text(uint8_t seq, const uint8_t *p, uint16_t len,
                         const dm_platform_t *plat);
-void dm_handle_set_value(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_set_value(uint8_t seq, const uint8_t *p, uint16_t len,
                          const dm_platform_t *plat);
-void dm_handle_set_visible(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_set_visible(uint8_t seq, const uint8_t *p, uint16_t len,
+                           const dm_platform_t *plat);
+void dm_handle_set_enabled(uint8_t seq, const uint8_t *p, uint16_t len,
                            const dm_platform_t *plat);
-void dm_handle_set_enabled(uint8_t seq, const uint8_t *p, uint8_t len,
+void dm_handle_set_values(uint8_t seq, const uint8_t *p, uint16_t len,
+                          const dm_platform_t *plat);
+void dm_handle_define_string(uint8_t seq, const uint8_t *p, uint16_t len,
+                             const dm_platform_t *plat);
+void dm_handle_set_text_id(uint8_t seq, const uint8_t *p, uint16_t len,
                            const dm_platform_t *plat);
+void dm_handle_get_state_hash(uint8_t seq, const uint8_t *p, uint16_t len,
+                              const dm_platform_t *plat);
+void dm_handle_layout_write(uint8_t seq, const uint8_t *p, uint16_t len,
+                            const dm_platform_t *plat);
+void dm_handle_layout_apply(uint8_t seq, const uint8_t *p, uint16_t len,
+                            const dm_platform_t *plat);
 
 #ifdef __cplusplus
 }
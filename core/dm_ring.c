@@ -0,0 +1,71 @@
+/**
+ * @file dm_ring.c
+ * @brief SPSC ring buffer implementation.
+ *
+ * The producer owns head, the consumer owns tail.  Each side reads the
+ * other's counter with acquire semantics and publishes its own with
+ * release semantics, so data stores are visible before the index moves.
+ */
+#include "dm_ring.h"
+
+#include <string.h>
+
+#define RING_MASK (DM_RX_RING_SIZE - 1U)
+
+#define LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+void dm_ring_init(dm_ring_t *r)
+{
+    r->head      = 0;
+    r->tail      = 0;
+    r->overflows = 0;
+    r->peak      = 0;
+}
+
+size_t dm_ring_write(dm_ring_t *r, const uint8_t *data, size_t n)
+{
+    uint32_t head = r->head;
+    uint32_t tail = LOAD_ACQUIRE(&r->tail);
+    size_t   room = DM_RX_RING_SIZE - (size_t)(head - tail);
+
+    if (n > room) {
+        r->overflows += (uint32_t)(n - room);
+        n = room;
+    }
+
+    /* Copy in at most two segments (up to the end, then from the start). */
+    size_t idx   = head & RING_MASK;
+    size_t first = DM_RX_RING_SIZE - idx;
+    if (first > n) first = n;
+    memcpy(&r->buf[idx], data, first);
+    memcpy(&r->buf[0], data + first, n - first);
+
+    STORE_RELEASE(&r->head, head + (uint32_t)n);
+
+    uint32_t used = head + (uint32_t)n - tail;
+    if (used > r->peak) r->peak = used;
+    return n;
+}
+
+size_t dm_ring_peek(dm_ring_t *r, const uint8_t **ptr)
+{
+    uint32_t tail  = r->tail;
+    uint32_t head  = LOAD_ACQUIRE(&r->head);
+    size_t   avail = (size_t)(head - tail);
+    size_t   idx   = tail & RING_MASK;
+
+    if (avail > DM_RX_RING_SIZE - idx) avail = DM_RX_RING_SIZE - idx;
+    *ptr = &r->buf[idx];
+    return avail;
+}
+
+void dm_ring_consume(dm_ring_t *r, size_t n)
+{
+    STORE_RELEASE(&r->tail, r->tail + (uint32_t)n);
+}
+
+size_t dm_ring_count(const dm_ring_t *r)
+{
+    return (size_t)(LOAD_ACQUIRE(&r->head) - LOAD_ACQUIRE(&r->tail));
+}
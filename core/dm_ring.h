@@ -0,0 +1,84 @@
+/**
+ * @file dm_ring.h
+ * @brief Lock-free single-producer / single-consumer byte ring buffer.
+ *
+ * Sits between the UART RX interrupt (or a circular-DMA callback) and
+ * dm_process().  Exactly one context may write and exactly one may read;
+ * no locks or interrupt masking are needed.
+ *
+ * head and tail are free-running counters; the buffer index is the
+ * counter masked with (DM_RX_RING_SIZE - 1), so the size must be a power
+ * of two.  Both counters are published with acquire/release ordering so
+ * the ring is also safe between the two cores of an RP2040 / ESP32-S3.
+ */
+#ifndef DM_RING_H
+#define DM_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "dm_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (DM_RX_RING_SIZE & (DM_RX_RING_SIZE - 1)) != 0
+#error "DM_RX_RING_SIZE must be a power of two"
+#endif
+
+/** Ring buffer instance. */
+typedef struct {
+    volatile uint32_t head;      /**< Written by the producer only */
+    volatile uint32_t tail;      /**< Written by the consumer only */
+    uint32_t          overflows; /**< Bytes dropped because the ring was full */
+    uint32_t          peak;      /**< Most bytes ever stored at once (high-water mark) */
+    uint8_t           buf[DM_RX_RING_SIZE];
+} dm_ring_t;
+
+/**
+ * @brief Reset a ring to empty.
+ * @param r  Ring instance.
+ */
+void dm_ring_init(dm_ring_t *r);
+
+/**
+ * @brief Producer: copy bytes into the ring.
+ *
+ * Safe to call from an ISR.  Bytes that do not fit are dropped and
+ * counted in r->overflows.
+ *
+ * @param r     Ring instance.
+ * @param data  Bytes to store.
+ * @param n     Number of bytes.
+ * @return      Number of bytes actually stored.
+ */
+size_t dm_ring_write(dm_ring_t *r, const uint8_t *data, size_t n);
+
+/**
+ * @brief Consumer: get the largest contiguous readable span.
+ *
+ * @param r    Ring instance.
+ * @param ptr  Receives a pointer to the first readable byte.
+ * @return     Number of contiguous bytes readable at *ptr (0 = empty).
+ */
+size_t dm_ring_peek(dm_ring_t *r, const uint8_t **ptr);
+
+/**
+ * @brief Consumer: release @p n bytes previously returned by dm_ring_peek().
+ * @param r  Ring instance.
+ * @param n  Number of bytes consumed.
+ */
+void dm_ring_consume(dm_ring_t *r, size_t n);
+
+/**
+ * @brief Number of bytes currently stored (either side may call).
+ * @param r  Ring instance.
+ */
+size_t dm_ring_count(const dm_ring_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_RING_H */
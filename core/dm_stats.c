@@ -0,0 +1,35 @@
+/**
+ * @file dm_stats.c
+ * @brief Timing helpers for the statistics snapshot (see dm_stats.h).
+ */
+#include "dm_stats.h"
+
+#include <stddef.h>
+
+uint32_t dm_stats_now_us(const dm_platform_t *plat)
+{
+    if (!plat) return 0;
+    if (plat->micros) return plat->micros();
+    return plat->millis ? plat->millis() * 1000U : 0;
+}
+
+void dm_timing_clear(dm_timing_t *t)
+{
+    t->count    = 0;
+    t->min_us   = 0;
+    t->max_us   = 0;
+    t->total_us = 0;
+}
+
+void dm_timing_add(dm_timing_t *t, uint32_t us)
+{
+    if (t->count == 0 || us < t->min_us) t->min_us = us;
+    if (us > t->max_us) t->max_us = us;
+    t->total_us += us;
+    t->count++;
+}
+
+uint32_t dm_timing_avg(const dm_timing_t *t)
+{
+    return t->count ? (uint32_t)(t->total_us / t->count) : 0;
+}
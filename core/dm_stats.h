@@ -0,0 +1,91 @@
+/**
+ * @file dm_stats.h
+ * @brief Link and latency statistics reported by CMD_GET_STATS.
+ *
+ * Counters are plain increments kept by the modules that own the events
+ * (parser, RX ring, TX queue, packet encoder, dispatcher), so they cost
+ * next to nothing and stay on in production.  dm_get_stats() gathers a
+ * snapshot.  Cumulative counters only ever grow (and wrap); the host
+ * works with deltas between reads.  Peaks and timings cover the window
+ * since they were last cleared.
+ */
+#ifndef DM_STATS_H
+#define DM_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm_config.h"
+#include "dm_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Summary of a series of durations. */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} dm_timing_t;
+
+/** Snapshot returned by dm_get_stats(); CMD_GET_STATS sends it in this order. */
+typedef struct {
+    /* Receive */
+    uint32_t rx_bytes;          /**< Bytes handed to the parser */
+    uint32_t frames_ok;
+    uint32_t frames_crc_err;
+    uint32_t frames_len_err;
+    uint32_t frames_timeout;
+    uint32_t frames_skipped;    /**< Addressed to other panels */
+    uint32_t rx_overflows;      /**< Bytes lost to a full RX ring */
+    uint32_t rx_ring_peak;      /**< RX ring high-water mark (bytes) */
+
+    /* Transmit */
+    uint32_t tx_bytes;
+    uint32_t tx_dropped;        /**< Frames lost to a full TX queue */
+    uint32_t tx_queue_peak;     /**< TX fill-buffer high-water mark (bytes) */
+    uint32_t nacks;             /**< EVT_NACKs sent */
+    uint32_t duplicates;        /**< Retransmits answered from the seq window */
+
+    /* Latency (µs) */
+    dm_timing_t dispatch;       /**< Command handler run time */
+    dm_timing_t render;         /**< lv_timer_handler() run time (dm_render_time()) */
+} dm_stats_t;
+
+/** Fields in the CMD_GET_STATS reply, each u32 BE (timings: count, min, avg, max). */
+#define DM_STATS_WIRE_FIELDS 21
+
+/** CMD_GET_STATS request flag: clear peaks and timings after replying. */
+#define DM_STATS_FLAG_CLEAR 0x01
+
+/**
+ * @brief Current time in µs: plat->micros, else plat->millis × 1000.
+ * @param plat  Platform interface (may be NULL → 0).
+ */
+uint32_t dm_stats_now_us(const dm_platform_t *plat);
+
+/**
+ * @brief Reset @p t to an empty series.
+ * @param t  Timing instance.
+ */
+void dm_timing_clear(dm_timing_t *t);
+
+/**
+ * @brief Add one duration to @p t.
+ * @param t   Timing instance.
+ * @param us  Duration in microseconds.
+ */
+void dm_timing_add(dm_timing_t *t, uint32_t us);
+
+/**
+ * @brief Mean duration (0 for an empty series).
+ * @param t  Timing instance.
+ */
+uint32_t dm_timing_avg(const dm_timing_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_STATS_H */
@@ -0,0 +1,88 @@
+/**
+ * @file dm_trace.c
+ * @brief Trace ring implementation (see dm_trace.h).
+ */
+#include "dm_trace.h"
+
+#if DM_TRACE_DEPTH > 0
+
+#include "dm_stats.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRACE_MASK (DM_TRACE_DEPTH - 1U)
+
+static dm_trace_entry_t      s_ring[DM_TRACE_DEPTH];
+static uint32_t              s_head = 0;      /* Number of the next entry */
+static const dm_platform_t  *s_plat = NULL;
+
+/* TX_END stamped in interrupt context, waiting to enter the ring */
+static volatile uint32_t     s_isr_t_us;
+static volatile uint8_t      s_isr_pending = 0;
+
+static void put(uint32_t t_us, uint8_t event, uint8_t arg, uint16_t value)
+{
+    dm_trace_entry_t *e = &s_ring[s_head & TRACE_MASK];
+    e->t_us  = t_us;
+    e->event = event;
+    e->arg   = arg;
+    e->value = value;
+    s_head++;
+}
+
+/* Move a pending ISR event in first: it happened before anything now. */
+static void drain_isr(void)
+{
+    if (!__atomic_load_n(&s_isr_pending, __ATOMIC_ACQUIRE)) return;
+    uint32_t t = s_isr_t_us;
+    __atomic_store_n(&s_isr_pending, 0, __ATOMIC_RELEASE);
+    put(t, DM_TRACE_TX_END, 0, 0);
+}
+
+void dm_trace_init(const dm_platform_t *plat)
+{
+    s_plat        = plat;
+    s_head        = 0;
+    s_isr_pending = 0;
+}
+
+void dm_trace(uint8_t event, uint8_t arg, uint16_t value)
+{
+    dm_trace_at(dm_stats_now_us(s_plat), event, arg, value);
+}
+
+void dm_trace_at(uint32_t t_us, uint8_t event, uint8_t arg, uint16_t value)
+{
+    drain_isr();
+    put(t_us, event, arg, value);
+}
+
+void dm_trace_tx_end_isr(void)
+{
+    s_isr_t_us = dm_stats_now_us(s_plat);
+    __atomic_store_n(&s_isr_pending, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t dm_trace_read(uint32_t from, dm_trace_entry_t *out, uint32_t max,
+                       uint32_t *first)
+{
+    drain_isr();
+    uint32_t oldest = s_head - (s_head < DM_TRACE_DEPTH ? s_head : DM_TRACE_DEPTH);
+    if ((int32_t)(from - oldest) < 0) from = oldest;   /* overwritten */
+    if ((int32_t)(s_head - from) < 0) from = s_head;   /* from the future */
+
+    uint32_t n = s_head - from;
+    if (n > max) n = max;
+    for (uint32_t i = 0; i < n; i++) out[i] = s_ring[(from + i) & TRACE_MASK];
+    *first = from;
+    return n;
+}
+
+uint32_t dm_trace_head(void)
+{
+    drain_isr();
+    return s_head;
+}
+
+#endif /* DM_TRACE_DEPTH > 0 */
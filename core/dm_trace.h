@@ -0,0 +1,108 @@
+/**
+ * @file dm_trace.h
+ * @brief Hot-path trace ring: timestamped binary events for latency analysis.
+ *
+ * With DM_TRACE_DEPTH > 0 the parser, dispatcher, TX path and render hook
+ * record fixed-size events into a ring of the last DM_TRACE_DEPTH entries:
+ *
+ *   FRAME_RX → DISPATCH_BEGIN → DISPATCH_END → TX_START → TX_END
+ *
+ * gives the device-side breakdown of every command, and RENDER_BEGIN/END
+ * brackets each lv_timer_handler() pass.  Timestamps come from
+ * plat->micros (millis() × 1000 without it).  The host reads the ring with
+ * CMD_GET_TRACE; the simulator prints it on exit.
+ *
+ * With DM_TRACE_DEPTH == 0 (default) every DM_TRACE_* macro expands to
+ * nothing and the module compiles to no code.
+ *
+ * Recording happens in the main loop only.  The one event produced in
+ * interrupt context (TX_END of a DMA transfer) is stamped by
+ * dm_trace_tx_end_isr() and moved into the ring by the next record.
+ */
+#ifndef DM_TRACE_H
+#define DM_TRACE_H
+
+#include <stdint.h>
+#include "dm_config.h"
+#include "dm_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Event types (arg / value meaning in brackets). */
+#define DM_TRACE_FRAME_RX       0x01 /**< Valid frame parsed [cmd / payload_len] */
+#define DM_TRACE_DISPATCH_BEGIN 0x02 /**< Handler starts [cmd / seq] */
+#define DM_TRACE_DISPATCH_END   0x03 /**< Handler returned [cmd / seq] */
+#define DM_TRACE_TX_START       0x04 /**< Bytes handed to the UART [0 / len] */
+#define DM_TRACE_TX_END         0x05 /**< Transmit finished [0 / 0] */
+#define DM_TRACE_RENDER_BEGIN   0x06 /**< lv_timer_handler() starts [0 / 0] */
+#define DM_TRACE_RENDER_END     0x07 /**< lv_timer_handler() returned [0 / 0] */
+
+/** One trace record (8 bytes on the wire: t_us:u32 event:u8 arg:u8 value:u16, BE). */
+typedef struct {
+    uint32_t t_us;
+    uint8_t  event;
+    uint8_t  arg;
+    uint16_t value;
+} dm_trace_entry_t;
+
+/** Bytes per entry in the CMD_GET_TRACE reply. */
+#define DM_TRACE_WIRE_SIZE 8
+
+#if DM_TRACE_DEPTH > 0
+
+#if (DM_TRACE_DEPTH & (DM_TRACE_DEPTH - 1)) != 0
+#error "DM_TRACE_DEPTH must be a power of two"
+#endif
+
+/**
+ * @brief Empty the ring and select the clock.
+ * @param plat  Platform interface (micros / millis).
+ */
+void dm_trace_init(const dm_platform_t *plat);
+
+/** @brief Record @p event now. */
+void dm_trace(uint8_t event, uint8_t arg, uint16_t value);
+
+/** @brief Record @p event with an earlier timestamp @p t_us. */
+void dm_trace_at(uint32_t t_us, uint8_t event, uint8_t arg, uint16_t value);
+
+/** @brief Stamp the end of an async transmit (ISR-safe; see file comment). */
+void dm_trace_tx_end_isr(void);
+
+/**
+ * @brief Copy recorded entries out of the ring.
+ *
+ * Entries are numbered from 0 since dm_trace_init() (the number wraps at
+ * 2^32).  Those older than the last DM_TRACE_DEPTH are gone.
+ *
+ * @param from   Number of the first entry wanted.
+ * @param out    Destination array.
+ * @param max    Capacity of @p out.
+ * @param first  Receives the number of out[0] (≥ @p from if entries were lost).
+ * @return       Entries copied.
+ */
+uint32_t dm_trace_read(uint32_t from, dm_trace_entry_t *out, uint32_t max,
+                       uint32_t *first);
+
+/** @brief Number the next recorded entry will get. */
+uint32_t dm_trace_head(void);
+
+#define DM_TRACE_EVT(event, arg, value) \
+    dm_trace((event), (uint8_t)(arg), (uint16_t)(value))
+#define DM_TRACE_EVT_AT(t_us, event, arg, value) \
+    dm_trace_at((t_us), (event), (uint8_t)(arg), (uint16_t)(value))
+
+#else
+
+#define DM_TRACE_EVT(event, arg, value)          ((void)0)
+#define DM_TRACE_EVT_AT(t_us, event, arg, value) ((void)0)
+
+#endif /* DM_TRACE_DEPTH > 0 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_TRACE_H */
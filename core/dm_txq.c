@@ -0,0 +1,85 @@
+/**
+ * @file dm_txq.c
+ * @brief Double-buffered transmit queue implementation.
+ */
+#include "dm_txq.h"
+#include "dm_trace.h"
+
+#include <string.h>
+
+void dm_txq_init(dm_txq_t *q)
+{
+    q->fill_len = 0;
+    q->fill_idx = 0;
+    q->busy     = 0;
+    q->dropped  = 0;
+    q->bytes    = 0;
+    q->peak     = 0;
+}
+
+void dm_txq_poll(dm_txq_t *q, const dm_platform_t *plat)
+{
+    if (__atomic_load_n(&q->busy, __ATOMIC_ACQUIRE) || q->fill_len == 0) return;
+
+    const uint8_t *data = q->buf[q->fill_idx];
+    uint16_t       len  = q->fill_len;
+
+    /* Swap before starting: the ISR may complete inside write_async(). */
+    q->fill_idx ^= 1U;
+    q->fill_len  = 0;
+    q->bytes    += len;
+    __atomic_store_n(&q->busy, 1, __ATOMIC_RELEASE);
+
+    /* Released again by dm_tx_complete(). */
+    if (plat->bus_tx_enable) plat->bus_tx_enable(true);
+    DM_TRACE_EVT(DM_TRACE_TX_START, 0, len);
+    plat->write_async(data, len);
+}
+
+uint8_t *dm_txq_reserve(dm_txq_t *q, uint16_t len, const dm_platform_t *plat)
+{
+    /* Synchronous TX: the fill buffer is only scratch space. */
+    if (!plat->write_async) return q->buf[q->fill_idx];
+
+    if ((uint32_t)q->fill_len + len > DM_TX_QUEUE_SIZE) {
+        /* Fill buffer is full – maybe the transmitter has just gone idle. */
+        dm_txq_poll(q, plat);
+        if ((uint32_t)q->fill_len + len > DM_TX_QUEUE_SIZE) {
+            q->dropped++;
+            return NULL;
+        }
+    }
+    return &q->buf[q->fill_idx][q->fill_len];
+}
+
+void dm_txq_commit(dm_txq_t *q, uint16_t len, const dm_platform_t *plat)
+{
+    if (!plat->write_async) {
+        q->bytes += len;
+        if (len > q->peak) q->peak = len;
+        if (plat->bus_tx_enable) plat->bus_tx_enable(true);
+        DM_TRACE_EVT(DM_TRACE_TX_START, 0, len);
+        plat->write_bytes(q->buf[q->fill_idx], len);
+        DM_TRACE_EVT(DM_TRACE_TX_END, 0, 0);
+        if (plat->bus_tx_enable) plat->bus_tx_enable(false);
+        return;
+    }
+    q->fill_len += len;
+    if (q->fill_len > q->peak) q->peak = q->fill_len;
+    dm_txq_poll(q, plat);
+}
+
+bool dm_txq_write(dm_txq_t *q, const uint8_t *data, uint16_t len,
+                  const dm_platform_t *plat)
+{
+    uint8_t *dst = dm_txq_reserve(q, len, plat);
+    if (!dst) return false;
+    memcpy(dst, data, len);
+    dm_txq_commit(q, len, plat);
+    return true;
+}
+
+void dm_txq_complete(dm_txq_t *q)
+{
+    __atomic_store_n(&q->busy, 0, __ATOMIC_RELEASE);
+}
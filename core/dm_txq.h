@@ -0,0 +1,106 @@
+/**
+ * @file dm_txq.h
+ * @brief Double-buffered transmit queue for asynchronous (DMA) TX.
+ *
+ * Outgoing frames are appended to the "fill" buffer.  Whenever the
+ * transmitter is idle, the whole fill buffer is handed to
+ * plat->write_async() in one transfer and the buffers swap, so frames
+ * queued while a transfer is in flight are coalesced into the next one.
+ *
+ * Frames can be built in place: dm_txq_reserve() hands out room at the
+ * end of the fill buffer and dm_txq_commit() queues it, so the encoder
+ * needs no staging buffer of its own.
+ *
+ * Buffer management happens only in the main-loop context; the TX-done
+ * ISR merely clears the busy flag (dm_txq_complete).
+ */
+#ifndef DM_TXQ_H
+#define DM_TXQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm_config.h"
+#include "dm_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DM_TX_QUEUE_SIZE < DM_MAX_FRAME_SIZE
+#error "DM_TX_QUEUE_SIZE must hold at least one DM_MAX_FRAME_SIZE frame"
+#endif
+
+/** TX queue instance. */
+typedef struct {
+    uint8_t          buf[2][DM_TX_QUEUE_SIZE];
+    uint16_t         fill_len;   /**< Bytes queued in buf[fill_idx] */
+    uint8_t          fill_idx;   /**< Buffer currently being appended to */
+    volatile uint8_t busy;       /**< Transfer in flight (cleared by ISR) */
+    uint32_t         dropped;    /**< Frames dropped because the queue was full */
+    uint32_t         bytes;      /**< Bytes handed to the transmitter */
+    uint16_t         peak;       /**< Most bytes ever waiting in the fill buffer */
+} dm_txq_t;
+
+/**
+ * @brief Reset a queue to empty / idle.
+ * @param q  Queue instance.
+ */
+void dm_txq_init(dm_txq_t *q);
+
+/**
+ * @brief Queue bytes for transmission and start a transfer if idle.
+ *
+ * Without plat->write_async the bytes are sent synchronously through
+ * plat->write_bytes.  Otherwise a buffer that does not fit whole is
+ * dropped (never split) and counted in q->dropped.
+ *
+ * @param q     Queue instance.
+ * @param data  Bytes to send (typically one complete frame).
+ * @param len   Number of bytes.
+ * @param plat  Platform interface.
+ * @return      true if the bytes were sent or queued.
+ */
+bool dm_txq_write(dm_txq_t *q, const uint8_t *data, uint16_t len,
+                  const dm_platform_t *plat);
+
+/**
+ * @brief Reserve room for @p len bytes to be written in place.
+ *
+ * Nothing else may touch the queue until the matching dm_txq_commit().
+ * Without plat->write_async the room is a scratch area that commit
+ * passes to plat->write_bytes.
+ *
+ * @param q     Queue instance.
+ * @param len   Bytes needed (at most DM_TX_QUEUE_SIZE).
+ * @param plat  Platform interface.
+ * @return      Where to write, or NULL if the queue is full (counted in
+ *              q->dropped).
+ */
+uint8_t *dm_txq_reserve(dm_txq_t *q, uint16_t len, const dm_platform_t *plat);
+
+/**
+ * @brief Queue the @p len bytes written after dm_txq_reserve().
+ *
+ * @param q     Queue instance.
+ * @param len   Bytes written (at most the reserved length).
+ * @param plat  Platform interface.
+ */
+void dm_txq_commit(dm_txq_t *q, uint16_t len, const dm_platform_t *plat);
+
+/**
+ * @brief Start the next transfer if the transmitter is idle.
+ *
+ * Call from the main loop (dm_process does this).
+ */
+void dm_txq_poll(dm_txq_t *q, const dm_platform_t *plat);
+
+/**
+ * @brief Mark the in-flight transfer as finished.  ISR-safe.
+ */
+void dm_txq_complete(dm_txq_t *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DM_TXQ_H */
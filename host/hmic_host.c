@@ -0,0 +1,736 @@
+/**
+ * @file hmic_host.c
+ * @brief Host-side client library (see hmic_host.h).
+ *
+ * The encoder is dm_packet bound to the client's own dm_packet_state_t,
+ * with a dm_platform_t whose write_async hands each dm_txq transfer to a
+ * non-blocking write() loop.  The platform callbacks carry no context, so
+ * like dm_packet itself they work on the client last bound by an API call
+ * (s_cur).
+ *
+ * Unlike dm_parser the decoder does not rescan a bad frame's bytes: a
+ * reply lost that way only costs a retransmit.
+ */
+#define _DEFAULT_SOURCE
+
+#include "hmic_host.h"
+#include "crc16.h"
+#include "dm_protocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* ── Clock ───────────────────────────────────────────────────────────────── */
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static uint32_t host_millis(void)
+{
+    return (uint32_t)(now_us() / 1000ULL);
+}
+
+static uint32_t host_micros(void)
+{
+    return (uint32_t)now_us();
+}
+
+/* ── Latency histogram ───────────────────────────────────────────────────── */
+
+static unsigned hist_bucket(uint32_t us)
+{
+    if (us == 0) us = 1;
+    unsigned octave = 31u - (unsigned)__builtin_clz(us);
+    unsigned sub    = (unsigned)(((uint64_t)us * HMIC_HIST_SUB) >> octave) & (HMIC_HIST_SUB - 1);
+    return octave * HMIC_HIST_SUB + sub;
+}
+
+/* Upper edge of bucket @p b, in µs. */
+static double hist_edge(unsigned b)
+{
+    unsigned octave = b / HMIC_HIST_SUB;
+    unsigned sub    = b % HMIC_HIST_SUB;
+    return (double)(1ULL << octave) * (1.0 + (double)(sub + 1) / HMIC_HIST_SUB);
+}
+
+void hmic_hist_add(hmic_hist_t *h, uint32_t us)
+{
+    if (h->count == 0 || us < h->min_us) h->min_us = us;
+    if (us > h->max_us) h->max_us = us;
+    h->count++;
+    h->sum_us += us;
+    h->bucket[hist_bucket(us)]++;
+}
+
+uint32_t hmic_hist_percentile(const hmic_hist_t *h, double q)
+{
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(q * h->count + 0.999999);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < HMIC_HIST_BUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen >= rank) {
+            double edge = hist_edge(b);
+            return edge < h->max_us ? (uint32_t)edge : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+/* ── Frame decoder ───────────────────────────────────────────────────────── */
+
+enum {
+    DEC_START,
+    DEC_VERSION,
+    DEC_ADDRESS,
+    DEC_COMMAND,
+    DEC_SEQ,
+    DEC_LEN_HIGH,
+    DEC_LEN,
+    DEC_PAYLOAD,
+    DEC_CRC_HIGH,
+    DEC_CRC_LOW,
+};
+
+void hmic_decoder_init(hmic_decoder_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->state = DEC_START;
+}
+
+/* Header byte: folded into the CRC. */
+static void dec_header(hmic_decoder_t *d, uint8_t b, uint8_t next)
+{
+    d->crc   = crc16_update(d->crc, b);
+    d->state = next;
+}
+
+static void dec_length_done(hmic_decoder_t *d)
+{
+    if (d->frame.len > DM_MAX_PAYLOAD) {
+        d->frames_bad++;
+        d->state = DEC_START;
+        return;
+    }
+    d->index = 0;
+    d->state = d->frame.len ? DEC_PAYLOAD : DEC_CRC_HIGH;
+}
+
+void hmic_decoder_feed(hmic_decoder_t *d, const uint8_t *buf, size_t n,
+                       hmic_frame_cb_t cb, void *ctx)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = buf[i];
+
+        switch (d->state) {
+        case DEC_START:
+            if (b == DM_START_BYTE) {
+                d->crc   = 0xFFFFU;
+                d->state = DEC_VERSION;
+            }
+            break;
+        case DEC_VERSION: {
+            uint8_t v = (uint8_t)(b & ~DM_VERSION_ADDR_FLAG);
+            if (v != DM_PROTOCOL_V1 && v != DM_PROTOCOL_V2) {
+                d->state = (b == DM_START_BYTE) ? DEC_VERSION : DEC_START;
+                break;
+            }
+            d->frame.version = v;
+            d->frame.address = DM_ADDR_NONE;
+            dec_header(d, b, (b & DM_VERSION_ADDR_FLAG) ? DEC_ADDRESS : DEC_COMMAND);
+            break;
+        }
+        case DEC_ADDRESS:
+            d->frame.address = b;
+            dec_header(d, b, DEC_COMMAND);
+            break;
+        case DEC_COMMAND:
+            d->frame.cmd = b;
+            dec_header(d, b, DEC_SEQ);
+            break;
+        case DEC_SEQ:
+            d->frame.seq = b;
+            dec_header(d, b, d->frame.version == DM_PROTOCOL_V2 ? DEC_LEN_HIGH : DEC_LEN);
+            break;
+        case DEC_LEN_HIGH:
+            d->frame.len = (uint16_t)(b << 8);
+            dec_header(d, b, DEC_LEN);
+            break;
+        case DEC_LEN:
+            d->frame.len = (uint16_t)(d->frame.version == DM_PROTOCOL_V2 ? d->frame.len | b : b);
+            d->crc       = crc16_update(d->crc, b);
+            dec_length_done(d);
+            break;
+        case DEC_PAYLOAD: {
+            /* Copy and CRC the run in one go. */
+            size_t run = d->frame.len - d->index;
+            if (run > n - i) run = n - i;
+            memcpy(&d->payload[d->index], &buf[i], run);
+            d->crc    = crc16_update_buf(d->crc, &buf[i], run);
+            d->index += (uint16_t)run;
+            i        += run - 1;
+            if (d->index == d->frame.len) d->state = DEC_CRC_HIGH;
+            break;
+        }
+        case DEC_CRC_HIGH:
+            d->crc_high = b;
+            d->state    = DEC_CRC_LOW;
+            break;
+        case DEC_CRC_LOW:
+            d->state = DEC_START;
+            if ((uint16_t)((d->crc_high << 8) | b) != d->crc) {
+                d->frames_bad++;
+                break;
+            }
+            d->frames_ok++;
+            d->frame.data = d->payload;
+            if (cb) cb(ctx, &d->frame);
+            break;
+        default:
+            d->state = DEC_START;
+            break;
+        }
+    }
+}
+
+/* ── Transport ───────────────────────────────────────────────────────────── */
+
+static hmic_host_t *s_cur = NULL;   /* Client the platform callbacks serve */
+
+static void host_bind(hmic_host_t *h)
+{
+    s_cur = h;
+    dm_packet_bind(&h->pk);
+}
+
+static void host_write_bytes(const uint8_t *data, uint16_t len)
+{
+    /* Unused: write_async is always set.  Kept so dm_packet sees a link. */
+    (void)data;
+    (void)len;
+}
+
+static void host_write_async(const uint8_t *data, uint16_t len)
+{
+    s_cur->tx_data = data;
+    s_cur->tx_len  = len;
+    s_cur->tx_off  = 0;
+}
+
+static void host_log(const char *msg)
+{
+    fprintf(stderr, "[hmic_host] %s\n", msg);
+}
+
+static const dm_platform_t s_platform = {
+    .write_bytes = host_write_bytes,
+    .write_async = host_write_async,
+    .millis      = host_millis,
+    .micros      = host_micros,
+    .log         = host_log,
+};
+
+/* Write as much of the queued transfers as the link takes now. */
+static int tx_kick(hmic_host_t *h)
+{
+    while (h->tx_data) {
+        ssize_t n = write(h->fd, h->tx_data + h->tx_off, h->tx_len - h->tx_off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        h->tx_off   += (uint16_t)n;
+        h->tx_bytes += (uint64_t)n;
+        if (h->tx_off < h->tx_len) continue;
+
+        /* Transfer done: frames queued meanwhile go out as the next one. */
+        h->tx_data = NULL;
+        dm_txq_complete(&h->pk.txq);
+        dm_packet_tx_poll(&s_platform);
+    }
+    return 0;
+}
+
+static speed_t baud_to_speed(uint32_t baud)
+{
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+    default:     return B115200;
+    }
+}
+
+static int open_serial(const char *path, uint32_t baud)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return -1;
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetspeed(&tty, baud_to_speed(baud));
+        tty.c_cflag |= CREAD | CLOCAL;
+        tty.c_cc[VMIN]  = 0;
+        tty.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    return fd;
+}
+
+static int open_tcp(const char *hostport)
+{
+    char host[256];
+    const char *colon = strrchr(hostport, ':');
+    if (!colon || (size_t)(colon - hostport) >= sizeof(host)) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(host, hostport, (size_t)(colon - hostport));
+    host[colon - hostport] = '\0';
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res;
+    if (getaddrinfo(host[0] ? host : "localhost", colon + 1, &hints, &res) != 0) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+
+    /* Frames are small and latency is what we measure. */
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int open_unix(const char *path)
+{
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(sa.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(sa.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* ── Client ──────────────────────────────────────────────────────────────── */
+
+/* The device's seq window bounds the one in flight (0 = it keeps none). */
+static void apply_window(hmic_host_t *h)
+{
+    uint8_t cap = h->caps_known ? h->seq_window : DM_SEQ_WINDOW;
+    h->window = (cap && h->window_req > cap) ? cap : h->window_req;
+}
+
+/* CMD_GET_CAPS reply: [version][max_payload:u16][features:u16][seq_window] */
+static void learn_caps(hmic_host_t *h, const uint8_t caps[6])
+{
+    h->features   = (uint16_t)((caps[3] << 8) | caps[4]);
+    h->seq_window = caps[5];
+    h->caps_known = true;
+    apply_window(h);
+}
+
+int hmic_host_open(hmic_host_t *h, const char *spec, uint32_t baud)
+{
+    memset(h, 0, sizeof(*h));
+    h->capture_fd = -1;
+    h->wait_seq   = -1;
+    h->window_req = HMIC_HOST_DEFAULT_WINDOW;
+    apply_window(h);
+    /* Not 0: the device's seq window may still hold the last session's frames. */
+    h->next_seq   = (uint8_t)(now_us() / 1000ULL);
+    h->timeout_us = HMIC_HOST_TIMEOUT_MS * 1000U;
+    hmic_decoder_init(&h->dec);
+
+    host_bind(h);
+    dm_packet_init();
+    dm_packet_set_address(DM_ADDR_NONE);
+
+    if (strncmp(spec, "tcp:", 4) == 0) {
+        h->fd = open_tcp(spec + 4);
+    } else if (strncmp(spec, "unix:", 5) == 0) {
+        h->fd = open_unix(spec + 5);
+    } else {
+        h->fd = open_serial(spec, baud);
+    }
+    if (h->fd < 0) return -1;
+
+    fcntl(h->fd, F_SETFL, fcntl(h->fd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+void hmic_host_close(hmic_host_t *h)
+{
+    hmic_host_capture(h, NULL);
+    if (h->fd >= 0) close(h->fd);
+    h->fd = -1;
+}
+
+void hmic_host_set_callbacks(hmic_host_t *h, hmic_done_cb_t on_done,
+                             hmic_frame_cb_t on_event, void *ctx)
+{
+    h->on_done  = on_done;
+    h->on_event = on_event;
+    h->cb_ctx   = ctx;
+}
+
+void hmic_host_set_window(hmic_host_t *h, uint8_t window)
+{
+    if (window < 1) window = 1;
+    if (window > HMIC_HOST_MAX_WINDOW) window = HMIC_HOST_MAX_WINDOW;
+    h->window_req = window;
+    apply_window(h);
+}
+
+void hmic_host_set_address(hmic_host_t *h, uint8_t address)
+{
+    host_bind(h);
+    dm_packet_set_address(address);
+}
+
+bool hmic_host_capture(hmic_host_t *h, const char *path)
+{
+    if (h->capture_fd >= 0) close(h->capture_fd);
+    h->capture_fd = -1;
+    if (!path) return true;
+    h->capture_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return h->capture_fd >= 0;
+}
+
+uint16_t hmic_host_max_payload(const hmic_host_t *h)
+{
+    return h->pk.peer_max_payload;
+}
+
+int hmic_host_send(hmic_host_t *h, uint8_t cmd, const uint8_t *payload, uint16_t len)
+{
+    uint8_t seq = h->next_seq;
+    if (h->in_flight >= h->window || h->slot[seq].used) return HMIC_HOST_BUSY;
+
+    host_bind(h);
+    dm_tx_frame_t f;
+    if (!dm_packet_reserve(&f, cmd, seq, len, &s_platform)) {
+        /* TX queue full: let the link drain first. */
+        tx_kick(h);
+        return HMIC_HOST_BUSY;
+    }
+    uint8_t *frame = f.buf;
+    if (payload) dm_packet_put(&f, payload, len);
+    dm_packet_commit(&f, &s_platform);
+
+    /* Still in the queue: keep a copy for retransmits (and the capture). */
+    hmic_slot_t *s = &h->slot[seq];
+    s->used     = true;
+    s->cmd      = cmd;
+    s->tries    = 1;
+    s->len      = f.len;
+    s->first_us = s->sent_us = now_us();
+    memcpy(s->frame, frame, f.len);
+    if (h->capture_fd >= 0 && write(h->capture_fd, s->frame, s->len) != (ssize_t)s->len) {
+        hmic_host_capture(h, NULL);
+    }
+
+    h->in_flight++;
+    h->next_seq = (uint8_t)(seq + 1);
+    tx_kick(h);   /* A failed link shows up in hmic_host_poll() */
+    return seq;
+}
+
+static void finish(hmic_host_t *h, uint8_t seq, hmic_status_t st,
+                   const uint8_t *data, uint16_t len)
+{
+    hmic_slot_t *s = &h->slot[seq];
+    hmic_hist_t *hist = &h->hist[s->cmd];
+
+    if (st == HMIC_LOST) {
+        hist->lost++;
+    } else {
+        uint64_t rtt = now_us() - s->first_us;
+        hmic_hist_add(hist, rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)rtt);
+        if (st == HMIC_NACKED) hist->nacks++;
+    }
+    s->used = false;
+    h->in_flight--;
+
+    if ((int)seq == h->wait_seq) {
+        h->wait_done   = true;
+        h->wait_status = (uint8_t)st;
+        h->wait_len    = len < sizeof(h->wait_data) ? len : sizeof(h->wait_data);
+        if (h->wait_len) memcpy(h->wait_data, data, h->wait_len);
+    }
+    if (h->on_done) h->on_done(h->cb_ctx, seq, s->cmd, st, data, len);
+}
+
+static void on_frame(void *ctx, const hmic_frame_t *f)
+{
+    hmic_host_t *h = ctx;
+
+    switch (f->cmd) {
+    case EVT_ACK:
+    case EVT_NACK:
+        if (!h->slot[f->seq].used) {
+            h->stale_replies++;   /* Answer to a retransmit already retired */
+            return;
+        }
+        finish(h, f->seq, f->cmd == EVT_ACK ? HMIC_ACKED : HMIC_NACKED, f->data, f->len);
+        break;
+    case EVT_ACK_RANGE:
+        if (f->len < 2) return;
+        for (uint8_t i = 0; i < f->data[1]; i++) {
+            uint8_t seq = (uint8_t)(f->data[0] + i);
+            if (h->slot[seq].used) finish(h, seq, HMIC_ACKED, NULL, 0);
+            else h->stale_replies++;
+        }
+        break;
+    default:
+        if (h->on_event) h->on_event(h->cb_ctx, f);
+        break;
+    }
+}
+
+/* Retransmit or give up commands whose reply is overdue; returns ms to the next. */
+static int check_timeouts(hmic_host_t *h)
+{
+    uint64_t now  = now_us();
+    uint64_t next = UINT64_MAX;
+
+    for (unsigned seq = 0; seq < 256 && h->in_flight; seq++) {
+        hmic_slot_t *s = &h->slot[seq];
+        if (!s->used) continue;
+        if (now - s->sent_us < h->timeout_us) {
+            uint64_t due = s->sent_us + h->timeout_us;
+            if (due < next) next = due;
+            continue;
+        }
+        if (s->tries > HMIC_HOST_RETRIES) {
+            finish(h, (uint8_t)seq, HMIC_LOST, NULL, 0);
+            continue;
+        }
+        /* Identical bytes, so the device answers from its seq window. */
+        if (!dm_txq_write(&h->pk.txq, s->frame, s->len, &s_platform)) {
+            next = now + 1000;   /* Queue full: try again once it drains */
+            continue;
+        }
+        s->tries++;
+        s->sent_us = now;
+        h->hist[s->cmd].retries++;
+        if (now + h->timeout_us < next) next = now + h->timeout_us;
+    }
+    if (next == UINT64_MAX) return -1;
+    return next <= now ? 0 : (int)((next - now + 999) / 1000);
+}
+
+int hmic_host_poll(hmic_host_t *h, int timeout_ms)
+{
+    host_bind(h);
+    if (h->fd < 0) return -1;
+
+    int due = check_timeouts(h);
+    if (due >= 0 && (timeout_ms < 0 || due < timeout_ms)) timeout_ms = due;
+    if (tx_kick(h) < 0) return -1;
+
+    struct pollfd pfd = { .fd = h->fd, .events = POLLIN };
+    if (h->tx_data) pfd.events |= POLLOUT;
+    int r = poll(&pfd, 1, timeout_ms);
+    if (r < 0) return errno == EINTR ? 0 : -1;
+    if (r == 0) return 0;
+
+    if ((pfd.revents & POLLOUT) && tx_kick(h) < 0) return -1;
+    if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+        uint8_t buf[4096];
+        for (;;) {
+            ssize_t n = read(h->fd, buf, sizeof(buf));
+            if (n > 0) {
+                h->rx_bytes += (uint64_t)n;
+                hmic_decoder_feed(&h->dec, buf, (size_t)n, on_frame, h);
+                host_bind(h);   /* Callbacks may have served another client */
+                continue;
+            }
+            if (n == 0) return -1;   /* Peer closed */
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int ms_left(uint64_t deadline)
+{
+    uint64_t now = now_us();
+    return now >= deadline ? 0 : (int)((deadline - now + 999) / 1000);
+}
+
+bool hmic_host_drain(hmic_host_t *h, int timeout_ms)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000ULL;
+    while (h->in_flight || h->tx_data) {
+        int left = ms_left(deadline);
+        if (left == 0 || hmic_host_poll(h, left) < 0) return false;
+    }
+    return true;
+}
+
+hmic_status_t hmic_host_call(hmic_host_t *h, uint8_t cmd, const uint8_t *payload,
+                             uint16_t len, uint8_t *reply, uint16_t *reply_len,
+                             int timeout_ms)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000ULL;
+    int seq;
+    while ((seq = hmic_host_send(h, cmd, payload, len)) == HMIC_HOST_BUSY) {
+        int left = ms_left(deadline);
+        if (left == 0 || hmic_host_poll(h, left) < 0) return HMIC_LOST;
+    }
+
+    h->wait_seq  = seq;
+    h->wait_done = false;
+    while (!h->wait_done) {
+        int left = ms_left(deadline);
+        if (left == 0 || hmic_host_poll(h, left) < 0) break;
+    }
+    h->wait_seq = -1;
+    if (!h->wait_done) return HMIC_LOST;
+
+    if (reply_len) {
+        uint16_t n = h->wait_len < *reply_len ? h->wait_len : *reply_len;
+        if (reply && n) memcpy(reply, h->wait_data, n);
+        *reply_len = n;
+    }
+    return (hmic_status_t)h->wait_status;
+}
+
+bool hmic_host_negotiate(hmic_host_t *h, uint8_t version, uint16_t max_payload)
+{
+    uint8_t req[3] = { version, (uint8_t)(max_payload >> 8), (uint8_t)max_payload };
+    uint8_t caps[6];
+    uint16_t n = sizeof(caps);
+
+    if (hmic_host_call(h, CMD_GET_CAPS, req, sizeof(req), caps, &n, 1000) != HMIC_ACKED ||
+        n < sizeof(caps)) {
+        return false;
+    }
+    /* The device frames everything after this reply the agreed way. */
+    host_bind(h);
+    dm_packet_set_peer(caps[0], (uint16_t)((caps[1] << 8) | caps[2]));
+    learn_caps(h, caps);
+    return true;
+}
+
+bool hmic_host_get_caps(hmic_host_t *h)
+{
+    uint8_t caps[6];
+    uint16_t n = sizeof(caps);
+
+    if (hmic_host_call(h, CMD_GET_CAPS, NULL, 0, caps, &n, 1000) != HMIC_ACKED ||
+        n < sizeof(caps)) {
+        return false;
+    }
+    learn_caps(h, caps);
+    return true;
+}
+
+/* ── Batching ────────────────────────────────────────────────────────────── */
+
+void hmic_batch_init(hmic_batch_t *b)
+{
+    b->len   = 0;
+    b->count = 0;
+}
+
+bool hmic_batch_add(hmic_batch_t *b, const hmic_host_t *h, uint8_t cmd,
+                    const uint8_t *payload, uint8_t len)
+{
+    uint16_t room = hmic_host_max_payload(h);
+    if (room > sizeof(b->buf)) room = sizeof(b->buf);
+    if (b->count >= DM_BATCH_MAX_CMDS || b->len + 2U + len > room) return false;
+
+    b->buf[b->len++] = cmd;
+    b->buf[b->len++] = len;
+    if (len) memcpy(&b->buf[b->len], payload, len);
+    b->len += len;
+    b->count++;
+    return true;
+}
+
+int hmic_host_send_batch(hmic_host_t *h, const hmic_batch_t *b)
+{
+    return hmic_host_send(h, CMD_BATCH, b->buf, b->len);
+}
+
+/* ── Statistics ──────────────────────────────────────────────────────────── */
+
+const hmic_hist_t *hmic_host_hist(const hmic_host_t *h, uint8_t cmd)
+{
+    return &h->hist[cmd];
+}
+
+void hmic_host_clear_stats(hmic_host_t *h)
+{
+    memset(h->hist, 0, sizeof(h->hist));
+    h->tx_bytes      = 0;
+    h->rx_bytes      = 0;
+    h->stale_replies = 0;
+}
+
+void hmic_host_report(const hmic_host_t *h, FILE *out)
+{
+    fprintf(out, "%-5s %8s %6s %5s %6s %8s %8s %8s %8s %8s  (us)\n",
+            "cmd", "count", "nacks", "lost", "retx", "min", "p50", "p90", "p99", "max");
+    for (unsigned c = 0; c < 256; c++) {
+        const hmic_hist_t *s = &h->hist[c];
+        if (s->count == 0 && s->lost == 0) continue;
+        fprintf(out, "0x%02x  %8u %6u %5u %6u %8u %8u %8u %8u %8u\n", c,
+                (unsigned)s->count, (unsigned)s->nacks, (unsigned)s->lost,
+                (unsigned)s->retries, (unsigned)s->min_us,
+                (unsigned)hmic_hist_percentile(s, 0.50),
+                (unsigned)hmic_hist_percentile(s, 0.90),
+                (unsigned)hmic_hist_percentile(s, 0.99), (unsigned)s->max_us);
+    }
+    fprintf(out, "tx %llu B, rx %llu B, %u bad frames, %u stale replies\n",
+            (unsigned long long)h->tx_bytes, (unsigned long long)h->rx_bytes,
+            (unsigned)h->dec.frames_bad, (unsigned)h->stale_replies);
+}
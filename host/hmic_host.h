@@ -0,0 +1,364 @@
+/**
+ * @file hmic_host.h
+ * @brief Host-side client library: pipelined commands over a POSIX link.
+ *
+ * The production counterpart of tools/host_tester.py, for hosts and load
+ * tests that need to keep the line full.  One hmic_host_t drives one
+ * device over a serial port, a TCP socket or a Unix socket (the headless
+ * simulator's --listen), all non-blocking and single-threaded:
+ *
+ *   - Frames are encoded with the device's own dm_packet encoder and
+ *     CRC16 engine into a dm_txq, so frames sent back to back leave in
+ *     one write() and the bytes are identical to what the device builds.
+ *   - Up to a window of commands are kept in flight.  Unanswered ones are
+ *     retransmitted unchanged (same SEQ_ID and CRC), so the device's seq
+ *     window answers them without running them twice (protocol §4.1).
+ *     EVT_ACK_RANGE retires a whole run at once (§4.2).
+ *   - hmic_batch_t packs small commands into one CMD_BATCH (§2.4).
+ *   - Every command's round trip, first send to reply, goes into a
+ *     per-command latency histogram.
+ *   - Frames can be captured as first sent, in the raw stream format that
+ *     hmic_bench --replay reads; hmic_load replays such a capture.
+ *
+ * Drive it with hmic_host_poll(); callbacks run from inside it.  Nothing
+ * here is thread-safe: use one hmic_host_t per thread.
+ */
+#ifndef HMIC_HOST_H
+#define HMIC_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "dm_config.h"
+#include "dm_packet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Most commands kept in flight (the device's DM_SEQ_WINDOW limits it further). */
+#ifndef HMIC_HOST_MAX_WINDOW
+#define HMIC_HOST_MAX_WINDOW 64
+#endif
+
+/** Window asked for until hmic_host_set_window(). */
+#ifndef HMIC_HOST_DEFAULT_WINDOW
+#define HMIC_HOST_DEFAULT_WINDOW 8
+#endif
+
+/** Reply wait before a command is retransmitted. */
+#ifndef HMIC_HOST_TIMEOUT_MS
+#define HMIC_HOST_TIMEOUT_MS 250
+#endif
+
+/** Retransmits before a command is given up as lost. */
+#ifndef HMIC_HOST_RETRIES
+#define HMIC_HOST_RETRIES 3
+#endif
+
+#if HMIC_HOST_MAX_WINDOW > 128
+#error "HMIC_HOST_MAX_WINDOW must leave most SEQ_IDs free (a stuck one is never reused)"
+#endif
+
+/** hmic_host_send() result when the window or the TX queue is full. */
+#define HMIC_HOST_BUSY (-1)
+
+/* ── Latency histogram ───────────────────────────────────────────────────── */
+
+/** Buckets per octave: bucket edges are about 19 % apart. */
+#define HMIC_HIST_SUB     4
+/** 1 µs to over an hour. */
+#define HMIC_HIST_BUCKETS (32 * HMIC_HIST_SUB)
+
+/** Round trips of one command id, in µs. */
+typedef struct {
+    uint32_t count;       /**< Commands answered (ACK or NACK) */
+    uint32_t nacks;
+    uint32_t lost;        /**< Given up after HMIC_HOST_RETRIES retransmits */
+    uint32_t retries;     /**< Retransmits sent */
+    uint64_t sum_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t bucket[HMIC_HIST_BUCKETS];
+} hmic_hist_t;
+
+/** @brief Record one round trip of @p us µs. */
+void hmic_hist_add(hmic_hist_t *h, uint32_t us);
+
+/**
+ * @brief Round trip below which a fraction @p q of the samples fall.
+ *
+ * @param h  Histogram.
+ * @param q  0.0 … 1.0 (0.5 = median).
+ * @return Upper edge of the bucket holding that sample, capped at max_us;
+ *         0 if the histogram is empty.
+ */
+uint32_t hmic_hist_percentile(const hmic_hist_t *h, double q);
+
+/* ── Frame decoder ───────────────────────────────────────────────────────── */
+
+/** One decoded frame; data is valid only during the callback. */
+typedef struct {
+    uint8_t        version;   /**< Without DM_VERSION_ADDR_FLAG */
+    uint8_t        address;   /**< DM_ADDR_NONE if the frame had none */
+    uint8_t        cmd;
+    uint8_t        seq;
+    uint16_t       len;
+    const uint8_t *data;
+} hmic_frame_t;
+
+typedef void (*hmic_frame_cb_t)(void *ctx, const hmic_frame_t *f);
+
+/**
+ * @brief Byte-wise frame decoder, v1 / v2 and addressed frames.
+ *
+ * The host-side mirror of dm_parser without its dispatch: good frames go
+ * to a callback.  After a bad frame it resumes at the next start byte.
+ */
+typedef struct {
+    uint8_t  state;
+    uint8_t  crc_high;
+    uint16_t crc;
+    uint16_t index;
+    hmic_frame_t frame;
+    uint8_t  payload[DM_MAX_PAYLOAD];
+
+    uint32_t frames_ok;
+    uint32_t frames_bad;      /**< CRC or length errors */
+} hmic_decoder_t;
+
+/** @brief Reset a decoder (counters included). */
+void hmic_decoder_init(hmic_decoder_t *d);
+
+/**
+ * @brief Decode a span of bytes.
+ *
+ * @param d    Decoder.
+ * @param buf  Bytes, in wire order.
+ * @param n    Number of bytes.
+ * @param cb   Called for each good frame.
+ * @param ctx  Passed to @p cb.
+ */
+void hmic_decoder_feed(hmic_decoder_t *d, const uint8_t *buf, size_t n,
+                       hmic_frame_cb_t cb, void *ctx);
+
+/* ── Client ──────────────────────────────────────────────────────────────── */
+
+/** How a command ended. */
+typedef enum {
+    HMIC_ACKED,
+    HMIC_NACKED,
+    HMIC_LOST,           /**< No reply after HMIC_HOST_RETRIES retransmits */
+} hmic_status_t;
+
+/**
+ * @brief A command was answered or given up.
+ *
+ * @p data / @p len are the EVT_ACK payload (none for EVT_ACK_RANGE).
+ */
+typedef void (*hmic_done_cb_t)(void *ctx, uint8_t seq, uint8_t cmd,
+                               hmic_status_t status, const uint8_t *data, uint16_t len);
+
+/** One command in flight. */
+typedef struct {
+    bool     used;
+    uint8_t  cmd;
+    uint8_t  tries;
+    uint16_t len;                        /**< Encoded frame bytes */
+    uint64_t first_us;                   /**< First send (latency start) */
+    uint64_t sent_us;                    /**< Latest send (retransmit timer) */
+    uint8_t  frame[DM_MAX_FRAME_SIZE];   /**< Kept for retransmits */
+} hmic_slot_t;
+
+/**
+ * @brief Client state of one device link.
+ *
+ * Fields are private; the struct is public so it can be allocated
+ * statically.  It is large (per-seq frames, 256 histograms).
+ */
+typedef struct {
+    int fd;
+    int capture_fd;                      /**< -1 = not capturing */
+
+    dm_packet_state_t pk;                /**< Encoder + TX queue */
+    const uint8_t    *tx_data;           /**< dm_txq transfer being written */
+    uint16_t          tx_len;
+    uint16_t          tx_off;
+
+    hmic_decoder_t dec;
+
+    uint8_t  window;                     /**< In force: window_req, capped */
+    uint8_t  window_req;                 /**< As set by hmic_host_set_window() */
+    uint8_t  next_seq;
+    uint8_t  in_flight;
+    uint32_t timeout_us;
+    hmic_slot_t slot[256];               /**< Indexed by SEQ_ID */
+
+    /* From CMD_GET_CAPS (hmic_host_negotiate(), hmic_host_get_caps()) */
+    uint16_t features;
+    uint8_t  seq_window;
+    bool     caps_known;
+
+    hmic_done_cb_t  on_done;
+    hmic_frame_cb_t on_event;
+    void           *cb_ctx;
+
+    /* hmic_host_call() reply */
+    int      wait_seq;
+    bool     wait_done;
+    uint8_t  wait_status;
+    uint16_t wait_len;
+    uint8_t  wait_data[DM_MAX_PAYLOAD];
+
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint32_t stale_replies;              /**< Replies for seqs not in flight */
+    hmic_hist_t hist[256];               /**< By command id */
+} hmic_host_t;
+
+/**
+ * @brief Open a link and reset the client.
+ *
+ * @param h     Client (any contents).
+ * @param spec  "tcp:HOST:PORT", "unix:PATH" or a serial device path.
+ * @param baud  Serial speed (ignored for sockets).
+ * @return 0, or -1 with errno set.
+ */
+int hmic_host_open(hmic_host_t *h, const char *spec, uint32_t baud);
+
+/** @brief Close the link and any capture file. */
+void hmic_host_close(hmic_host_t *h);
+
+/**
+ * @brief Callbacks for finished commands and device events (NULL = none).
+ *
+ * @p on_event receives every frame that is not a reply (EVT_BUTTON_PRESSED,
+ * EVT_SLIDER_CHANGED …).
+ */
+void hmic_host_set_callbacks(hmic_host_t *h, hmic_done_cb_t on_done,
+                             hmic_frame_cb_t on_event, void *ctx);
+
+/**
+ * @brief Commands kept in flight (1 … HMIC_HOST_MAX_WINDOW).
+ *
+ * Must not exceed the device's DM_SEQ_WINDOW, or retransmits may run a
+ * command twice.  Capped to the seq window the device reports through
+ * CMD_GET_CAPS, and to DM_SEQ_WINDOW (the firmware default) until then.
+ */
+void hmic_host_set_window(hmic_host_t *h, uint8_t window);
+
+/**
+ * @brief ADDRESS stamped on every frame (multi-drop), or DM_ADDR_NONE.
+ */
+void hmic_host_set_address(hmic_host_t *h, uint8_t address);
+
+/**
+ * @brief Record every frame as first sent (no retransmits) to @p path.
+ *
+ * @param path  Output file, truncated; NULL stops capturing.
+ * @return false if the file cannot be created.
+ */
+bool hmic_host_capture(hmic_host_t *h, const char *path);
+
+/**
+ * @brief Queue a command without waiting.
+ *
+ * @return Its SEQ_ID, or HMIC_HOST_BUSY when the window or the TX queue
+ *         is full (poll and try again).
+ */
+int hmic_host_send(hmic_host_t *h, uint8_t cmd, const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Run the link: write, read, deliver replies and events, retransmit.
+ *
+ * @param h           Client.
+ * @param timeout_ms  Longest wait for I/O (0 = none, -1 = until something
+ *                    happens or a retransmit is due).
+ * @return 0, or -1 when the link has closed or failed.
+ */
+int hmic_host_poll(hmic_host_t *h, int timeout_ms);
+
+/**
+ * @brief Poll until nothing is in flight.
+ * @return false on timeout or link failure.
+ */
+bool hmic_host_drain(hmic_host_t *h, int timeout_ms);
+
+/**
+ * @brief Send one command and wait for its reply.
+ *
+ * Other commands already in flight keep running meanwhile.
+ *
+ * @param reply      Receives the ACK payload (may be NULL).
+ * @param reply_len  In: room in @p reply; out: payload bytes (may be NULL).
+ * @return How the command ended; HMIC_LOST also on timeout or link failure.
+ */
+hmic_status_t hmic_host_call(hmic_host_t *h, uint8_t cmd, const uint8_t *payload,
+                             uint16_t len, uint8_t *reply, uint16_t *reply_len,
+                             int timeout_ms);
+
+/**
+ * @brief CMD_GET_CAPS: agree on framing and payload size, cap the window.
+ *
+ * @param version      Highest version to offer (DM_PROTOCOL_V2).
+ * @param max_payload  Largest payload to accept (≤ DM_MAX_PAYLOAD).
+ * @return false if the device did not answer (the link stays on v1).
+ */
+bool hmic_host_negotiate(hmic_host_t *h, uint8_t version, uint16_t max_payload);
+
+/**
+ * @brief Empty CMD_GET_CAPS: learn the features and seq window, cap the window.
+ *
+ * Leaves the framing as it is (v1 unless negotiated).
+ * @return false if the device did not answer.
+ */
+bool hmic_host_get_caps(hmic_host_t *h);
+
+/** @brief Largest payload that may be sent now. */
+uint16_t hmic_host_max_payload(const hmic_host_t *h);
+
+/* ── Batching ────────────────────────────────────────────────────────────── */
+
+/** CMD_BATCH payload under construction. */
+typedef struct {
+    uint8_t  buf[DM_MAX_PAYLOAD];
+    uint16_t len;
+    uint8_t  count;
+} hmic_batch_t;
+
+/** @brief Empty a batch. */
+void hmic_batch_init(hmic_batch_t *b);
+
+/**
+ * @brief Append one sub-command.
+ *
+ * @return false if it does not fit the link's payload or
+ *         DM_BATCH_MAX_CMDS (the batch is unchanged).
+ */
+bool hmic_batch_add(hmic_batch_t *b, const hmic_host_t *h, uint8_t cmd,
+                    const uint8_t *payload, uint8_t len);
+
+/** @brief Queue the batch as one CMD_BATCH (like hmic_host_send()). */
+int hmic_host_send_batch(hmic_host_t *h, const hmic_batch_t *b);
+
+/* ── Statistics ──────────────────────────────────────────────────────────── */
+
+/** @brief Latency histogram of command @p cmd. */
+const hmic_hist_t *hmic_host_hist(const hmic_host_t *h, uint8_t cmd);
+
+/** @brief Clear the histograms and byte counters. */
+void hmic_host_clear_stats(hmic_host_t *h);
+
+/**
+ * @brief Print one line per command id used: count, NACKs, lost,
+ *        retransmits and min / p50 / p90 / p99 / max round trip.
+ */
+void hmic_host_report(const hmic_host_t *h, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HMIC_HOST_H */
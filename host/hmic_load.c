@@ -0,0 +1,346 @@
+/**
+ * @file hmic_load.c
+ * @brief Load generator and latency profiler built on hmic_host.
+ *
+ * Keeps a window of commands in flight against a device or the headless
+ * simulator and prints throughput plus a round-trip histogram per
+ * command.  The traffic is synthetic (--mix) or replayed from a capture
+ * (--replay) taken with --capture, hmic_bench's raw stream format.
+ *
+ *   ./build-sim/hmic_sim --headless --listen tcp:7000 --baud 0 &
+ *   ./build-sim/hmic_load --port tcp:localhost:7000 --v2 --count 10000
+ *   ./build-sim/hmic_load --port tcp:localhost:7000 --mix batch --cumulative
+ *   ./build-sim/hmic_load --port /dev/ttyUSB0 --replay dashboard.bin --count 5
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hmic_host.h"
+#include "dm_protocol.h"
+
+/* Widgets of the built-in layout (app/ui/ui_layout_default.c) */
+#define LOAD_TEXT_WIDGET   0
+#define LOAD_LABEL_WIDGET  1
+#define LOAD_VALUES_FIRST  3
+#define LOAD_SLIDER_WIDGET 4
+
+typedef struct {
+    uint8_t  cmd;
+    uint16_t len;
+    uint8_t  data[DM_MAX_PAYLOAD];
+} load_cmd_t;
+
+typedef struct {
+    load_cmd_t *cmds;
+    size_t      count;
+    size_t      cap;
+} load_script_t;
+
+static uint32_t s_events = 0;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void on_event(void *ctx, const hmic_frame_t *f)
+{
+    (void)ctx;
+    (void)f;
+    s_events++;
+}
+
+/* ── Traffic ─────────────────────────────────────────────────────────────── */
+
+/* Command @p i of a synthetic mix; returns false for an unknown mix. */
+static bool make_cmd(const hmic_host_t *h, const char *mix, uint32_t i,
+                     uint8_t batch_size, load_cmd_t *c)
+{
+    int16_t v = (int16_t)(i % 101);
+
+    if (strcmp(mix, "value") == 0) {
+        c->cmd = CMD_SET_VALUE;
+        c->len = 3;
+        c->data[0] = LOAD_SLIDER_WIDGET;
+        c->data[1] = (uint8_t)((uint16_t)v >> 8);
+        c->data[2] = (uint8_t)v;
+    } else if (strcmp(mix, "text") == 0) {
+        c->cmd  = CMD_SET_TEXT;
+        c->data[0] = LOAD_TEXT_WIDGET;
+        c->len  = (uint16_t)(1 + snprintf((char *)&c->data[1], DM_MAX_TEXT_LEN, "load %u", (unsigned)i));
+    } else if (strcmp(mix, "values") == 0) {
+        /* The label at LOAD_VALUES_FIRST is skipped; the slider takes the second. */
+        c->cmd = CMD_SET_VALUES;
+        c->len = 6;
+        c->data[0] = LOAD_VALUES_FIRST;
+        c->data[1] = DM_VALUES_ABSOLUTE;
+        c->data[2] = 0;
+        c->data[3] = 0;
+        c->data[4] = (uint8_t)((uint16_t)v >> 8);
+        c->data[5] = (uint8_t)v;
+    } else if (strcmp(mix, "batch") == 0) {
+        hmic_batch_t b;
+        hmic_batch_init(&b);
+        for (uint8_t k = 0; k < batch_size; k++) {
+            uint32_t j = i * batch_size + k;
+            if (k & 1) {
+                char text[16];
+                int n = snprintf(text, sizeof(text), "b%u", (unsigned)j);
+                uint8_t sub[1 + sizeof(text)] = { LOAD_LABEL_WIDGET };
+                memcpy(&sub[1], text, (size_t)n);
+                if (!hmic_batch_add(&b, h, CMD_SET_TEXT, sub, (uint8_t)(1 + n))) break;
+            } else {
+                int16_t bv = (int16_t)(j % 101);
+                uint8_t sub[3] = { LOAD_SLIDER_WIDGET, (uint8_t)((uint16_t)bv >> 8), (uint8_t)bv };
+                if (!hmic_batch_add(&b, h, CMD_SET_VALUE, sub, sizeof(sub))) break;
+            }
+        }
+        c->cmd = CMD_BATCH;
+        c->len = b.len;
+        memcpy(c->data, b.buf, b.len);
+    } else if (strcmp(mix, "ping") == 0) {
+        c->cmd = CMD_PING;
+        c->len = 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void script_add(void *ctx, const hmic_frame_t *f)
+{
+    load_script_t *s = ctx;
+
+    /* Link set-up belongs to this run's own options, not the capture's. */
+    if (f->cmd >= EVT_BUTTON_PRESSED || f->cmd == CMD_GET_CAPS ||
+        f->cmd == CMD_SET_ACK_MODE || f->cmd == CMD_RESET ||
+        f->cmd == CMD_ENTER_BOOTLOADER) {
+        return;
+    }
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 256;
+        load_cmd_t *more = realloc(s->cmds, cap * sizeof(*more));
+        if (!more) return;
+        s->cmds = more;
+        s->cap  = cap;
+    }
+    load_cmd_t *c = &s->cmds[s->count++];
+    c->cmd = f->cmd;
+    c->len = f->len;
+    memcpy(c->data, f->data, f->len);
+}
+
+static bool load_replay(const char *path, load_script_t *s)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    hmic_decoder_t dec;
+    hmic_decoder_init(&dec);
+
+    uint8_t buf[4096];
+    size_t  n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        hmic_decoder_feed(&dec, buf, n, script_add, s);
+    }
+    fclose(f);
+
+    if (s->count == 0) {
+        fprintf(stderr, "%s: no commands\n", path);
+        return false;
+    }
+    printf("[load] %s: %zu commands (%u bad frames skipped)\n", path, s->count,
+           (unsigned)dec.frames_bad);
+    return true;
+}
+
+/* ── Device statistics ───────────────────────────────────────────────────── */
+
+static void print_device_stats(hmic_host_t *h)
+{
+    uint8_t  r[21 * 4];
+    uint16_t n = sizeof(r);
+    uint8_t  flags = 0;
+
+    if (hmic_host_call(h, CMD_GET_STATS, &flags, 1, r, &n, 1000) != HMIC_ACKED || n < sizeof(r)) {
+        printf("[load] no CMD_GET_STATS reply\n");
+        return;
+    }
+    uint32_t v[21];
+    for (unsigned i = 0; i < 21; i++) {
+        v[i] = ((uint32_t)r[i * 4] << 24) | ((uint32_t)r[i * 4 + 1] << 16) |
+               ((uint32_t)r[i * 4 + 2] << 8) | r[i * 4 + 3];
+    }
+    printf("device: frames %u ok, %u crc, %u len, %u timeout; %u nacks, %u duplicates\n",
+           (unsigned)v[1], (unsigned)v[2], (unsigned)v[3], (unsigned)v[4],
+           (unsigned)v[11], (unsigned)v[12]);
+    printf("device: rx ring peak %u, tx queue peak %u, tx dropped %u\n",
+           (unsigned)v[7], (unsigned)v[10], (unsigned)v[9]);
+    printf("device: dispatch avg %u / max %u us, render avg %u / max %u us\n",
+           (unsigned)v[15], (unsigned)v[16], (unsigned)v[19], (unsigned)v[20]);
+}
+
+/* ── Entry point ─────────────────────────────────────────────────────────── */
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --port SPEC [options]\n"
+            "  --port SPEC     tcp:HOST:PORT, unix:PATH or a serial device\n"
+            "  --baud N        serial speed (default 115200)\n"
+            "  --v2            negotiate v2 framing and the largest payload first\n"
+            "  --window N      commands in flight (default 8, capped by the device's\n"
+            "                  seq window, or 16 if it does not answer CMD_GET_CAPS)\n"
+            "  --cumulative    cumulative ACKs (EVT_ACK_RANGE)\n"
+            "  --addr N        address panel N on a multi-drop bus\n"
+            "  --mix KIND      value | text | values | batch | ping (default value)\n"
+            "  --batch N       sub-commands per CMD_BATCH for --mix batch (default 8)\n"
+            "  --count N       commands to send; passes with --replay (default 1000)\n"
+            "  --rate HZ       at most HZ commands per second (default: unpaced)\n"
+            "  --capture FILE  record the frames sent (hmic_bench --replay format)\n"
+            "  --replay FILE   resend the commands of a capture instead of --mix\n"
+            "  --stats         print the device's CMD_GET_STATS afterwards\n",
+            argv0);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *port = NULL, *mix = "value", *capture = NULL, *replay = NULL;
+    uint32_t baud = 115200, count = 1000, rate = 0;
+    int      window = -1, addr = -1, batch_size = 8;
+    bool     v2 = false, cumulative = false, stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && has_arg) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--baud") == 0 && has_arg) {
+            baud = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--window") == 0 && has_arg) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--addr") == 0 && has_arg) {
+            addr = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mix") == 0 && has_arg) {
+            mix = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && has_arg) {
+            batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && has_arg) {
+            count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rate") == 0 && has_arg) {
+            rate = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--capture") == 0 && has_arg) {
+            capture = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && has_arg) {
+            replay = argv[++i];
+        } else if (strcmp(argv[i], "--v2") == 0) {
+            v2 = true;
+        } else if (strcmp(argv[i], "--cumulative") == 0) {
+            cumulative = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!port || batch_size < 1 || batch_size > DM_BATCH_MAX_CMDS) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    load_script_t script = { 0 };
+    if (replay && !load_replay(replay, &script)) return 1;
+
+    static hmic_host_t h;   /* Large: keep it off the stack */
+    if (hmic_host_open(&h, port, baud) != 0) {
+        perror(port);
+        return 1;
+    }
+    hmic_host_set_callbacks(&h, NULL, on_event, NULL);
+    if (addr >= 0) hmic_host_set_address(&h, (uint8_t)addr);
+    if (window > 0) hmic_host_set_window(&h, (uint8_t)window);
+
+    /* Either way the device's seq window caps --window. */
+    if (v2) {
+        if (!hmic_host_negotiate(&h, DM_PROTOCOL_V2, DM_MAX_PAYLOAD))
+            fprintf(stderr, "[load] no CMD_GET_CAPS reply, staying on v1\n");
+    } else if (!hmic_host_get_caps(&h)) {
+        fprintf(stderr, "[load] no CMD_GET_CAPS reply, window capped at %u\n",
+                (unsigned)DM_SEQ_WINDOW);
+    }
+    if (cumulative) {
+        uint8_t mode = DM_ACK_MODE_CUMULATIVE;
+        if (hmic_host_call(&h, CMD_SET_ACK_MODE, &mode, 1, NULL, NULL, 1000) != HMIC_ACKED) {
+            fprintf(stderr, "[load] CMD_SET_ACK_MODE failed\n");
+        }
+    }
+    printf("[load] window %u, max payload %u\n", (unsigned)h.window,
+           (unsigned)hmic_host_max_payload(&h));
+
+    /* Only the measured traffic is captured and reported. */
+    if (capture && !hmic_host_capture(&h, capture)) {
+        perror(capture);
+        return 1;
+    }
+    hmic_host_clear_stats(&h);
+
+    uint32_t total = replay ? count * (uint32_t)script.count : count;
+    uint64_t t0    = now_us();
+    uint32_t sent  = 0;
+    bool     ok    = true;
+    load_cmd_t c;
+
+    while (ok && sent < total) {
+        if (rate) {
+            /* Next command is due at t0 + sent / rate. */
+            uint64_t due = t0 + (uint64_t)sent * 1000000ULL / rate;
+            uint64_t now = now_us();
+            if (now < due) {
+                ok = hmic_host_poll(&h, (int)((due - now + 999) / 1000)) >= 0;
+                continue;
+            }
+        }
+        const load_cmd_t *next = &c;
+        if (replay) {
+            next = &script.cmds[sent % script.count];
+        } else if (!make_cmd(&h, mix, sent, (uint8_t)batch_size, &c)) {
+            fprintf(stderr, "unknown --mix %s\n", mix);
+            return 2;
+        }
+
+        if (hmic_host_send(&h, next->cmd, next->data, next->len) == HMIC_HOST_BUSY) {
+            ok = hmic_host_poll(&h, -1) >= 0;   /* Window full: wait for replies */
+        } else {
+            sent++;
+            ok = hmic_host_poll(&h, 0) >= 0;
+        }
+    }
+    if (ok) ok = hmic_host_drain(&h, 5000);
+    uint64_t dt = now_us() - t0;
+    hmic_host_capture(&h, NULL);
+
+    double secs = dt > 0 ? (double)dt / 1e6 : 1e-6;
+    printf("[load] %u commands in %.1f ms: %.0f cmd/s, tx %.1f KiB/s, %u events\n",
+           (unsigned)sent, (double)dt / 1000.0, sent / secs, h.tx_bytes / secs / 1024.0,
+           (unsigned)s_events);
+    hmic_host_report(&h, stdout);
+    if (!ok) fprintf(stderr, "[load] link failed or replies missing\n");
+
+    if (stats && ok) print_device_stats(&h);
+
+    uint32_t lost = 0;
+    for (unsigned i = 0; i < 256; i++) lost += hmic_host_hist(&h, (uint8_t)i)->lost;
+
+    hmic_host_close(&h);
+    free(script.cmds);
+    return ok && lost == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file dm_test.c
+ * @brief Recording platform, frame builder and reply decoder (see dm_test.h).
+ */
+#include "dm_test.h"
+#include "dm_core.h"
+#include "crc16.h"
+
+#include <string.h>
+
+uint32_t dmt_now_ms   = 0;
+int      dmt_failures = 0;
+
+static uint8_t s_out[DMT_CAPTURE_SIZE];
+static size_t  s_out_len = 0;
+static int     s_failures_before = 0;
+
+/* ── Recording platform ─────────────────────────────────────────────────── */
+
+static void rec_write(const uint8_t *data, uint16_t len)
+{
+    if (len > sizeof(s_out) - s_out_len) {
+        fprintf(stderr, "dm_test: capture full, call dmt_replies() more often\n");
+        dmt_failures++;
+        return;
+    }
+    memcpy(&s_out[s_out_len], data, len);
+    s_out_len += len;
+}
+
+static uint32_t rec_millis(void)
+{
+    return dmt_now_ms;
+}
+
+static uint32_t rec_micros(void)
+{
+    return dmt_now_ms * 1000U;
+}
+
+dm_platform_t dmt_platform = {
+    .write_bytes = rec_write,
+    .millis      = rec_millis,
+    .micros      = rec_micros,
+};
+
+void dmt_reset(void)
+{
+    dmt_now_ms = 0;
+    s_out_len  = 0;
+    dm_init(&dmt_platform);
+}
+
+/* ── Host frames ────────────────────────────────────────────────────────── */
+
+size_t dmt_frame(uint8_t *out, uint8_t version, uint8_t cmd, uint8_t seq,
+                 const uint8_t *payload, uint16_t len)
+{
+    size_t i = 0;
+    out[i++] = DM_START_BYTE;
+    out[i++] = version;
+    out[i++] = cmd;
+    out[i++] = seq;
+    if (version == DM_PROTOCOL_V2) out[i++] = (uint8_t)(len >> 8);
+    out[i++] = (uint8_t)len;
+    if (len) memcpy(&out[i], payload, len);
+    i += len;
+
+    uint16_t crc = crc16_ccitt(&out[1], i - 1);
+    out[i++] = (uint8_t)(crc >> 8);
+    out[i++] = (uint8_t)crc;
+    return i;
+}
+
+void dmt_send(uint8_t version, uint8_t cmd, uint8_t seq,
+              const uint8_t *payload, uint16_t len)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dm_receive_bytes(frame, dmt_frame(frame, version, cmd, seq, payload, len));
+}
+
+/* ── Device output ──────────────────────────────────────────────────────── */
+
+size_t dmt_replies(dmt_reply_t *out, size_t max)
+{
+    size_t n = 0, i = 0;
+
+    while (i < s_out_len && n < max) {
+        size_t start = i;
+        if (s_out[i++] != DM_START_BYTE || i + 4 > s_out_len) goto bad;
+
+        uint8_t ver = s_out[i++];
+        if (ver & DM_VERSION_ADDR_FLAG) i++;   /* Our own address */
+        dmt_reply_t *r = &out[n];
+        r->version = ver & (uint8_t)~DM_VERSION_ADDR_FLAG;
+        r->cmd     = s_out[i++];
+        r->seq     = s_out[i++];
+        r->len     = s_out[i++];
+        if (r->version == DM_PROTOCOL_V2) r->len = (uint16_t)(r->len << 8 | s_out[i++]);
+        if (r->len > DM_MAX_PAYLOAD || i + r->len + DM_CRC_SIZE > s_out_len) goto bad;
+
+        memcpy(r->data, &s_out[i], r->len);
+        i += r->len;
+        uint16_t crc = crc16_ccitt(&s_out[start + 1], i - start - 1);
+        if (s_out[i] != (uint8_t)(crc >> 8) || s_out[i + 1] != (uint8_t)crc) goto bad;
+        i += DM_CRC_SIZE;
+        n++;
+    }
+    memmove(s_out, &s_out[i], s_out_len - i);
+    s_out_len -= i;
+    return n;
+
+bad:
+    fprintf(stderr, "dm_test: malformed device output at byte %zu\n", i);
+    dmt_failures++;
+    s_out_len = 0;
+    return n;
+}
+
+/* ── Results ────────────────────────────────────────────────────────────── */
+
+void dmt_passed(const char *name)
+{
+    printf("%-40s %s\n", name, dmt_failures == s_failures_before ? "ok" : "FAILED");
+    s_failures_before = dmt_failures;
+}
+
+int dmt_report(void)
+{
+    if (dmt_failures) printf("%d check(s) failed\n", dmt_failures);
+    return dmt_failures ? 1 : 0;
+}
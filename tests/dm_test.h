@@ -0,0 +1,112 @@
+/**
+ * @file dm_test.h
+ * @brief Minimal harness for the core tests.
+ *
+ * Each test program links hmic_core against a platform that records
+ * every byte the device sends and runs on a clock the test moves by
+ * hand.  Host frames are built and fed through dm_receive_bytes(); the
+ * recorded output is decoded back into replies for the checks.
+ *
+ *   static void test_ping(void)
+ *   {
+ *       dmt_send(DM_PROTOCOL_V1, CMD_PING, 7, NULL, 0);
+ *       dmt_reply_t r[4];
+ *       DMT_CHECK(dmt_replies(r, 4) == 1 && r[0].cmd == EVT_ACK);
+ *   }
+ *
+ *   int main(void)
+ *   {
+ *       DMT_RUN(test_ping);
+ *       return dmt_report();
+ *   }
+ */
+#ifndef DM_TEST_H
+#define DM_TEST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "dm_config.h"
+#include "dm_platform.h"
+
+/** Bytes of device output kept between dmt_replies() calls. */
+#define DMT_CAPTURE_SIZE 8192
+
+/** One decoded device frame. */
+typedef struct {
+    uint8_t  version;   /**< VERSION without the address flag */
+    uint8_t  cmd;
+    uint8_t  seq;
+    uint16_t len;
+    uint8_t  data[DM_MAX_PAYLOAD];
+} dmt_reply_t;
+
+extern dm_platform_t dmt_platform;   /**< Recording platform given to dm_init() */
+extern uint32_t      dmt_now_ms;     /**< Its millis() (and micros() / 1000) */
+extern int           dmt_failures;
+
+/** Record a failed check without stopping the test. */
+#define DMT_CHECK(cond)                                                   \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,        \
+                    __LINE__, #cond);                                     \
+            dmt_failures++;                                               \
+        }                                                                 \
+    } while (0)
+
+/** Run one test function on a freshly initialised core. */
+#define DMT_RUN(fn)        \
+    do {                   \
+        dmt_reset();       \
+        fn();              \
+        dmt_passed(#fn);   \
+    } while (0)
+
+/**
+ * @brief dm_init() on dmt_platform, with the clock at 0 and no output.
+ */
+void dmt_reset(void);
+
+/**
+ * @brief Build one host frame.
+ *
+ * @param out      Receives the frame (DM_MAX_FRAME_SIZE bytes).
+ * @param version  DM_PROTOCOL_V1 (8-bit LEN) or DM_PROTOCOL_V2 (16-bit LEN).
+ * @param cmd      Command.
+ * @param seq      SEQ_ID.
+ * @param payload  Payload, or NULL when @p len is 0.
+ * @param len      Payload length.
+ * @return Frame length.
+ */
+size_t dmt_frame(uint8_t *out, uint8_t version, uint8_t cmd, uint8_t seq,
+                 const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Build one host frame and hand it to dm_receive_bytes().
+ */
+void dmt_send(uint8_t version, uint8_t cmd, uint8_t seq,
+              const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Decode and consume the device output recorded so far.
+ *
+ * A frame with a bad CRC or an impossible length counts as a failure.
+ *
+ * @param out  Receives up to @p max replies.
+ * @param max  Capacity of @p out.
+ * @return Number of replies decoded.
+ */
+size_t dmt_replies(dmt_reply_t *out, size_t max);
+
+/** @brief Print the result of one DMT_RUN() test. */
+void dmt_passed(const char *name);
+
+/**
+ * @brief Print the summary.
+ * @return Exit status for main(): 0 when every check passed.
+ */
+int dmt_report(void);
+
+#endif /* DM_TEST_H */
@@ -0,0 +1,150 @@
+/**
+ * @file test_parser_rescan.c
+ * @brief Resync after a failed frame: rescan from the next start byte and
+ *        partial frames expired by an idle line (docs/protocol_spec.md §5).
+ */
+#include "dm_test.h"
+#include "dm_core.h"
+#include "dm_protocol.h"
+
+#include <string.h>
+
+/* A PING whose reply carries @p seq. */
+static size_t ping(uint8_t *out, uint8_t seq)
+{
+    return dmt_frame(out, DM_PROTOCOL_V1, CMD_PING, seq, NULL, 0);
+}
+
+/* Exactly one reply, an ACK for @p seq. */
+static void check_acked(uint8_t seq)
+{
+    dmt_reply_t r[4];
+
+    DMT_CHECK(dmt_replies(r, 4) == 1);
+    DMT_CHECK(r[0].cmd == EVT_ACK && r[0].seq == seq);
+}
+
+static dm_stats_t stats(void)
+{
+    dm_stats_t st;
+    dm_get_stats(&st);
+    return st;
+}
+
+/* ── Failed frames ──────────────────────────────────────────────────────── */
+
+static void test_bad_crc_is_dropped(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    size_t n = ping(frame, 1);
+
+    frame[n - 1] ^= 0x01;
+    dm_receive_bytes(frame, n);
+    dm_receive_bytes(frame, ping(frame, 2));
+
+    check_acked(2);
+    DMT_CHECK(stats().frames_crc_err == 1);
+}
+
+static void test_noise_start_byte_before_frame(void)
+{
+    /* The stray 0xAA turns the real start byte into a VERSION byte. */
+    uint8_t buf[1 + DM_MAX_FRAME_SIZE] = { DM_START_BYTE };
+    size_t n = ping(&buf[1], 3);
+
+    dm_receive_bytes(buf, 1 + n);
+
+    check_acked(3);
+    DMT_CHECK(stats().frames_crc_err == 1);
+}
+
+static void test_truncated_frame_before_frame(void)
+{
+    /* A frame aborted after two bytes swallows the header of the next. */
+    uint8_t buf[2 + DM_MAX_FRAME_SIZE] = { DM_START_BYTE, DM_PROTOCOL_V1 };
+    size_t n = ping(&buf[2], 4);
+
+    dm_receive_bytes(buf, 2 + n);
+
+    check_acked(4);
+}
+
+static void test_len_over_max_is_dropped(void)
+{
+    uint8_t bad[] = { DM_START_BYTE, DM_PROTOCOL_V1, CMD_PING, 5, DM_MAX_PAYLOAD + 1 };
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+
+    dm_receive_bytes(bad, sizeof(bad));
+    dm_receive_bytes(frame, ping(frame, 6));
+
+    check_acked(6);
+    DMT_CHECK(stats().frames_len_err == 1);
+}
+
+/* ── Idle line ──────────────────────────────────────────────────────────── */
+
+static void test_partial_frame_expires(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    size_t n = ping(frame, 7);
+
+    DMT_CHECK(dm_rx_write(frame, n - 1) == n - 1);   /* CRC LSB never comes */
+    dm_process();
+    dmt_now_ms += DM_RX_TIMEOUT_MS - 1;
+    dm_process();
+    DMT_CHECK(stats().frames_timeout == 0);
+
+    dmt_now_ms += 1;
+    dm_process();
+    DMT_CHECK(stats().frames_timeout == 1);
+
+    dm_rx_write(frame, ping(frame, 8));
+    dm_process();
+    check_acked(8);
+}
+
+static void test_expired_frame_is_rescanned(void)
+{
+    /* A bogus header claiming 32 bytes takes in the whole real frame. */
+    uint8_t buf[5 + DM_MAX_FRAME_SIZE] = { DM_START_BYTE, DM_PROTOCOL_V1, CMD_PING, 0, 32 };
+    size_t n = ping(&buf[5], 9);
+    dmt_reply_t r[4];
+
+    dm_rx_write(buf, 5 + n);
+    dm_process();
+    DMT_CHECK(dmt_replies(r, 4) == 0);
+
+    dmt_now_ms += DM_RX_TIMEOUT_MS;
+    dm_process();
+    check_acked(9);
+    DMT_CHECK(stats().frames_timeout == 1);
+}
+
+static void test_slow_loop_is_not_idle(void)
+{
+    /* Bytes waiting in the ring count as activity, however late we look. */
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    size_t n = ping(frame, 10);
+
+    dm_rx_write(frame, 3);
+    dmt_now_ms += 10 * DM_RX_TIMEOUT_MS;
+    dm_process();
+    dm_rx_write(&frame[3], n - 3);
+    dmt_now_ms += 10 * DM_RX_TIMEOUT_MS;
+    dm_process();
+
+    check_acked(10);
+    DMT_CHECK(stats().frames_timeout == 0);
+}
+
+int main(void)
+{
+    DMT_RUN(test_bad_crc_is_dropped);
+    DMT_RUN(test_noise_start_byte_before_frame);
+    DMT_RUN(test_truncated_frame_before_frame);
+    DMT_RUN(test_len_over_max_is_dropped);
+    DMT_RUN(test_partial_frame_expires);
+    DMT_RUN(test_expired_frame_is_rescanned);
+    DMT_RUN(test_slow_loop_is_not_idle);
+    return dmt_report();
+}
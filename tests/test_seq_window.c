@@ -0,0 +1,207 @@
+/**
+ * @file test_seq_window.c
+ * @brief Retransmit replay from the sequence window and cumulative ACKs
+ *        (docs/protocol_spec.md §4.1, §4.2).
+ */
+#include "dm_test.h"
+#include "dm_core.h"
+#include "dm_packet.h"
+#include "dm_protocol.h"
+
+#include <string.h>
+
+/* Test command: counts its runs and ACKs with the count (or fails). */
+#define CMD_TEST 0x70
+
+static uint32_t s_runs;
+static uint8_t  s_reply_len;   /* ACK data bytes; 0xFF = NACK */
+
+static void handle_test(uint8_t seq, const uint8_t *p, uint16_t len,
+                        const dm_platform_t *plat)
+{
+    (void)p;
+    (void)len;
+    uint8_t data[DM_SEQ_CACHE_DATA + 1];
+
+    s_runs++;
+    if (s_reply_len == 0xFF) {
+        dm_packet_send_nack(seq, plat);
+        return;
+    }
+    memset(data, (uint8_t)s_runs, sizeof(data));
+    dm_packet_send_ack(seq, plat, data, s_reply_len);
+}
+
+static void setup(uint8_t reply_len)
+{
+    s_runs      = 0;
+    s_reply_len = reply_len;
+    dm_protocol_register(CMD_TEST, handle_test, 0, 8);
+}
+
+/* Feed a prebuilt frame once more, as a host retransmit would. */
+static void resend(const uint8_t *frame, size_t len)
+{
+    dm_receive_bytes(frame, len);
+}
+
+/* ── Replay ─────────────────────────────────────────────────────────────── */
+
+static void test_retransmit_replays_reply(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dmt_reply_t r[4];
+    setup(2);
+
+    size_t n = dmt_frame(frame, DM_PROTOCOL_V1, CMD_TEST, 5, (const uint8_t *)"a", 1);
+    resend(frame, n);
+    resend(frame, n);
+
+    DMT_CHECK(s_runs == 1);
+    DMT_CHECK(dmt_replies(r, 4) == 2);
+    for (int i = 0; i < 2; i++) {
+        DMT_CHECK(r[i].cmd == EVT_ACK && r[i].seq == 5);
+        DMT_CHECK(r[i].len == 2 && r[i].data[0] == 1 && r[i].data[1] == 1);
+    }
+    DMT_CHECK(dm_protocol_dup_count() == 1);
+}
+
+static void test_retransmit_replays_nack(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dmt_reply_t r[4];
+    setup(0xFF);
+
+    size_t n = dmt_frame(frame, DM_PROTOCOL_V1, CMD_TEST, 9, NULL, 0);
+    resend(frame, n);
+    resend(frame, n);
+
+    DMT_CHECK(s_runs == 1);
+    DMT_CHECK(dmt_replies(r, 4) == 2);
+    DMT_CHECK(r[0].cmd == EVT_NACK && r[1].cmd == EVT_NACK && r[1].seq == 9);
+}
+
+static void test_new_command_with_reused_seq_runs(void)
+{
+    dmt_reply_t r[4];
+    setup(1);
+
+    /* Same SEQ_ID, different payload (so a different CRC): a new command. */
+    dmt_send(DM_PROTOCOL_V1, CMD_TEST, 3, (const uint8_t *)"a", 1);
+    dmt_send(DM_PROTOCOL_V1, CMD_TEST, 3, (const uint8_t *)"b", 1);
+
+    DMT_CHECK(s_runs == 2);
+    DMT_CHECK(dmt_replies(r, 4) == 2);
+    DMT_CHECK(r[1].len == 1 && r[1].data[0] == 2);
+    DMT_CHECK(dm_protocol_dup_count() == 0);
+}
+
+static void test_evicted_seq_runs_again(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dmt_reply_t r[DM_SEQ_WINDOW + 4];
+    setup(0);
+
+    size_t n = dmt_frame(frame, DM_PROTOCOL_V1, CMD_TEST, 0, NULL, 0);
+    resend(frame, n);
+    for (uint8_t s = 1; s <= DM_SEQ_WINDOW; s++) {
+        dmt_send(DM_PROTOCOL_V1, CMD_PING, s, NULL, 0);
+    }
+    resend(frame, n);
+
+    DMT_CHECK(s_runs == 2);
+    DMT_CHECK(dmt_replies(r, DM_SEQ_WINDOW + 4) == DM_SEQ_WINDOW + 2);
+}
+
+static void test_long_ack_data_is_not_cached(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dmt_reply_t r[4];
+    setup(DM_SEQ_CACHE_DATA + 1);
+
+    size_t n = dmt_frame(frame, DM_PROTOCOL_V1, CMD_TEST, 1, NULL, 0);
+    resend(frame, n);
+    resend(frame, n);
+
+    DMT_CHECK(s_runs == 2);
+    DMT_CHECK(dmt_replies(r, 4) == 2);
+    DMT_CHECK(r[1].len == DM_SEQ_CACHE_DATA + 1 && r[1].data[0] == 2);
+}
+
+/* ── Cumulative ACKs ────────────────────────────────────────────────────── */
+
+static void set_cumulative(void)
+{
+    uint8_t mode = DM_ACK_MODE_CUMULATIVE;
+    dmt_reply_t r[2];
+
+    dmt_send(DM_PROTOCOL_V1, CMD_SET_ACK_MODE, 0, &mode, 1);
+    dm_process();
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].cmd == EVT_ACK);
+}
+
+static void test_ack_range_covers_one_tick(void)
+{
+    dmt_reply_t r[4];
+    set_cumulative();
+
+    for (uint8_t s = 10; s < 14; s++) dmt_send(DM_PROTOCOL_V1, CMD_PING, s, NULL, 0);
+    DMT_CHECK(dmt_replies(r, 4) == 0);   /* Held until the end of the tick */
+    dm_process();
+
+    DMT_CHECK(dmt_replies(r, 4) == 1);
+    DMT_CHECK(r[0].cmd == EVT_ACK_RANGE && r[0].seq == 10);
+    DMT_CHECK(r[0].len == 2 && r[0].data[0] == 10 && r[0].data[1] == 4);
+}
+
+static void test_ack_range_keeps_wire_order(void)
+{
+    dmt_reply_t r[8];
+    set_cumulative();
+    setup(1);
+
+    /* ACK, ACK, NACK (unknown), ACK with data, ACK: ranges never jump a reply. */
+    dmt_send(DM_PROTOCOL_V1, CMD_PING, 20, NULL, 0);
+    dmt_send(DM_PROTOCOL_V1, CMD_PING, 21, NULL, 0);
+    dmt_send(DM_PROTOCOL_V1, 0x7F, 22, NULL, 0);
+    dmt_send(DM_PROTOCOL_V1, CMD_TEST, 23, NULL, 0);
+    dmt_send(DM_PROTOCOL_V1, CMD_PING, 24, NULL, 0);
+    dm_process();
+
+    DMT_CHECK(dmt_replies(r, 8) == 4);
+    DMT_CHECK(r[0].cmd == EVT_ACK_RANGE && r[0].data[0] == 20 && r[0].data[1] == 2);
+    DMT_CHECK(r[1].cmd == EVT_NACK && r[1].seq == 22);
+    DMT_CHECK(r[2].cmd == EVT_ACK && r[2].seq == 23 && r[2].len == 1);
+    DMT_CHECK(r[3].cmd == EVT_ACK_RANGE && r[3].data[0] == 24 && r[3].data[1] == 1);
+}
+
+static void test_retransmit_in_cumulative_mode(void)
+{
+    uint8_t frame[DM_MAX_FRAME_SIZE];
+    dmt_reply_t r[4];
+    set_cumulative();
+    setup(0);
+
+    size_t n = dmt_frame(frame, DM_PROTOCOL_V1, CMD_TEST, 30, NULL, 0);
+    resend(frame, n);
+    dm_process();
+    resend(frame, n);
+    dm_process();
+
+    DMT_CHECK(s_runs == 1);
+    DMT_CHECK(dmt_replies(r, 4) == 2);
+    DMT_CHECK(r[1].cmd == EVT_ACK_RANGE && r[1].data[0] == 30 && r[1].data[1] == 1);
+}
+
+int main(void)
+{
+    DMT_RUN(test_retransmit_replays_reply);
+    DMT_RUN(test_retransmit_replays_nack);
+    DMT_RUN(test_new_command_with_reused_seq_runs);
+    DMT_RUN(test_evicted_seq_runs_again);
+    DMT_RUN(test_long_ack_data_is_not_cached);
+    DMT_RUN(test_ack_range_covers_one_tick);
+    DMT_RUN(test_ack_range_keeps_wire_order);
+    DMT_RUN(test_retransmit_in_cumulative_mode);
+    return dmt_report();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file test_ui_dirty.c
+ * @brief ui_pages dirty list: each widget is queued at most once per flush,
+ *        however often its page is freed and rebuilt in between.
+ *
+ * Runs LVGL without a render loop, as hmic_sim --no-render does: nothing
+ * calls lv_timer_handler(), so only ui_pages_flush() empties the list.
+ */
+#include "dm_test.h"
+#include "ui/ui_pages.h"
+#include "ui/ui_layout.h"
+#include "lvgl.h"
+
+/* The built-in layout, freshly loaded: page 0 shown, nothing dirty. */
+static void setup(void)
+{
+    DMT_CHECK(ui_pages_load_layout(ui_layout_default, ui_layout_default_size));
+    ui_pages_flush();
+    DMT_CHECK(ui_pages_dirty_count() == 0);
+}
+
+static void set_all_visible(bool visible)
+{
+    for (uint8_t i = 0; i < ui_pages_widget_count(); i++) ui_pages_set_visible(i, visible);
+}
+
+static void test_rebuilt_page_is_listed_once(void)
+{
+    setup();
+    DMT_CHECK(ui_pages_widget_count() > 0);
+
+    /* Each build applies (and clears) the shadow of widgets still listed. */
+    for (int round = 0; round < 2 * DM_MAX_WIDGETS; round++) {
+        set_all_visible(round & 1);
+        DMT_CHECK(ui_pages_show(1));
+        DMT_CHECK(ui_pages_show(0));
+        ui_pages_reclaim();
+        DMT_CHECK(ui_pages_dirty_count() <= ui_pages_widget_count());
+    }
+    ui_pages_flush();
+    DMT_CHECK(ui_pages_dirty_count() == 0);
+}
+
+static void test_flush_lists_again(void)
+{
+    setup();
+
+    ui_pages_set_visible(0, false);
+    ui_pages_set_visible(0, true);
+    DMT_CHECK(ui_pages_dirty_count() == 1);
+    ui_pages_flush();
+    ui_pages_set_visible(0, false);
+    DMT_CHECK(ui_pages_dirty_count() == 1);
+}
+
+int main(void)
+{
+    lv_init();
+    lv_display_create(320, 240);
+    ui_pages_init();
+
+    DMT_RUN(test_rebuilt_page_is_listed_once);
+    DMT_RUN(test_flush_lists_again);
+    return dmt_report();
+}
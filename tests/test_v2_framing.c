@@ -0,0 +1,162 @@
+/**
+ * @file test_v2_framing.c
+ * @brief CMD_GET_CAPS negotiation and the v2 16-bit PAYLOAD_LEN
+ *        (docs/protocol_spec.md §1.1, §2.1).
+ */
+#include "dm_test.h"
+#include "dm_core.h"
+#include "dm_packet.h"
+#include "dm_protocol.h"
+
+#include <string.h>
+
+/* Test command: remembers the payload length, ACKs with s_reply_len bytes. */
+#define CMD_TEST 0x70
+
+static uint16_t s_got_len;
+static uint16_t s_reply_len;
+
+static void handle_test(uint8_t seq, const uint8_t *p, uint16_t len,
+                        const dm_platform_t *plat)
+{
+    (void)p;
+    uint8_t data[DM_MAX_PAYLOAD];
+
+    s_got_len = len;
+    memset(data, 0x5A, sizeof(data));
+    dm_packet_send_ack(seq, plat, data, s_reply_len);
+}
+
+static void setup(uint16_t reply_len)
+{
+    s_got_len   = 0xFFFF;
+    s_reply_len = reply_len;
+    dm_protocol_register(CMD_TEST, handle_test, 0, DM_MAX_PAYLOAD);
+}
+
+/* CMD_GET_CAPS [version][max_payload]; returns the decoded reply. */
+static dmt_reply_t negotiate(uint8_t version, uint16_t max_payload)
+{
+    uint8_t req[3] = { version, (uint8_t)(max_payload >> 8), (uint8_t)max_payload };
+    dmt_reply_t r[2];
+
+    memset(r, 0, sizeof(r));
+    dmt_send(DM_PROTOCOL_V1, CMD_GET_CAPS, 1, req, sizeof(req));
+    DMT_CHECK(dmt_replies(r, 2) == 1);
+    return r[0];
+}
+
+/* Version the device frames its next reply in. */
+static uint8_t reply_version(uint8_t host_version)
+{
+    dmt_reply_t r[2];
+
+    r[0].version = 0;
+    dmt_send(host_version, CMD_PING, 2, NULL, 0);
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].cmd == EVT_ACK);
+    return r[0].version;
+}
+
+/* ── Negotiation ────────────────────────────────────────────────────────── */
+
+static void test_caps_reply_uses_old_framing(void)
+{
+    dmt_reply_t r = negotiate(DM_PROTOCOL_V2, DM_MAX_PAYLOAD);
+
+    DMT_CHECK(r.cmd == EVT_ACK && r.version == DM_PROTOCOL_V1 && r.len == 6);
+    DMT_CHECK(r.data[0] == DM_PROTOCOL_V2);
+    DMT_CHECK((r.data[1] << 8 | r.data[2]) == DM_MAX_PAYLOAD);
+    DMT_CHECK(r.data[5] == DM_SEQ_WINDOW);
+    DMT_CHECK(reply_version(DM_PROTOCOL_V2) == DM_PROTOCOL_V2);
+}
+
+static void test_empty_caps_changes_nothing(void)
+{
+    dmt_reply_t r[2];
+
+    dmt_send(DM_PROTOCOL_V1, CMD_GET_CAPS, 1, NULL, 0);
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].data[0] == DM_PROTOCOL_VERSION);
+    DMT_CHECK(reply_version(DM_PROTOCOL_V2) == DM_PROTOCOL_V1);
+}
+
+static void test_v1_frame_switches_back(void)
+{
+    negotiate(DM_PROTOCOL_V2, DM_MAX_PAYLOAD);
+
+    DMT_CHECK(reply_version(DM_PROTOCOL_V1) == DM_PROTOCOL_V1);
+    DMT_CHECK(reply_version(DM_PROTOCOL_V2) == DM_PROTOCOL_V1);
+}
+
+/* ── Payload limit ──────────────────────────────────────────────────────── */
+
+static void test_agreed_max_truncates_replies(void)
+{
+    dmt_reply_t r[2];
+    setup(DM_STATS_WIRE_FIELDS * 4 + 10);
+
+    dmt_reply_t caps = negotiate(DM_PROTOCOL_V2, DM_STATS_WIRE_FIELDS * 4);
+    DMT_CHECK(caps.cmd == EVT_ACK && (caps.data[1] << 8 | caps.data[2]) == DM_STATS_WIRE_FIELDS * 4);
+
+    dmt_send(DM_PROTOCOL_V2, CMD_TEST, 3, NULL, 0);
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].len == DM_STATS_WIRE_FIELDS * 4);
+}
+
+static void test_tiny_max_payload_is_nacked(void)
+{
+    dmt_reply_t r[2];
+
+    /* On v1 nothing would reset the limit again: every reply stays cut. */
+    dmt_reply_t caps = negotiate(DM_PROTOCOL_V1, 0);
+    DMT_CHECK(caps.cmd == EVT_NACK);
+
+    /* The link is unchanged: full-size replies. */
+    dmt_send(DM_PROTOCOL_V1, CMD_GET_STATS, 4, NULL, 0);
+    DMT_CHECK(dmt_replies(r, 2) == 1);
+    DMT_CHECK(r[0].version == DM_PROTOCOL_V1 && r[0].len == DM_STATS_WIRE_FIELDS * 4);
+    DMT_CHECK(dm_packet_max_payload() >= DM_STATS_WIRE_FIELDS * 4);
+}
+
+/* ── 16-bit PAYLOAD_LEN ─────────────────────────────────────────────────── */
+
+static void test_v2_len_reads_both_bytes(void)
+{
+    uint8_t payload[DM_MAX_PAYLOAD];
+    dmt_reply_t r[2];
+    setup(0);
+
+    memset(payload, 0x11, sizeof(payload));
+    negotiate(DM_PROTOCOL_V2, DM_MAX_PAYLOAD);
+    dmt_send(DM_PROTOCOL_V2, CMD_TEST, 5, payload, DM_MAX_PAYLOAD);
+
+    DMT_CHECK(s_got_len == DM_MAX_PAYLOAD);
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].version == DM_PROTOCOL_V2 && r[0].seq == 5);
+}
+
+static void test_v2_len_over_max_is_dropped(void)
+{
+    /* LEN_H alone puts this past DM_MAX_PAYLOAD; the device must resync. */
+    uint8_t bad[] = { DM_START_BYTE, DM_PROTOCOL_V2, CMD_TEST, 6, 0x01, 0x00, 0, 0 };
+    dmt_reply_t r[2];
+    dm_stats_t st;
+    setup(0);
+
+    dm_receive_bytes(bad, sizeof(bad));
+    dm_get_stats(&st);
+    DMT_CHECK(s_got_len == 0xFFFF && st.frames_len_err == 1);
+
+    dmt_send(DM_PROTOCOL_V2, CMD_TEST, 7, NULL, 0);
+    DMT_CHECK(s_got_len == 0);
+    DMT_CHECK(dmt_replies(r, 2) == 1 && r[0].seq == 7);
+}
+
+int main(void)
+{
+    DMT_RUN(test_caps_reply_uses_old_framing);
+    DMT_RUN(test_empty_caps_changes_nothing);
+    DMT_RUN(test_v1_frame_switches_back);
+    DMT_RUN(test_agreed_max_truncates_replies);
+    DMT_RUN(test_tiny_max_payload_is_nacked);
+    DMT_RUN(test_v2_len_reads_both_bytes);
+    DMT_RUN(test_v2_len_over_max_is_dropped);
+    return dmt_report();
+}
@@ -6,11 +6,13 @@ A command-line tool for testing the hmic Display Manager firmware from a PC.
 
 Supports:
   - Serial port (UART / RS485 via USB adapter)
+  - The simulator's pty or TCP socket (--port socket://localhost:7000)
   - Loopback mode (no hardware required – for unit-testing the encoder/decoder)
 
 Usage:
   python3 host_tester.py --port /dev/ttyUSB0 --baud 115200
   python3 host_tester.py --port /dev/ttyUSB0 --test all
+  python3 host_tester.py --port socket://localhost:7000 --test pipeline
   python3 host_tester.py --loopback   # offline frame encode/decode test
 """
 
@@ -25,18 +27,38 @@ from typing import Optional
 # ── Protocol constants ─────────────────────────────────────────────────────
 
 START_BYTE       = 0xAA
-PROTOCOL_VERSION = 0x01
+PROTOCOL_VERSION = 0x01      # framing until CMD_GET_CAPS agrees on v2
+PROTOCOL_V2      = 0x02
+VERSION_ADDR_FLAG = 0x80     # VERSION bit: an ADDRESS byte follows
+ADDR_BROADCAST   = 0xFF      # every panel acts, none answers
+HOST_MAX_PAYLOAD = 1024
+ACK_KEEP         = 16        # ACKs kept for wait_ack(): the last N seqs sent
 
 # Commands (host → device)
 CMD_PING              = 0x01
 CMD_GET_VERSION       = 0x02
 CMD_RESET             = 0x03
 CMD_ENTER_BOOTLOADER  = 0x04
+CMD_SET_ACK_MODE      = 0x05
+CMD_GET_CAPS          = 0x06
+CMD_GET_STATS         = 0x07
+CMD_GET_TRACE         = 0x08
+CMD_GET_STATE_HASH    = 0x09
 CMD_SHOW_PAGE         = 0x10
 CMD_SET_TEXT          = 0x20
 CMD_SET_VALUE         = 0x21
 CMD_SET_VISIBLE       = 0x22
 CMD_SET_ENABLED       = 0x23
+CMD_SET_VALUES        = 0x24
+CMD_DEFINE_STRING     = 0x25
+CMD_SET_TEXT_ID       = 0x26
+CMD_BATCH             = 0x30
+CMD_LAYOUT_WRITE      = 0x40
+CMD_LAYOUT_APPLY      = 0x41
+CMD_BULK_OPEN         = 0x50
+CMD_BULK_CHUNK        = 0x51
+CMD_BULK_COMMIT       = 0x52
+CMD_BULK_ABORT        = 0x53
 
 # Events (device → host)
 EVT_BUTTON_PRESSED    = 0x80
@@ -45,23 +67,64 @@ EVT_PAGE_CHANGED      = 0x82
 EVT_TOUCH_EVENT       = 0x83
 EVT_ACK               = 0xF0
 EVT_NACK              = 0xF1
+EVT_ACK_RANGE         = 0xF2
+
+ACK_MODE_EACH         = 0
+ACK_MODE_CUMULATIVE   = 1
+
+VALUES_ABSOLUTE       = 0
+VALUES_DELTA          = 1
+
+RES_TYPE_RAW          = 0
+RES_TYPE_IMAGE        = 1
+RES_TYPE_FONT         = 2
+
+# CMD_GET_CAPS feature bits
+FEAT_BATCH            = 0x0001
+FEAT_SEQ_WINDOW       = 0x0002
+FEAT_BULK             = 0x0004
+FEAT_LAYOUT           = 0x0008
+FEAT_TRACE            = 0x0010
+FEAT_SET_VALUES       = 0x0020
+FEAT_STRINGS          = 0x0040
+FEAT_STATE_HASH       = 0x0080
+
+# CMD_GET_STATE_HASH flags
+STATE_RESTORED        = 0x01
+STATE_SAVED           = 0x02
 
 CMD_NAMES = {
     CMD_PING: "CMD_PING",
     CMD_GET_VERSION: "CMD_GET_VERSION",
     CMD_RESET: "CMD_RESET",
     CMD_ENTER_BOOTLOADER: "CMD_ENTER_BOOTLOADER",
+    CMD_SET_ACK_MODE: "CMD_SET_ACK_MODE",
+    CMD_GET_CAPS: "CMD_GET_CAPS",
+    CMD_GET_STATS: "CMD_GET_STATS",
+    CMD_GET_TRACE: "CMD_GET_TRACE",
+    CMD_GET_STATE_HASH: "CMD_GET_STATE_HASH",
     CMD_SHOW_PAGE: "CMD_SHOW_PAGE",
     CMD_SET_TEXT: "CMD_SET_TEXT",
     CMD_SET_VALUE: "CMD_SET_VALUE",
     CMD_SET_VISIBLE: "CMD_SET_VISIBLE",
     CMD_SET_ENABLED: "CMD_SET_ENABLED",
+    CMD_SET_VALUES: "CMD_SET_VALUES",
+    CMD_DEFINE_STRING: "CMD_DEFINE_STRING",
+    CMD_SET_TEXT_ID: "CMD_SET_TEXT_ID",
+    CMD_BATCH: "CMD_BATCH",
+    CMD_LAYOUT_WRITE: "CMD_LAYOUT_WRITE",
+    CMD_LAYOUT_APPLY: "CMD_LAYOUT_APPLY",
+    CMD_BULK_OPEN: "CMD_BULK_OPEN",
+    CMD_BULK_CHUNK: "CMD_BULK_CHUNK",
+    CMD_BULK_COMMIT: "CMD_BULK_COMMIT",
+    CMD_BULK_ABORT: "CMD_BULK_ABORT",
     EVT_BUTTON_PRESSED: "EVT_BUTTON_PRESSED",
     EVT_SLIDER_CHANGED: "EVT_SLIDER_CHANGED",
     EVT_PAGE_CHANGED: "EVT_PAGE_CHANGED",
     EVT_TOUCH_EVENT: "EVT_TOUCH_EVENT",
     EVT_ACK: "EVT_ACK",
     EVT_NACK: "EVT_NACK",
+    EVT_ACK_RANGE: "EVT_ACK_RANGE",
 }
 
 # ── CRC16-CCITT ────────────────────────────────────────────────────────────
@@ -80,13 +143,34 @@ def crc16_ccitt(data: bytes) -> int:
 
 # ── Frame encoder ───────────────────────────────────────────────────────────
 
-def build_frame(cmd: int, seq: int, payload: bytes = b"") -> bytes:
-    """Build a complete wire frame."""
-    header = bytes([PROTOCOL_VERSION, cmd, seq & 0xFF, len(payload)])
+def build_frame(cmd: int, seq: int, payload: bytes = b"",
+                version: int = PROTOCOL_VERSION,
+                address: Optional[int] = None) -> bytes:
+    """Build a complete wire frame (v2 carries a 16-bit length).
+
+    With `address` set the frame goes to one panel on a multi-drop bus
+    (or to all of them with ADDR_BROADCAST).
+    """
+    if address is None:
+        header = bytes([version])
+    else:
+        header = bytes([version | VERSION_ADDR_FLAG, address & 0xFF])
+    header += bytes([cmd, seq & 0xFF])
+    if version == PROTOCOL_V2:
+        header += struct.pack(">H", len(payload))
+    else:
+        header += bytes([len(payload)])
     body   = header + payload
     crc    = crc16_ccitt(body)
     return bytes([START_BYTE]) + body + bytes([crc >> 8, crc & 0xFF])
 
+def build_batch(commands) -> bytes:
+    """Pack [(cmd, payload), ...] into a CMD_BATCH payload."""
+    out = bytearray()
+    for cmd, payload in commands:
+        out += bytes([cmd, len(payload)]) + payload
+    return bytes(out)
+
 # ── Frame decoder ────────────────────────────────────────────────────────────
 
 class FrameDecoder:
@@ -100,6 +184,8 @@ class FrameDecoder:
     PAYLOAD    = 5
     CRC_HIGH   = 6
     CRC_LOW    = 7
+    LENGTH_HIGH = 8
+    ADDRESS    = 9
 
     def __init__(self, on_frame):
         self._state    = self.WAIT_START
@@ -107,6 +193,7 @@ class FrameDecoder:
         self._payload  = bytearray()
         self._crc_acc  = 0xFFFF
         self._crc_high = 0
+        self._len_high = 0
         self._on_frame = on_frame
 
     def feed(self, byte: int):
@@ -117,7 +204,12 @@ class FrameDecoder:
                 self._crc_acc  = 0xFFFF
                 self._state    = self.VERSION
         elif s == self.VERSION:
-            self._frame["version"] = byte
+            self._frame["version"] = byte & ~VERSION_ADDR_FLAG
+            self._frame["address"] = None
+            self._crc_acc = self._update_crc(self._crc_acc, byte)
+            self._state = self.ADDRESS if byte & VERSION_ADDR_FLAG else self.COMMAND
+        elif s == self.ADDRESS:
+            self._frame["address"] = byte
             self._crc_acc = self._update_crc(self._crc_acc, byte)
             self._state = self.COMMAND
         elif s == self.COMMAND:
@@ -127,11 +219,17 @@ class FrameDecoder:
         elif s == self.SEQ_ID:
             self._frame["seq"] = byte
             self._crc_acc = self._update_crc(self._crc_acc, byte)
+            self._len_high = 0
+            self._state = (self.LENGTH_HIGH if self._frame["version"] == PROTOCOL_V2
+                           else self.LENGTH)
+        elif s == self.LENGTH_HIGH:
+            self._len_high = byte
+            self._crc_acc = self._update_crc(self._crc_acc, byte)
             self._state = self.LENGTH
         elif s == self.LENGTH:
-            self._frame["length"] = byte
+            self._frame["length"] = (self._len_high << 8) | byte
             self._crc_acc = self._update_crc(self._crc_acc, byte)
-            self._state = self.PAYLOAD if byte > 0 else self.CRC_HIGH
+            self._state = self.PAYLOAD if self._frame["length"] > 0 else self.CRC_HIGH
         elif s == self.PAYLOAD:
             self._payload.append(byte)
             self._crc_acc = self._update_crc(self._crc_acc, byte)
@@ -162,7 +260,8 @@ class FrameDecoder:
 def fmt_frame(frame: dict) -> str:
     cmd_name = CMD_NAMES.get(frame["command"], f"0x{frame['command']:02X}")
     payload_hex = frame["payload"].hex(" ") if frame["payload"] else "(empty)"
-    return (f"cmd={cmd_name:22s} seq={frame['seq']:3d} "
+    addr = "" if frame.get("address") is None else f"addr={frame['address']:3d} "
+    return (f"{addr}cmd={cmd_name:22s} seq={frame['seq']:3d} "
             f"payload=[{payload_hex}]")
 
 def on_rx_frame(frame: dict):
@@ -173,31 +272,140 @@ def on_rx_frame(frame: dict):
 class HostSession:
     def __init__(self, port: Optional[str], baud: int):
         self._seq     = 0
-        self._decoder = FrameDecoder(on_rx_frame)
+        self._decoder = FrameDecoder(self._on_rx_frame)
         self._ser     = None
         self._running = False
+        self._inflight = {}                 # seq -> [frame, sent_at, tries]
+        self._acks     = {}                 # seq -> ACK payload
+        self.version   = PROTOCOL_VERSION   # framing for outgoing frames
+        self.address   = None               # panel on a multi-drop bus
+        self.max_payload = 255
+        self._cond     = threading.Condition()
 
         if port:
-            self._ser = serial.Serial(port, baud, timeout=0)
+            # Accepts device paths and pyserial URLs (socket://host:port).
+            self._ser = serial.serial_for_url(port, baud, timeout=0)
             print(f"[+] Connected to {port} @ {baud}")
         else:
             print("[+] Loopback mode (no serial port)")
 
-    def send(self, cmd: int, payload: bytes = b"") -> int:
-        """Send a command and return the sequence ID used."""
-        seq   = self._seq
-        frame = build_frame(cmd, seq, payload)
+    def send(self, cmd: int, payload: bytes = b"",
+             address: Optional[int] = None) -> int:
+        """Send a command and return the sequence ID used.
+
+        `address` overrides self.address for this frame (e.g. ADDR_BROADCAST,
+        which no panel answers).
+        """
+        seq   = self._next_seq()
+        frame = build_frame(cmd, seq, payload, self.version,
+                            self.address if address is None else address)
         print(f"\033[33m[TX]\033[0m cmd={CMD_NAMES.get(cmd, f'0x{cmd:02X}'):22s} "
               f"seq={seq:3d} payload=[{payload.hex(' ') if payload else '(empty)'}]")
         print(f"     raw: {frame.hex(' ')}")
+        self._write(frame)
+        return seq
+
+    def _next_seq(self) -> int:
+        """Take the next SEQ_ID and drop ACKs a reply can no longer match.
+
+        The ACK an earlier use of this seq got (256 commands ago) must not
+        answer wait_ack() for the new command.
+        """
+        with self._cond:
+            seq = self._seq
+            self._seq = (seq + 1) & 0xFF
+            self._acks.pop(seq, None)
+            for old in [s for s in self._acks if (seq - s) & 0xFF >= ACK_KEEP]:
+                del self._acks[old]
+            return seq
+
+    def _write(self, frame: bytes):
         if self._ser:
             self._ser.write(frame)
         else:
             # Loopback: decode our own frame
             for b in frame:
                 self._decoder.feed(b)
-        self._seq = (self._seq + 1) & 0xFF
-        return seq
+
+    def _on_rx_frame(self, frame: dict):
+        on_rx_frame(frame)
+        cmd, seq = frame["command"], frame["seq"]
+        with self._cond:
+            if cmd in (EVT_ACK, EVT_NACK):
+                self._inflight.pop(seq, None)
+                # Only replies to the last ACK_KEEP seqs sent are kept.
+                if cmd == EVT_ACK and (self._seq - 1 - seq) & 0xFF < ACK_KEEP:
+                    self._acks[seq] = frame["payload"]
+            elif cmd == EVT_ACK_RANGE and len(frame["payload"]) >= 2:
+                first, count = frame["payload"][0], frame["payload"][1]
+                for i in range(count):
+                    self._inflight.pop((first + i) & 0xFF, None)
+            self._cond.notify_all()
+
+    def send_pipelined(self, commands, window: int = 8,
+                       timeout: float = 0.25, retries: int = 3) -> int:
+        """
+        Send [(cmd, payload), ...] keeping up to `window` frames in flight.
+
+        Unanswered frames are retransmitted unchanged (same SEQ_ID and CRC)
+        after `timeout`; the device answers a retransmit from its seq window
+        without re-running the command.  Returns the number of commands
+        that were never acknowledged.  `window` must not exceed the
+        device's DM_SEQ_WINDOW.
+        """
+        pending = list(commands)
+        failed  = 0
+        with self._cond:
+            while pending or self._inflight:
+                while pending and len(self._inflight) < window:
+                    cmd, payload = pending.pop(0)
+                    seq   = self._next_seq()
+                    frame = build_frame(cmd, seq, payload, self.version,
+                                        self.address)
+                    self._inflight[seq] = [frame, time.monotonic(), 1]
+                    self._write(frame)
+                if not self._ser:
+                    self._inflight.clear()      # loopback: nobody answers
+                    continue
+                self._cond.wait(timeout / 4)
+                now = time.monotonic()
+                for seq, entry in list(self._inflight.items()):
+                    frame, sent_at, tries = entry
+                    if now - sent_at < timeout:
+                        continue
+                    if tries > retries:
+                        print(f"[!] seq={seq} unacknowledged, giving up")
+                        del self._inflight[seq]
+                        failed += 1
+                        continue
+                    entry[1], entry[2] = now, tries + 1
+                    self._write(frame)
+        return failed
+
+    def wait_ack(self, seq: int, timeout: float = 0.5) -> Optional[bytes]:
+        """Wait for the ACK of `seq` and return its payload (None if none)."""
+        deadline = time.monotonic() + timeout
+        with self._cond:
+            while seq not in self._acks:
+                left = deadline - time.monotonic()
+                if left <= 0 or not self._ser:
+                    return None
+                self._cond.wait(left)
+            return self._acks.pop(seq)
+
+    def negotiate(self, version: int = PROTOCOL_V2,
+                  max_payload: int = HOST_MAX_PAYLOAD) -> bool:
+        """CMD_GET_CAPS: agree on framing and payload size with the device."""
+        seq  = self.send(CMD_GET_CAPS, struct.pack(">BH", version, max_payload))
+        caps = self.wait_ack(seq)
+        if caps is None or len(caps) < 6:
+            print("[!] no CMD_GET_CAPS reply – staying on v1")
+            return False
+        ver, max_pl, feat, window = struct.unpack(">BHHB", caps[:6])
+        self.version, self.max_payload = ver, max_pl
+        print(f"[+] v{ver}, max payload {max_pl}, features {feat:#06x}, "
+              f"seq window {window}")
+        return True
 
     def start_rx(self):
         """Start background RX thread (serial mode only)."""
@@ -231,6 +439,46 @@ def test_get_version(s: HostSession):
     s.send(CMD_GET_VERSION)
     time.sleep(0.2)
 
+STATS_FIELDS = ("rx_bytes", "frames_ok", "frames_crc_err", "frames_len_err",
+                "frames_timeout", "frames_skipped", "rx_overflows", "rx_ring_peak",
+                "tx_bytes", "tx_dropped", "tx_queue_peak", "nacks", "duplicates",
+                "dispatch_count", "dispatch_min_us", "dispatch_avg_us", "dispatch_max_us",
+                "render_count", "render_min_us", "render_avg_us", "render_max_us")
+
+def test_get_stats(s: HostSession, clear: bool = False):
+    print("\n--- GET_STATS ---")
+    data = s.wait_ack(s.send(CMD_GET_STATS, bytes([1 if clear else 0])))
+    if data is None:
+        time.sleep(0.2)
+        return
+    n = min(len(data) // 4, len(STATS_FIELDS))
+    for name, value in zip(STATS_FIELDS, struct.unpack(f">{n}I", data[:n * 4])):
+        print(f"  {name:16s} {value}")
+
+TRACE_EVENTS = {1: "FRAME_RX", 2: "DISPATCH_BEGIN", 3: "DISPATCH_END",
+                4: "TX_START", 5: "TX_END", 6: "RENDER_BEGIN", 7: "RENDER_END"}
+
+def dump_trace(s: HostSession):
+    """Page through the device trace ring (firmware built with DM_TRACE_DEPTH)."""
+    print("\n--- TRACE ---")
+    start, prev = None, None
+    while True:
+        data = s.wait_ack(s.send(CMD_GET_TRACE, struct.pack(">I", start or 0)))
+        if data is None or len(data) < 8:
+            print("[!] no trace reply (DM_TRACE_DEPTH = 0?)")
+            return
+        head, first = struct.unpack(">II", data[:8])
+        entries = [struct.unpack(">IBBH", data[i:i + 8])
+                   for i in range(8, len(data) - 7, 8)]
+        for t_us, event, arg, value in entries:
+            delta = "" if prev is None else f"+{(t_us - prev) & 0xFFFFFFFF}"
+            print(f"  {t_us:10d} {delta:>8s}  {TRACE_EVENTS.get(event, event):14} "
+                  f"{arg:3d} {value:5d}")
+            prev = t_us
+        start = first + len(entries)
+        if not entries or start >= head:
+            return
+
 def test_show_page(s: HostSession, page_id: int = 1):
     print(f"\n--- SHOW_PAGE {page_id} ---")
     s.send(CMD_SHOW_PAGE, bytes([page_id]))
@@ -248,10 +496,121 @@ def test_set_value(s: HostSession, widget: int = 4, value: int = 75):
     s.send(CMD_SET_VALUE, payload)
     time.sleep(0.2)
 
+def test_set_values(s: HostSession, first: int = 3):
+    print(f"\n--- SET_VALUES from widget {first}: absolute, then delta ---")
+    # Widget 3 is a label and is skipped; 4 is the slider.
+    s.send(CMD_SET_VALUES, bytes([first, VALUES_ABSOLUTE]) + struct.pack(">hh", 0, 60))
+    time.sleep(0.2)
+    s.send(CMD_SET_VALUES, bytes([first, VALUES_DELTA]) + struct.pack(">bb", 0, -15))
+    time.sleep(0.2)
+
+def define_strings(s: HostSession, strings):
+    """Preload the string table: strings[i] becomes string id i."""
+    print(f"\n--- DEFINE {len(strings)} strings ---")
+    cmds = [(CMD_DEFINE_STRING, bytes([i]) + t.encode("utf-8"))
+            for i, t in enumerate(strings)]
+    failed = s.send_pipelined(cmds)
+    if failed:
+        print(f"[!] {failed} string(s) not stored")
+
+def test_strings(s: HostSession, widget: int = 1):
+    define_strings(s, ["Idle", "Running", "Fault"])
+    print(f"\n--- SET_TEXT_ID widget={widget}, cycling ids 0..2 ---")
+    for i in (0, 1, 2, 0):
+        s.send(CMD_SET_TEXT_ID, bytes([widget, i]))
+        time.sleep(0.1)
+
+def get_state_hash(s: HostSession):
+    """Return (hash, flags) of the device's host-set screen state, or None."""
+    data = s.wait_ack(s.send(CMD_GET_STATE_HASH))
+    if data is None or len(data) < 5:
+        return None
+    return struct.unpack(">IB", data[:5])
+
+def test_state_hash(s: HostSession, widget: int = 0):
+    print("\n--- STATE_HASH (changes with the screen, returns with it) ---")
+    s.send(CMD_SET_TEXT, bytes([widget]) + b"State A")
+    before = get_state_hash(s)
+    if before is None:
+        print("[!] no state hash reply")
+        return
+    s.send(CMD_SET_TEXT, bytes([widget]) + b"State B")
+    changed = get_state_hash(s)
+    s.send(CMD_SET_TEXT, bytes([widget]) + b"State A")
+    back = get_state_hash(s)
+    for name, (h, flags) in (("A", before), ("B", changed), ("A again", back)):
+        names = [n for n, bit in (("restored", STATE_RESTORED), ("saved", STATE_SAVED))
+                 if flags & bit]
+        print(f"  {name:8s} {h:08x} {' '.join(names)}")
+    ok = changed and back and changed[0] != before[0] and back[0] == before[0]
+    print("[+] hash follows the screen" if ok else "[!] hash did not follow the screen")
+
+def test_batch(s: HostSession):
+    print("\n--- BATCH (3 sub-commands, expect one ACK [03 07]) ---")
+    payload = build_batch([
+        (CMD_SET_TEXT,  bytes([1]) + b"Batched"),
+        (CMD_SET_VALUE, bytes([4]) + struct.pack(">h", 25)),
+        (CMD_SHOW_PAGE, bytes([1])),
+    ])
+    s.send(CMD_BATCH, payload)
+    time.sleep(0.3)
+
+def test_pipelined(s: HostSession, count: int = 64, window: int = 8):
+    print(f"\n--- PIPELINED {count} x SET_VALUE, window={window} ---")
+    s.send(CMD_SET_ACK_MODE, bytes([ACK_MODE_CUMULATIVE]))
+    time.sleep(0.1)
+    cmds = [(CMD_SET_VALUE, bytes([4]) + struct.pack(">h", i % 101))
+            for i in range(count)]
+    t0 = time.monotonic()
+    failed = s.send_pipelined(cmds, window=window)
+    dt = time.monotonic() - t0
+    print(f"[+] {count - failed}/{count} acknowledged in {dt * 1000:.1f} ms")
+    s.send(CMD_SET_ACK_MODE, bytes([ACK_MODE_EACH]))
+    time.sleep(0.1)
+
+def upload_layout(s: HostSession, blob: bytes, chunk: int = 120):
+    """Write a layout blob (from layout_tool.py) in chunks, then apply it."""
+    print(f"\n--- LAYOUT UPLOAD {len(blob)} bytes ---")
+    cmds = [(CMD_LAYOUT_WRITE, struct.pack(">H", off) + blob[off:off + chunk])
+            for off in range(0, len(blob), chunk)]
+    failed = s.send_pipelined(cmds)
+    if failed:
+        print(f"[!] {failed} chunk(s) not acknowledged – not applying")
+        return
+    s.send(CMD_LAYOUT_APPLY, struct.pack(">H", len(blob)))
+    time.sleep(0.3)
+
+def upload_resource(s: HostSession, res_id: int, res_type: int, data: bytes,
+                    chunk: int = 123, window: int = 8):
+    """Bulk-transfer one resource: open, pipelined chunks, commit."""
+    print(f"\n--- BULK res={res_id} type={res_type} {len(data)} bytes ---")
+    seq = s.send(CMD_BULK_OPEN, struct.pack(">BBIH", res_id, res_type, len(data),
+                                            crc16_ccitt(data)))
+    ack = s.wait_ack(seq)
+    if ack and len(ack) >= 2:           # device's max_chunk, at v2 sizes too
+        chunk = min(struct.unpack(">H", ack[:2])[0], s.max_payload - 5)
+    s.send(CMD_SET_ACK_MODE, bytes([ACK_MODE_CUMULATIVE]))
+    time.sleep(0.1)
+    cmds = [(CMD_BULK_CHUNK, struct.pack(">BI", res_id, off) + data[off:off + chunk])
+            for off in range(0, len(data), chunk)]
+    t0 = time.monotonic()
+    failed = s.send_pipelined(cmds, window=window)
+    dt = time.monotonic() - t0
+    s.send(CMD_SET_ACK_MODE, bytes([ACK_MODE_EACH]))
+    time.sleep(0.1)
+    if failed:
+        print(f"[!] {failed} chunk(s) not acknowledged – aborting")
+        s.send(CMD_BULK_ABORT, bytes([res_id]))
+        return
+    print(f"[+] {len(data)} bytes in {dt * 1000:.1f} ms "
+          f"({len(data) / max(dt, 1e-6) / 1024:.1f} KiB/s)")
+    s.send(CMD_BULK_COMMIT, bytes([res_id]))
+    time.sleep(0.2)
+
 def test_crc_error(s: HostSession):
     """Send a frame with a deliberate CRC error – device must drop it gracefully."""
     print("\n--- CRC ERROR TEST (expect no crash, may get NACK) ---")
-    frame = bytearray(build_frame(CMD_PING, 0xFF))
+    frame = bytearray(build_frame(CMD_PING, 0xFF, b"", s.version, s.address))
     frame[-1] ^= 0xFF  # corrupt last CRC byte
     print(f"     raw: {bytes(frame).hex(' ')}")
     if s._ser:
@@ -265,20 +624,36 @@ def run_all_tests(s: HostSession):
     test_show_page(s, 1)
     test_set_text(s, 0, "Remote text!")
     test_set_value(s, 4, 42)
+    test_set_values(s)
+    test_strings(s)
+    test_state_hash(s)
+    test_batch(s)
+    test_pipelined(s)
     test_crc_error(s)
+    test_get_stats(s)
     print("\n[+] All tests sent.")
 
 # ── CLI ─────────────────────────────────────────────────────────────────────
 
 def main():
     parser = argparse.ArgumentParser(description="hmic host tester")
-    parser.add_argument("--port",     help="Serial port (e.g. /dev/ttyUSB0)")
+    parser.add_argument("--port",     help="Serial port (e.g. /dev/ttyUSB0) or socket://host:port")
     parser.add_argument("--baud",     type=int, default=115200)
     parser.add_argument("--loopback", action="store_true",
                         help="Run in loopback mode without serial hardware")
     parser.add_argument("--test",     choices=["all", "ping", "version",
-                                               "page", "text", "value", "crc"],
+                                               "page", "text", "value", "values",
+                                               "strings", "state", "batch", "pipeline",
+                                               "crc", "stats", "trace"],
                         help="Run a specific test suite")
+    parser.add_argument("--layout",   metavar="FILE",
+                        help="Upload and apply a binary layout (layout_tool.py -o)")
+    parser.add_argument("--image",    metavar="ID:FILE",
+                        help="Bulk-transfer an LVGL binary image as resource ID")
+    parser.add_argument("--v2",       action="store_true",
+                        help="Negotiate v2 framing and larger payloads first")
+    parser.add_argument("--addr",     type=int, metavar="N",
+                        help="Address panel N (1-254) on a multi-drop RS485 bus")
     args = parser.parse_args()
 
     port = None if args.loopback else args.port
@@ -287,9 +662,19 @@ def main():
         sys.exit(1)
 
     session = HostSession(port, args.baud)
+    session.address = args.addr
     session.start_rx()
 
     try:
+        if args.v2:
+            session.negotiate()
+        if args.layout:
+            with open(args.layout, "rb") as f:
+                upload_layout(session, f.read())
+        if args.image:
+            res_id, path = args.image.split(":", 1)
+            with open(path, "rb") as f:
+                upload_resource(session, int(res_id), RES_TYPE_IMAGE, f.read())
         if args.test == "all":
             run_all_tests(session)
         elif args.test == "ping":
@@ -302,12 +687,26 @@ def main():
             test_set_text(session)
         elif args.test == "value":
             test_set_value(session)
+        elif args.test == "values":
+            test_set_values(session)
+        elif args.test == "strings":
+            test_strings(session)
+        elif args.test == "state":
+            test_state_hash(session)
+        elif args.test == "batch":
+            test_batch(session)
+        elif args.test == "pipeline":
+            test_pipelined(session)
         elif args.test == "crc":
             test_crc_error(session)
+        elif args.test == "stats":
+            test_get_stats(session)
+        elif args.test == "trace":
+            dump_trace(session)
         else:
             # Interactive mode
             print("\nInteractive mode. Commands: ping, version, page <n>, "
-                  "text <widget> <msg>, value <widget> <val>, crc, quit")
+                  "text <widget> <msg>, value <widget> <val>, bpage <n>, stats, trace, crc, quit")
             while True:
                 try:
                     line = input("> ").strip()
@@ -325,12 +724,20 @@ def main():
                     test_get_version(session)
                 elif cmd == "page" and len(parts) > 1:
                     test_show_page(session, int(parts[1]))
+                elif cmd == "bpage" and len(parts) > 1:
+                    # Every panel on the bus switches; none answers.
+                    session.send(CMD_SHOW_PAGE, bytes([int(parts[1])]),
+                                 address=ADDR_BROADCAST)
                 elif cmd == "text" and len(parts) > 2:
                     test_set_text(session, int(parts[1]), parts[2])
                 elif cmd == "value" and len(parts) > 2:
                     test_set_value(session, int(parts[1]), int(parts[2]))
                 elif cmd == "crc":
                     test_crc_error(session)
+                elif cmd == "stats":
+                    test_get_stats(session)
+                elif cmd == "trace":
+                    dump_trace(session)
                 else:
                     print("Unknown command.")
 
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+hmic Layout Tool
+================
+Compiles a JSON page description into the binary layout format read by
+app/ui/ui_pages.c (see docs/protocol_spec.md §8) and checks it the same
+way the device does, so a layout that passes here loads on the panel.
+
+Usage:
+  python3 layout_tool.py layout.json -o layout.bin          # blob for upload / flash
+  python3 layout_tool.py layout.json --c-array ui_layout_default > ui_layout_default.c
+  python3 layout_tool.py layout.json --map                  # print widget_idx table
+
+JSON shape:
+  { "pages": [ { "name": "home",
+                 "widgets": [ { "id": "title", "type": "label",
+                                "parent": "<id on same page>",   (optional)
+                                "align": "top_mid", "x": 0, "y": 16,
+                                "w": 0, "h": 0,                  (0 = default size)
+                                "text": "Hello",
+                                "value": 0, "min": 0, "max": 100, (sliders)
+                                "resource": 3,                   (images)
+                                "hidden": false, "disabled": false,
+                                "events": true } ] } ] }
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+# ── Format constants (keep in sync with app/ui/ui_layout.h) ────────────────
+
+LAYOUT_MAGIC       = b"HL"
+LAYOUT_VERSION     = 1
+LAYOUT_HEADER_SIZE = 8
+LAYOUT_RECORD_SIZE = 20
+LAYOUT_NO_PARENT   = 0xFF
+LAYOUT_NO_TEXT     = 0xFFFF
+
+FLAG_HIDDEN   = 0x01
+FLAG_DISABLED = 0x02
+FLAG_EVENTS   = 0x04
+
+TYPES = {"label": 0, "slider": 1, "button": 2, "panel": 3, "image": 4}
+
+# lv_align_t values (LVGL v9)
+ALIGNS = {
+    "default": 0, "top_left": 1, "top_mid": 2, "top_right": 3,
+    "bottom_left": 4, "bottom_mid": 5, "bottom_right": 6,
+    "left_mid": 7, "right_mid": 8, "center": 9,
+    "out_top_left": 10, "out_top_mid": 11, "out_top_right": 12,
+    "out_bottom_left": 13, "out_bottom_mid": 14, "out_bottom_right": 15,
+    "out_left_top": 16, "out_left_mid": 17, "out_left_bottom": 18,
+    "out_right_top": 19, "out_right_mid": 20, "out_right_bottom": 21,
+}
+
+# Device limits (core/dm_config.h defaults – override with --max-*)
+DEFAULT_MAX_PAGES   = 8
+DEFAULT_MAX_WIDGETS = 64
+DEFAULT_MAX_SIZE    = 2048
+DEFAULT_MAX_TEXT    = 64
+
+# ── CRC16-CCITT ────────────────────────────────────────────────────────────
+
+def crc16_ccitt(data: bytes) -> int:
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = (crc << 1) ^ 0x1021
+            else:
+                crc <<= 1
+            crc &= 0xFFFF
+    return crc
+
+# ── Compiler ────────────────────────────────────────────────────────────────
+
+class LayoutError(Exception):
+    pass
+
+def _i16(w: dict, key: str, where: str) -> int:
+    v = int(w.get(key, 0))
+    if not -32768 <= v <= 32767:
+        raise LayoutError(f"{where}: '{key}' out of int16 range")
+    return v
+
+def compile_layout(doc: dict, max_pages: int = DEFAULT_MAX_PAGES,
+                   max_widgets: int = DEFAULT_MAX_WIDGETS,
+                   max_size: int = DEFAULT_MAX_SIZE,
+                   max_text: int = DEFAULT_MAX_TEXT):
+    """Return (blob, index_map) where index_map is [(idx, page, id)]."""
+    pages = doc.get("pages", [])
+    if not 1 <= len(pages) <= max_pages:
+        raise LayoutError(f"need 1..{max_pages} pages, got {len(pages)}")
+
+    page_table = bytearray()
+    records    = bytearray()
+    pool       = bytearray()
+    pool_index = {}
+    index_map  = []
+    idx        = 0
+
+    for p_num, page in enumerate(pages):
+        widgets = page.get("widgets", [])
+        if len(widgets) > 255:
+            raise LayoutError(f"page {p_num}: more than 255 widgets")
+        page_table.append(len(widgets))
+        local_ids = {}
+
+        for local, w in enumerate(widgets):
+            where = f"page {p_num} widget {local} ({w.get('id', '?')})"
+            wtype = TYPES.get(w.get("type"))
+            if wtype is None:
+                raise LayoutError(f"{where}: unknown type {w.get('type')!r}")
+            align = ALIGNS.get(w.get("align", "default"))
+            if align is None:
+                raise LayoutError(f"{where}: unknown align {w.get('align')!r}")
+
+            parent = LAYOUT_NO_PARENT
+            if "parent" in w:
+                if w["parent"] not in local_ids:
+                    raise LayoutError(f"{where}: parent must be an earlier "
+                                      f"widget on the same page")
+                parent = local_ids[w["parent"]]
+
+            flags = 0
+            if w.get("hidden"):   flags |= FLAG_HIDDEN
+            if w.get("disabled"): flags |= FLAG_DISABLED
+            if w.get("events"):   flags |= FLAG_EVENTS
+
+            text_off = LAYOUT_NO_TEXT
+            if "text" in w:
+                raw = w["text"].encode("utf-8")
+                if len(raw) >= max_text:
+                    raise LayoutError(f"{where}: text longer than {max_text - 1} bytes")
+                if raw not in pool_index:
+                    pool_index[raw] = len(pool)
+                    pool += raw + b"\0"
+                text_off = pool_index[raw]
+
+            value = _i16(w, "value", where)
+            if wtype == TYPES["image"]:
+                value = int(w.get("resource", 0))
+                if not 0 <= value < 256:
+                    raise LayoutError(f"{where}: resource id must be 0..255")
+            lo = _i16(w, "min", where)
+            hi = _i16(w, "max", where) if "max" in w else 100   # LVGL default
+            if wtype == TYPES["slider"] and lo >= hi:
+                raise LayoutError(f"{where}: min must be below max")
+            records += struct.pack(">BBBBhhhhhhhH", wtype, parent, align, flags,
+                                   _i16(w, "x", where), _i16(w, "y", where),
+                                   _i16(w, "w", where), _i16(w, "h", where),
+                                   value, lo, hi, text_off)
+
+            if "id" in w:
+                if w["id"] in local_ids:
+                    raise LayoutError(f"{where}: duplicate id")
+                local_ids[w["id"]] = local
+            index_map.append((idx, p_num, w.get("id", "")))
+            idx += 1
+
+    if idx > max_widgets:
+        raise LayoutError(f"{idx} widgets exceed the device limit of {max_widgets}")
+    if len(pool) > 0xFFFE:
+        raise LayoutError("string pool too large")
+
+    body   = bytes(page_table + records + pool)
+    header = LAYOUT_MAGIC + bytes([LAYOUT_VERSION, len(pages), idx, 0])
+    blob   = header + struct.pack(">H", crc16_ccitt(body)) + body
+    if len(blob) > max_size:
+        raise LayoutError(f"layout is {len(blob)} bytes, device buffer is {max_size}")
+    return blob, index_map
+
+def c_array(blob: bytes, name: str, source: str) -> str:
+    lines = [
+        "/**",
+        f" * @file {name}.c",
+        f" * @brief Built-in page layout (generated from {source}).",
+        " *",
+        " * Do not edit: regenerate with",
+        f" *   python3 tools/layout_tool.py {source} --c-array {name}",
+        " */",
+        '#include "ui_layout.h"',
+        "",
+        f"const uint8_t {name}[] = {{",
+    ]
+    for i in range(0, len(blob), 12):
+        chunk = ", ".join(f"0x{b:02X}" for b in blob[i:i + 12])
+        lines.append(f"    {chunk},")
+    lines += ["};", "", f"const uint16_t {name}_size = sizeof({name});", ""]
+    return "\n".join(lines)
+
+# ── CLI ─────────────────────────────────────────────────────────────────────
+
+def main():
+    parser = argparse.ArgumentParser(description="hmic layout compiler")
+    parser.add_argument("layout", help="JSON layout description")
+    parser.add_argument("-o", "--output", help="Write the binary blob here")
+    parser.add_argument("--c-array", metavar="NAME",
+                        help="Print the blob as a C source file defining NAME")
+    parser.add_argument("--map", action="store_true",
+                        help="Print the widget_idx assignment")
+    parser.add_argument("--max-pages",   type=int, default=DEFAULT_MAX_PAGES)
+    parser.add_argument("--max-widgets", type=int, default=DEFAULT_MAX_WIDGETS)
+    parser.add_argument("--max-size",    type=int, default=DEFAULT_MAX_SIZE)
+    parser.add_argument("--max-text",    type=int, default=DEFAULT_MAX_TEXT)
+    args = parser.parse_args()
+
+    with open(args.layout) as f:
+        doc = json.load(f)
+    try:
+        blob, index_map = compile_layout(doc, args.max_pages, args.max_widgets,
+                                         args.max_size, args.max_text)
+    except LayoutError as e:
+        print(f"[!] {args.layout}: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+        print(f"[+] {args.output}: {len(blob)} bytes, {len(index_map)} widgets",
+              file=sys.stderr)
+    if args.c_array:
+        print(c_array(blob, args.c_array, args.layout), end="")
+    if args.map:
+        for idx, page, wid in index_map:
+            print(f"  widget_idx {idx:3d}  page {page}  {wid}")
+
+if __name__ == "__main__":
+    main()